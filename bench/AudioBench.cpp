@@ -0,0 +1,53 @@
+// The audio feedback oscillator, with the tone changing on every buffer as
+// it does while the current moves.
+//
+// audio.readData operations are frames rendered in 20 ms buffers;
+// realtime is how many times faster than playback that is.
+
+#include "AudioGenerator.h"
+#include "Bench.h"
+
+#include <QAudioFormat>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr int kSampleRate = 48000;
+constexpr int kBufferFrames = kSampleRate / 50;
+constexpr int kBuffers = 50;
+
+void benchFormat(Bench &bench, const std::string &name, QAudioFormat::SampleFormat sampleFormat,
+                 int channels) {
+  if (!bench.selected(name)) {
+    return;
+  }
+  QAudioFormat format;
+  format.setSampleRate(kSampleRate);
+  format.setChannelCount(channels);
+  format.setSampleFormat(sampleFormat);
+  AudioGenerator generator(format);
+  generator.start();
+
+  std::vector<char> buffer(static_cast<std::size_t>(kBufferFrames) *
+                           static_cast<std::size_t>(format.bytesPerFrame()));
+  int step = 0;
+  const double seconds = bench.secondsPerRun([&] {
+    for (int i = 0; i < kBuffers; ++i) {
+      ++step;
+      generator.setFrequency(400.0 + (step % 64) * 10.0);
+      generator.setAmplitude(0.2 + (step % 8) * 0.1);
+      generator.readData(buffer.data(), static_cast<qint64>(buffer.size()));
+    }
+    benchConsume(static_cast<double>(buffer[buffer.size() / 2]));
+  });
+  const double frames = static_cast<double>(kBufferFrames) * kBuffers;
+  bench.report(name, static_cast<std::uint64_t>(channels), frames, seconds,
+               {{"realtime", frames / seconds / kSampleRate}});
+}
+} // namespace
+
+void runAudioBench(Bench &bench) {
+  benchFormat(bench, "audio.readData/int16-stereo", QAudioFormat::Int16, 2);
+  benchFormat(bench, "audio.readData/float-mono", QAudioFormat::Float, 1);
+  benchFormat(bench, "audio.readData/float-stereo", QAudioFormat::Float, 2);
+}
@@ -0,0 +1,76 @@
+#include "Bench.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace {
+volatile double consumed = 0.0;
+
+// Names are plain identifiers and paths, so only quotes and backslashes
+// need escaping
+std::string jsonString(const std::string &text) {
+  std::string quoted = "\"";
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + '"';
+}
+
+std::string jsonNumber(double value) {
+  if (!std::isfinite(value)) {
+    return "null";
+  }
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+  return buffer;
+}
+} // namespace
+
+void benchConsume(double value) { consumed = consumed + value; }
+
+void Bench::report(const std::string &name, std::uint64_t size, double ops,
+                   double seconds, Extras extras) {
+  if (!selected(name)) {
+    return;
+  }
+  const double nsPerOp = seconds * 1e9 / ops;
+  const double opsPerSecond = ops / seconds;
+  if (m_format == Format::Json) {
+    std::string line = "{\"name\":" + jsonString(name) +
+                       ",\"size\":" + std::to_string(size) +
+                       ",\"ns_per_op\":" + jsonNumber(nsPerOp) +
+                       ",\"ops_per_s\":" + jsonNumber(opsPerSecond);
+    for (const auto &[key, value] : extras) {
+      line += ',' + jsonString(key) + ':' + jsonNumber(value);
+    }
+    std::printf("%s}\n", line.c_str());
+  } else {
+    std::printf("%-40s %10llu %12.1f %14.0f", name.c_str(),
+                static_cast<unsigned long long>(size), nsPerOp, opsPerSecond);
+    for (const auto &[key, value] : extras) {
+      std::printf("  %s=%.4g", key.c_str(), value);
+    }
+    std::printf("\n");
+  }
+  std::fflush(stdout);
+}
+
+void Bench::fail(const std::string &name, const std::string &message) {
+  m_failed = true;
+  if (m_format == Format::Json) {
+    std::printf("{\"name\":%s,\"error\":%s}\n", jsonString(name).c_str(),
+                jsonString(message).c_str());
+  } else {
+    std::printf("%-40s FAILED: %s\n", name.c_str(), message.c_str());
+  }
+  std::fflush(stdout);
+}
+
+void Bench::printHeader() const {
+  if (m_format == Format::Text) {
+    std::printf("%-40s %10s %12s %14s\n", "benchmark", "size", "ns/op", "ops/s");
+  }
+}
@@ -0,0 +1,82 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Times the benchmarks and prints one result per line, either as a table
+// or as JSON lines for tools that track regressions between builds. Every
+// result has the time per operation and operations per second; what an
+// operation is (a sample, a query, a frame) is part of its name's
+// documentation in the suite.
+class Bench {
+public:
+  enum class Format { Text, Json };
+  // Additional figures of a result, e.g. {"mb_per_s", 512.0}
+  using Extras = std::vector<std::pair<std::string, double>>;
+
+  Bench(Format format, std::string filter, double minSeconds)
+      : m_format(format), m_filter(std::move(filter)), m_minSeconds(minSeconds) {}
+
+  // Whether a result of that name is wanted (--filter)
+  [[nodiscard]] bool selected(const std::string &name) const {
+    return m_filter.empty() || name.find(m_filter) != std::string::npos;
+  }
+
+  // Average duration of run(), repeated for at least the minimum time
+  template <typename F> double secondsPerRun(F &&run) const {
+    using Clock = std::chrono::steady_clock;
+    std::size_t runs = 0;
+    const auto start = Clock::now();
+    std::chrono::duration<double> elapsed{};
+    do {
+      run();
+      ++runs;
+      elapsed = Clock::now() - start;
+    } while (elapsed.count() < m_minSeconds);
+    return elapsed.count() / static_cast<double>(runs);
+  }
+
+  // Times run(), which performs ops operations, and reports it; size is the
+  // problem size (e.g. the history capacity), 0 if there is none
+  template <typename F>
+  void measure(const std::string &name, std::uint64_t size, double ops, F &&run,
+               Extras extras = {}) {
+    if (!selected(name)) {
+      return;
+    }
+    report(name, size, ops, secondsPerRun(run), std::move(extras));
+  }
+
+  // A measurement taken by the caller: ops operations in seconds
+  void report(const std::string &name, std::uint64_t size, double ops,
+              double seconds, Extras extras = {});
+  // Something that could not be measured; makes the run fail
+  void fail(const std::string &name, const std::string &message);
+
+  void printHeader() const;
+  [[nodiscard]] bool failed() const { return m_failed; }
+
+private:
+  Format m_format;
+  std::string m_filter;
+  double m_minSeconds;
+  bool m_failed = false;
+};
+
+// Keeps the compiler from dropping computations whose results are unused
+void benchConsume(double value);
+
+// The suites, in Bench*.cpp
+void runHistoryBench(Bench &bench, std::size_t maxCapacity);
+void runDecoderBench(Bench &bench);
+void runCodecBench(Bench &bench);
+void runGraphBench(Bench &bench);
+void runAudioBench(Bench &bench);
+// Recordings (.upr) and raw captures (.upc) given on the command line
+void runFileBench(Bench &bench, const std::string &path);
+
+#endif // BENCH_H
@@ -0,0 +1,70 @@
+// Benchmarks of the hot paths: history and statistics, the decoders, the
+// recording codec, graph rendering and the audio oscillator.
+//
+//   usb-power-osd-bench [--json] [--filter <text>] [--min-time <seconds>]
+//                       [--max-history <samples>] [recording.upr | capture.upc ...]
+//
+// --json prints one JSON object per result for tools that compare builds;
+// --filter runs the benchmarks whose name contains the text. Files given
+// on the command line are measured instead of the synthetic benchmarks.
+
+#include "Bench.h"
+
+#include <QApplication>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[]) {
+  Bench::Format format = Bench::Format::Text;
+  std::string filter;
+  double minSeconds = 0.5;
+  std::size_t maxHistory = 10000000;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--json") == 0) {
+      format = Bench::Format::Json;
+    } else if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+      filter = argv[++i];
+    } else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+      minSeconds = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--max-history") == 0 && hasValue) {
+      maxHistory = std::strtoull(argv[++i], nullptr, 10);
+    } else if (argv[i][0] == '-') {
+      std::fprintf(stderr,
+                   "usage: %s [--json] [--filter <text>] [--min-time <seconds>] "
+                   "[--max-history <samples>] [recording.upr | capture.upc ...]\n",
+                   argv[0]);
+      return 2;
+    } else {
+      files.emplace_back(argv[i]);
+    }
+  }
+
+  // The graph is painted without a display
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  QApplication app(argc, argv);
+  // QApplication adopts the user's locale, which would put decimal commas
+  // into the output
+  std::setlocale(LC_NUMERIC, "C");
+
+  Bench bench(format, filter, minSeconds);
+  bench.printHeader();
+  if (files.empty()) {
+    runHistoryBench(bench, maxHistory);
+    runDecoderBench(bench);
+    runCodecBench(bench);
+    runGraphBench(bench);
+    runAudioBench(bench);
+  }
+  for (const std::string &file : files) {
+    runFileBench(bench, file);
+  }
+  return bench.failed() ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+// The per-sample work before anything is stored: the serial line decoder,
+// the BLE JSON parser and the PD level classification.
+//
+// serial.feed operations are lines, fed in 64-byte reads as a USB serial
+// port delivers them, with mb_per_s over the bytes; serial.decodeLine is
+// one complete line. ble.decode is one notification, pd.getEnum one call.
+
+#include "Bench.h"
+#include "BleDecoder.h"
+#include "PowerDelivery.h"
+#include "SerialDecoder.h"
+
+#include <QByteArray>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr std::size_t kLineCount = 1 << 16;
+constexpr std::size_t kReadBytes = 64;
+constexpr std::size_t kNotificationCount = 1 << 12;
+constexpr std::size_t kVoltageCount = 1 << 16;
+
+// PLD28 lines: signed shunt and bus voltage as four hex digits each, then
+// the protocol byte
+std::string serialStream(std::vector<std::size_t> &lineStarts) {
+  std::mt19937 rng(4);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::string stream;
+  char line[16];
+  for (std::size_t i = 0; i < kLineCount; ++i) {
+    const int shunt = std::clamp(7500 + static_cast<int>(noise(rng) * 40.0), 0, 0x7fff);
+    const int bus = 6400 + static_cast<int>(noise(rng) * 2.0);
+    std::snprintf(line, sizeof(line), "%04X%04X\x1c\r\n", shunt, bus);
+    lineStarts.push_back(stream.size());
+    stream += line;
+  }
+  return stream;
+}
+
+std::vector<QByteArray> bleNotifications() {
+  std::mt19937 rng(5);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::vector<QByteArray> notifications;
+  std::uint64_t timestamp = 1760000000000;
+  char json[160];
+  for (std::size_t i = 0; i < kNotificationCount; ++i) {
+    timestamp += 100;
+    const double voltage = 5.0 + noise(rng) * 0.005;
+    const double current = 0.9 + noise(rng) * 0.02;
+    std::snprintf(json, sizeof(json),
+                  "{\"voltage\":%.3f,\"current\":%.3f,\"power\":%.3f,"
+                  "\"charge\":%.3f,\"timestamp\":%llu}",
+                  voltage, current, voltage * current, i * 0.025,
+                  static_cast<unsigned long long>(timestamp));
+    notifications.emplace_back(json);
+  }
+  return notifications;
+}
+
+void benchSerial(Bench &bench) {
+  std::vector<std::size_t> lineStarts;
+  const std::string stream = serialStream(lineStarts);
+  const auto bytes = static_cast<double>(stream.size());
+
+  std::vector<PowerData> decoded;
+  decoded.reserve(kLineCount);
+  SerialDecoder decoder;
+  decoder.setProtocol(PLD28);
+  if (bench.selected("serial.feed")) {
+    const double seconds = bench.secondsPerRun([&] {
+      decoded.clear();
+      for (std::size_t offset = 0; offset < stream.size(); offset += kReadBytes) {
+        decoder.feed(stream.data() + offset, std::min(kReadBytes, stream.size() - offset),
+                     1760000000000, decoded);
+      }
+    });
+    if (decoded.size() != kLineCount || decoder.badLines() != 0) {
+      bench.fail("serial.feed", "decoded " + std::to_string(decoded.size()) + " of " +
+                                    std::to_string(kLineCount) + " lines");
+    } else {
+      bench.report("serial.feed", kLineCount, static_cast<double>(kLineCount), seconds,
+                   {{"mb_per_s", bytes / seconds / 1e6}});
+    }
+  }
+
+  bench.measure("serial.decodeLine", kLineCount, static_cast<double>(kLineCount), [&] {
+    PowerData sample;
+    double sum = 0.0;
+    for (const std::size_t start : lineStarts) {
+      // The line without its line break, as feed() hands it over
+      SerialDecoder::decodeLine(stream.data() + start, 9, PLD28, sample);
+      sum += sample.current;
+    }
+    benchConsume(sum);
+  });
+}
+
+void benchBle(Bench &bench) {
+  if (!bench.selected("ble.decode")) {
+    return;
+  }
+  const std::vector<QByteArray> notifications = bleNotifications();
+  double bytes = 0.0;
+  for (const QByteArray &notification : notifications) {
+    bytes += static_cast<double>(notification.size());
+  }
+  BleDecoder decoder;
+  const double seconds = bench.secondsPerRun([&] {
+    PowerData sample;
+    double sum = 0.0;
+    for (const QByteArray &notification : notifications) {
+      decoder.decode(notification, 0, sample);
+      sum += sample.power;
+    }
+    benchConsume(sum);
+  });
+  bench.report("ble.decode", kNotificationCount, static_cast<double>(kNotificationCount),
+               seconds, {{"mb_per_s", bytes / seconds / 1e6}});
+}
+
+void benchLevels(Bench &bench) {
+  // Uniform over the whole range, so every level and the gaps between
+  // them are hit
+  std::mt19937 rng(6);
+  std::uniform_real_distribution<float> volts(0.0f, 55.0f);
+  std::vector<float> voltages(kVoltageCount);
+  for (float &voltage : voltages) {
+    voltage = volts(rng);
+  }
+  auto classify = [&] {
+    unsigned sum = 0;
+    for (const float voltage : voltages) {
+      sum += PowerDelivery::getEnum(voltage);
+    }
+    benchConsume(sum);
+  };
+  bench.measure("pd.getEnum", kVoltageCount, static_cast<double>(kVoltageCount), classify);
+  if (bench.selected("pd.getEnum/bands")) {
+    // A PPS supply band as configured in the settings
+    PowerDelivery::setBands({{3300, 21000, PowerDelivery::PD_20V}});
+    bench.measure("pd.getEnum/bands", kVoltageCount, static_cast<double>(kVoltageCount),
+                  classify);
+    PowerDelivery::setBands({});
+  }
+}
+} // namespace
+
+void runDecoderBench(Bench &bench) {
+  benchSerial(bench);
+  benchBle(bench);
+  benchLevels(bench);
+}
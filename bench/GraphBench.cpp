@@ -0,0 +1,141 @@
+// The current graph on the offscreen platform, 800x300 over a history of
+// 100k samples.
+//
+// graph.columns.sync operations are samples pushed and folded into the
+// pixel columns; graph.render/full is a whole frame rasterized by the
+// worker, graph.render/scroll a frame that adds one column. graph.paint is
+// one paintEvent of the widget, graph.frame the time from handing a frame
+// to the renderer until it is painted (frames are paced by the display
+// refresh, so only their latency is meaningful).
+
+#include "Bench.h"
+#include "CurrentGraph.h"
+#include "GraphColumns.h"
+#include "GraphRenderer.h"
+#include "LatencyHistogram.h"
+#include "MeasurementHistory.h"
+#include "OsdSettings.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr int kWidth = 800;
+constexpr int kHeight = 300;
+constexpr std::size_t kHistorySize = 100000;
+constexpr int kFrames = 30;
+constexpr int kFrameTimeoutMs = 5000;
+
+// A load stepping between levels, with noise and short spikes
+void fill(MeasurementHistory &history, std::size_t count, std::uint64_t &timestamp) {
+  static std::mt19937 rng(7);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::uniform_int_distribution<int> spike(0, 999);
+  for (std::size_t i = 0; i < count; ++i) {
+    PowerData sample;
+    sample.voltage = 20.0 + noise(rng) * 0.004;
+    sample.current = (timestamp / 5000 % 2 == 0 ? 0.8 : 2.1) + noise(rng) * 0.01 +
+                     (spike(rng) == 0 ? 1.0 : 0.0);
+    sample.power = sample.voltage * sample.current;
+    sample.timestamp = ++timestamp;
+    history.push(sample);
+  }
+}
+
+GraphFrame makeFrame(const GraphColumns &columns, bool full, int count) {
+  GraphFrame frame;
+  frame.size = QSize(kWidth, kHeight);
+  frame.full = full;
+  frame.shifted = full ? 0 : 1;
+  frame.available = columns.columnCount();
+  frame.slots = columns.slotCount();
+  double minCurrent = 0.0;
+  double maxCurrent = 0.0;
+  columns.minMax(minCurrent, maxCurrent);
+  frame.minCurrent = minCurrent - 0.1;
+  frame.maxCurrent = maxCurrent + 0.1;
+  for (int age = 0; age < count; ++age) {
+    frame.columns.push_back(columns.atByAge(age));
+  }
+  for (std::size_t level = 0; level < frame.colors.size(); ++level) {
+    frame.colors[level] = QColor::fromHsv(static_cast<int>(level) * 45, 255, 255);
+  }
+  return frame;
+}
+
+// Processes events until the graph painted one more frame
+bool waitForFrame(const LatencyHistogram &latency, std::uint64_t painted) {
+  QElapsedTimer timer;
+  timer.start();
+  while (latency.snapshot().count <= painted) {
+    if (timer.elapsed() > kFrameTimeoutMs) {
+      return false;
+    }
+    QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+  }
+  return true;
+}
+
+void benchWidget(Bench &bench, MeasurementHistory &history, std::uint64_t &timestamp) {
+  if (!bench.selected("graph.paint") && !bench.selected("graph.frame")) {
+    return;
+  }
+  // Separate from the application's settings, and never saved
+  OsdSettings settings("MacWake", "USB Display Bench", nullptr);
+  LatencyHistogram latency;
+  CurrentGraph graph(nullptr, &history, &settings);
+  graph.setPaintLatency(&latency);
+  graph.resize(kWidth, kHeight);
+  graph.show();
+  graph.onHistoryChanged();
+  if (!waitForFrame(latency, 0)) {
+    bench.fail("graph.paint", "no frame was painted");
+    return;
+  }
+
+  QImage image(kWidth, kHeight, QImage::Format_RGB32);
+  bench.measure("graph.paint", kHistorySize, 1.0, [&] { graph.render(&image); });
+
+  if (bench.selected("graph.frame")) {
+    const LatencyHistogram::Snapshot before = latency.snapshot();
+    for (int i = 0; i < kFrames; ++i) {
+      fill(history, kHistorySize / kWidth, timestamp);
+      graph.onHistoryChanged();
+      if (!waitForFrame(latency, before.count + i)) {
+        bench.fail("graph.frame", "no frame was painted");
+        return;
+      }
+    }
+    const LatencyHistogram::Snapshot after = latency.snapshot();
+    bench.report("graph.frame", kHistorySize, static_cast<double>(after.count - before.count),
+                 static_cast<double>(after.sumNs - before.sumNs) / 1e9);
+  }
+}
+} // namespace
+
+void runGraphBench(Bench &bench) {
+  MeasurementHistory history(kHistorySize);
+  std::uint64_t timestamp = 1760000000000;
+  fill(history, kHistorySize, timestamp);
+
+  GraphColumns columns;
+  columns.sync(history, kWidth);
+  bench.measure("graph.columns.sync", kHistorySize, 1000.0, [&] {
+    for (int i = 0; i < 1000; ++i) {
+      fill(history, 1, timestamp);
+      columns.sync(history, kWidth);
+    }
+  });
+
+  GraphRenderer renderer;
+  const GraphFrame full = makeFrame(columns, true, columns.columnCount());
+  bench.measure("graph.render/full", kHistorySize, 1.0, [&] { renderer.render(full); });
+  const GraphFrame scroll = makeFrame(columns, false, 3);
+  renderer.render(full);
+  bench.measure("graph.render/scroll", kHistorySize, 1.0, [&] { renderer.render(scroll); });
+
+  benchWidget(bench, history, timestamp);
+}
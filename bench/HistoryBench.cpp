@@ -0,0 +1,160 @@
+// MeasurementHistory at capacities from 1k to 10M samples, always full as
+// in a long session.
+//
+// history.push operations are samples pushed, evicting the oldest;
+// history.push+minMaxCurrent is the ingest path of the acquisition core,
+// which reads the range after every push; /quantized feeds a steady load
+// flickering between two 1 mA codes, so the evicted sample keeps holding
+// the minimum or maximum. The queries cover the whole
+// history, one query per operation, with samples_per_s over the samples
+// they scan.
+
+#include "Bench.h"
+#include "MeasurementHistory.h"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace {
+// Pushed round-robin; enough variety that the extremes keep moving
+constexpr std::size_t kSampleCount = 1 << 16;
+
+const char *const kNames[] = {"history.push",
+                              "history.push+minMaxCurrent",
+                              "history.push+minMaxCurrent/quantized",
+                              "history.minMaxCurrentLastN",
+                              "history.maxValuesLastN",
+                              "history.medianValuesLastN",
+                              "history.getCurrentStdDev",
+                              "history.getCurrentStdDevLastN",
+                              "history.lastNSamplesNewestFirst"};
+
+std::vector<PowerData> makeSamples() {
+  std::mt19937 rng(3);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::vector<PowerData> samples(kSampleCount);
+  std::uint64_t timestamp = 1760000000000;
+  double current = 1.5;
+  for (auto &sample : samples) {
+    current = std::max(0.0, current + noise(rng) * 0.003);
+    sample.voltage = 20.0 + noise(rng) * 0.004;
+    sample.current = current;
+    sample.power = sample.voltage * sample.current;
+    sample.timestamp = ++timestamp;
+  }
+  return samples;
+}
+
+// As a meter reports a steady load: the same two readings over and over
+std::vector<PowerData> makeQuantizedSamples() {
+  std::mt19937 rng(8);
+  std::bernoulli_distribution flicker(0.5);
+  std::vector<PowerData> samples(kSampleCount);
+  std::uint64_t timestamp = 1760000000000;
+  for (auto &sample : samples) {
+    sample.voltage = 20.0;
+    sample.current = flicker(rng) ? 1.501 : 1.500;
+    sample.power = sample.voltage * sample.current;
+    sample.timestamp = ++timestamp;
+  }
+  return samples;
+}
+
+// Continues pushing samples round-robin from next
+void benchPushMinMax(Bench &bench, const char *name, MeasurementHistory &history,
+                     const std::vector<PowerData> &samples, std::size_t &next) {
+  bench.measure(name, history.capacity(), static_cast<double>(kSampleCount), [&] {
+    double minCurrent = 0.0;
+    double maxCurrent = 0.0;
+    for (std::size_t i = 0; i < kSampleCount; ++i) {
+      history.push(samples[next]);
+      next = (next + 1) % samples.size();
+      history.minMaxCurrent(minCurrent, maxCurrent);
+    }
+    benchConsume(minCurrent + maxCurrent);
+  });
+}
+
+void benchCapacity(Bench &bench, std::size_t capacity,
+                   const std::vector<PowerData> &samples,
+                   const std::vector<PowerData> &quantized) {
+  MeasurementHistory history(capacity);
+  std::size_t next = 0;
+  auto pushNext = [&] {
+    history.push(samples[next]);
+    next = (next + 1) % samples.size();
+  };
+  for (std::size_t i = 0; i < capacity; ++i) {
+    pushNext();
+  }
+
+  const auto size = static_cast<std::uint64_t>(capacity);
+  const auto scanned = static_cast<double>(capacity);
+  bench.measure("history.push", size, static_cast<double>(kSampleCount), [&] {
+    for (std::size_t i = 0; i < kSampleCount; ++i) {
+      pushNext();
+    }
+  });
+  benchPushMinMax(bench, "history.push+minMaxCurrent", history, samples, next);
+  if (bench.selected("history.push+minMaxCurrent/quantized")) {
+    MeasurementHistory plateau(capacity);
+    std::size_t plateauNext = 0;
+    for (std::size_t i = 0; i < capacity; ++i) {
+      plateau.push(quantized[plateauNext]);
+      plateauNext = (plateauNext + 1) % quantized.size();
+    }
+    benchPushMinMax(bench, "history.push+minMaxCurrent/quantized", plateau, quantized,
+                    plateauNext);
+  }
+
+  // Reports a whole-history query with the rate of samples it scans
+  auto query = [&](const char *name, auto &&run) {
+    if (!bench.selected(name)) {
+      return;
+    }
+    const double seconds = bench.secondsPerRun(run);
+    bench.report(name, size, 1.0, seconds, {{"samples_per_s", scanned / seconds}});
+  };
+  query("history.minMaxCurrentLastN", [&] {
+    double minCurrent = 0.0;
+    double maxCurrent = 0.0;
+    history.minMaxCurrentLastN(capacity, minCurrent, maxCurrent);
+    benchConsume(minCurrent + maxCurrent);
+  });
+  query("history.maxValuesLastN", [&] {
+    double voltage = 0.0;
+    double current = 0.0;
+    double power = 0.0;
+    (void)history.maxValuesLastN(capacity, voltage, current, power);
+    benchConsume(voltage + current + power);
+  });
+  query("history.medianValuesLastN", [&] {
+    double voltage = 0.0;
+    double current = 0.0;
+    double power = 0.0;
+    (void)history.medianValuesLastN(capacity, voltage, current, power);
+    benchConsume(voltage + current + power);
+  });
+  query("history.getCurrentStdDev", [&] { benchConsume(history.getCurrentStdDev()); });
+  query("history.getCurrentStdDevLastN",
+        [&] { benchConsume(history.getCurrentStdDevLastN(capacity)); });
+  query("history.lastNSamplesNewestFirst", [&] {
+    benchConsume(history.lastNSamplesNewestFirst(capacity).back().current);
+  });
+}
+} // namespace
+
+void runHistoryBench(Bench &bench, std::size_t maxCapacity) {
+  // Filling the larger histories takes a while, so not unless needed
+  if (std::none_of(std::begin(kNames), std::end(kNames),
+                   [&bench](const char *name) { return bench.selected(name); })) {
+    return;
+  }
+  const std::vector<PowerData> samples = makeSamples();
+  const std::vector<PowerData> quantized = makeQuantizedSamples();
+  for (std::size_t capacity = 1000; capacity <= maxCapacity; capacity *= 10) {
+    benchCapacity(bench, capacity, samples, quantized);
+  }
+}
@@ -0,0 +1,261 @@
+// Compression ratio and throughput of SampleCodec on synthetic meter data
+// or on the chunks of existing recordings, and decoding throughput of raw
+// captures given on the command line.
+//
+// codec.encode/codec.decode operations are samples; mb_per_s counts raw
+// samples (40 bytes each) in both directions, so the numbers compare
+// directly with the Raw encoding. Before measuring, every block must decode
+// to the same bits and damaged blocks must be handled (decodeCorrupted).
+// capture.decode operations are captured transport bytes.
+
+#include "Bench.h"
+#include "BleDecoder.h"
+#include "RawCaptureFormat.h"
+#include "RecordingFormat.h"
+#include "SampleCodec.h"
+#include "SerialDecoder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr std::size_t kBlockSamples = 4096;
+constexpr double kRawSampleBytes = 40.0;
+
+// PLD20/PLD28 over serial: whole mV and mA, power derived, no energy, and
+// the lines of one read share a millisecond timestamp
+std::vector<PowerData> serialSamples(std::size_t count) {
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::uniform_int_distribution<int> batch(1, 12);
+  std::vector<PowerData> samples(count);
+  std::uint64_t timestamp = 1760000000000;
+  double milliamps = 1500.0;
+  int inBatch = batch(rng);
+  for (auto &sample : samples) {
+    if (--inBatch == 0) {
+      timestamp += batch(rng);
+      inBatch = batch(rng);
+    }
+    milliamps += noise(rng) * 3.0;
+    if (milliamps < 0.0) {
+      milliamps = 0.0;
+    }
+    const int millivolts = 20000 + 4 * static_cast<int>(noise(rng));
+    sample.current = static_cast<int>(milliamps) / 1000.0;
+    sample.voltage = millivolts / 1000.0;
+    sample.power = sample.voltage * sample.current;
+    sample.timestamp = timestamp;
+  }
+  return samples;
+}
+
+// BLE meter: 10 Hz, power reported separately and energy accumulated
+std::vector<PowerData> bleSamples(std::size_t count) {
+  std::mt19937 rng(2);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::vector<PowerData> samples(count);
+  std::uint64_t timestamp = 1760000000000;
+  double energy = 0.0;
+  for (auto &sample : samples) {
+    timestamp += 100;
+    sample.voltage = (5000 + static_cast<int>(noise(rng) * 5.0)) / 1000.0;
+    sample.current = (900 + static_cast<int>(noise(rng) * 20.0)) / 1000.0;
+    sample.power =
+        static_cast<int>(sample.voltage * sample.current * 1000.0) / 1000.0;
+    energy += sample.power * (0.1 / 3600.0);
+    sample.energy = energy;
+    sample.timestamp = timestamp;
+  }
+  return samples;
+}
+
+bool sameBits(const PowerData &a, const PowerData &b) {
+  return a.timestamp == b.timestamp &&
+         std::memcmp(&a.voltage, &b.voltage, sizeof(double)) == 0 &&
+         std::memcmp(&a.current, &b.current, sizeof(double)) == 0 &&
+         std::memcmp(&a.power, &b.power, sizeof(double)) == 0 &&
+         std::memcmp(&a.energy, &b.energy, sizeof(double)) == 0;
+}
+
+// Damaged blocks, as a crash leaves them in a recording, must be rejected
+// or decode to something, never read out of bounds or overflow (build
+// with -fsanitize=address,undefined to check the latter). Truncated ones
+// are always short of a section; false if one of them decodes.
+bool decodeCorrupted(const PowerData *samples, std::size_t count) {
+  std::vector<unsigned char> block;
+  SampleCodec::encode(samples, count, block);
+  std::vector<PowerData> decoded;
+  for (std::size_t size = 0; size < block.size(); ++size) {
+    if (SampleCodec::decode(block.data(), size, decoded)) {
+      return false;
+    }
+  }
+  for (std::size_t bit = 0; bit < block.size() * 8; ++bit) {
+    block[bit / 8] ^= static_cast<unsigned char>(1u << (bit % 8));
+    SampleCodec::decode(block.data(), block.size(), decoded);
+    block[bit / 8] ^= static_cast<unsigned char>(1u << (bit % 8));
+  }
+  return true;
+}
+
+void benchCodec(Bench &bench, const std::string &name,
+                const std::vector<PowerData> &samples) {
+  if (!bench.selected("codec.encode/" + name) && !bench.selected("codec.decode/" + name)) {
+    return;
+  }
+  std::vector<std::vector<unsigned char>> blocks;
+  for (std::size_t i = 0; i < samples.size(); i += kBlockSamples) {
+    blocks.emplace_back();
+    SampleCodec::encode(samples.data() + i,
+                        std::min(kBlockSamples, samples.size() - i), blocks.back());
+  }
+  std::size_t encodedBytes = 0;
+  std::vector<PowerData> decoded;
+  for (std::size_t b = 0; b < blocks.size(); ++b) {
+    encodedBytes += blocks[b].size();
+    if (!SampleCodec::decode(blocks[b].data(), blocks[b].size(), decoded)) {
+      bench.fail("codec.decode/" + name, "block " + std::to_string(b) + " does not decode");
+      return;
+    }
+    for (std::size_t i = 0; i < decoded.size(); ++i) {
+      if (!sameBits(decoded[i], samples[b * kBlockSamples + i])) {
+        bench.fail("codec.decode/" + name,
+                   "sample " + std::to_string(b * kBlockSamples + i) +
+                       " differs after decoding");
+        return;
+      }
+    }
+  }
+  if (!decodeCorrupted(samples.data(), std::min<std::size_t>(samples.size(), 256))) {
+    bench.fail("codec.decode/" + name, "a truncated block decodes");
+    return;
+  }
+
+  std::vector<unsigned char> scratch;
+  const double encodeSeconds = bench.secondsPerRun([&] {
+    for (std::size_t i = 0; i < samples.size(); i += kBlockSamples) {
+      SampleCodec::encode(samples.data() + i,
+                          std::min(kBlockSamples, samples.size() - i), scratch);
+    }
+  });
+  const double decodeSeconds = bench.secondsPerRun([&] {
+    for (const auto &block : blocks) {
+      SampleCodec::decode(block.data(), block.size(), decoded);
+    }
+  });
+
+  const auto count = static_cast<double>(samples.size());
+  const double rawBytes = kRawSampleBytes * count;
+  const Bench::Extras ratio = {
+      {"bits_per_sample", static_cast<double>(encodedBytes) * 8.0 / count},
+      {"ratio", rawBytes / static_cast<double>(encodedBytes)}};
+  Bench::Extras encodeExtras = ratio;
+  encodeExtras.emplace_back("mb_per_s", rawBytes / encodeSeconds / 1e6);
+  Bench::Extras decodeExtras = ratio;
+  decodeExtras.emplace_back("mb_per_s", rawBytes / decodeSeconds / 1e6);
+  bench.report("codec.encode/" + name, samples.size(), count, encodeSeconds,
+               encodeExtras);
+  bench.report("codec.decode/" + name, samples.size(), count, decodeSeconds,
+               decodeExtras);
+}
+
+bool loadRecording(Bench &bench, const std::string &path,
+                   std::vector<PowerData> &samples) {
+  RecordingReader reader;
+  std::string error;
+  if (!reader.open(path, &error)) {
+    bench.fail("codec.decode/" + path, error);
+    return false;
+  }
+  std::vector<PowerData> chunk;
+  for (std::size_t i = 0; i < reader.chunks().size(); ++i) {
+    if (!reader.readChunk(i, chunk)) {
+      bench.fail("codec.decode/" + path, "chunk " + std::to_string(i) + " is unreadable");
+      return false;
+    }
+    samples.insert(samples.end(), chunk.begin(), chunk.end());
+  }
+  return !samples.empty();
+}
+
+// Decodes a capture as a replay does and reports the decoder throughput
+void benchCapture(Bench &bench, const std::string &path) {
+  const std::string name = "capture.decode/" + path;
+  RawCaptureReader reader;
+  std::string error;
+  if (!reader.open(path, &error)) {
+    bench.fail(name, error);
+    return;
+  }
+  std::uint64_t bytes = 0;
+  std::uint64_t samples = 0;
+  std::uint64_t badLines = 0;
+  std::uint64_t badNotifications = 0;
+  const double seconds = bench.secondsPerRun([&] {
+    SerialDecoder serial;
+    BleDecoder ble;
+    std::vector<PowerData> decoded;
+    RawCaptureRecord record;
+    bytes = samples = badNotifications = 0;
+    reader.rewind();
+    while (reader.next(record)) {
+      const char *data = reinterpret_cast<const char *>(record.data);
+      if (record.type == CaptureRecordType::Connected) {
+        const std::string source(data, record.size);
+        SerialProtocol protocol;
+        if (record.source == CaptureSource::Serial &&
+            SerialDecoder::protocolFromName(source.substr(0, source.find('\t')),
+                                            protocol)) {
+          serial.setProtocol(protocol);
+          serial.reset();
+        }
+        continue;
+      }
+      bytes += record.size;
+      decoded.clear();
+      if (record.source == CaptureSource::Serial) {
+        serial.feed(data, record.size, record.timestampUs / 1000, decoded);
+      } else {
+        PowerData sample;
+        if (ble.decode(QByteArray::fromRawData(data, static_cast<int>(record.size)),
+                       record.timestampUs / 1000, sample)) {
+          decoded.push_back(sample);
+        } else {
+          ++badNotifications;
+        }
+      }
+      samples += decoded.size();
+    }
+    badLines = serial.badLines();
+  });
+  if (reader.truncated()) {
+    std::fprintf(stderr, "%s is truncated\n", path.c_str());
+  }
+  bench.report(name, bytes, static_cast<double>(bytes), seconds,
+               {{"samples", static_cast<double>(samples)},
+                {"bad_lines", static_cast<double>(badLines)},
+                {"bad_notifications", static_cast<double>(badNotifications)},
+                {"mb_per_s", static_cast<double>(bytes) / seconds / 1e6}});
+}
+} // namespace
+
+void runCodecBench(Bench &bench) {
+  benchCodec(bench, "serial", serialSamples(1 << 20));
+  benchCodec(bench, "ble", bleSamples(1 << 20));
+}
+
+void runFileBench(Bench &bench, const std::string &path) {
+  if (RawCaptureReader::isCapture(path)) {
+    benchCapture(bench, path);
+    return;
+  }
+  std::vector<PowerData> samples;
+  if (loadRecording(bench, path, samples)) {
+    benchCodec(bench, path, samples);
+  }
+}
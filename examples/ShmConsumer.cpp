@@ -0,0 +1,93 @@
+// Follows the shared-memory sample ring of a running usb-power-osd and
+// prints a line per second, or every sample as CSV with --csv.
+//
+//   usb-power-shm-consumer [--csv] [--from-oldest] [name]
+
+#include "SharedRingReader.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+// How long to sleep when the ring had nothing new; a harness that needs
+// lower latency can spin on writeIndex() instead
+constexpr auto kPollInterval = std::chrono::milliseconds(5);
+
+volatile std::sig_atomic_t quitRequested = 0;
+
+void requestQuit(int) { quitRequested = 1; }
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bool csv = false;
+  bool fromOldest = false;
+  std::string name = kSharedRingDefaultName;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--csv") == 0) {
+      csv = true;
+    } else if (std::strcmp(argv[i], "--from-oldest") == 0) {
+      fromOldest = true;
+    } else {
+      name = argv[i];
+    }
+  }
+
+  SharedRingReader reader;
+  std::string error;
+  if (!reader.open(name, &error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  if (fromOldest) {
+    reader.rewindToOldest();
+  }
+  std::fprintf(stderr, "%s: %u samples, %.1f samples/s, base current %d mA\n",
+               name.c_str(), reader.capacity(), reader.sampleRate(),
+               reader.currentDiffMa());
+
+  std::signal(SIGINT, requestQuit);
+  std::signal(SIGTERM, requestQuit);
+  if (csv) {
+    std::printf("timestamp_ms,voltage_v,current_a,power_w,energy_wh\n");
+  }
+
+  std::vector<SharedSample> samples(4096);
+  std::uint64_t received = 0;
+  auto lastReport = std::chrono::steady_clock::now();
+  while (!quitRequested && reader.writerAlive()) {
+    const std::size_t count = reader.read(samples.data(), samples.size());
+    received += count;
+    if (csv) {
+      for (std::size_t i = 0; i < count; ++i) {
+        const SharedSample &s = samples[i];
+        std::printf("%llu,%.4f,%.4f,%.4f,%.6f\n",
+                    static_cast<unsigned long long>(s.timestamp), s.voltage,
+                    s.current, s.power, s.energy);
+      }
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!csv && now - lastReport >= std::chrono::seconds(1)) {
+      SharedSample latest;
+      if (reader.latest(latest)) {
+        std::printf("%llu samples, %.1f samples/s, %.3f V %.3f A %.3f W, %llu lost\n",
+                    static_cast<unsigned long long>(received), reader.sampleRate(),
+                    latest.voltage, latest.current, latest.power,
+                    static_cast<unsigned long long>(reader.lost()));
+        std::fflush(stdout);
+      }
+      lastReport = now;
+    }
+    if (count == 0) {
+      std::this_thread::sleep_for(kPollInterval);
+    }
+  }
+  if (!reader.writerAlive()) {
+    std::fprintf(stderr, "%s was closed by the publisher\n", name.c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,596 @@
+#include "AcquisitionCore.h"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Samples other processes can look back in shared memory, about a minute
+// at 1 kHz (3 MB)
+constexpr std::uint32_t kSharedRingCapacity = 1 << 16;
+// Longer gaps between samples, e.g. while disconnected, do not count as
+// time spent at a PD level
+constexpr quint64 kMaxSampleGapMs = 5000;
+
+QJsonObject latencyJson(const LatencyHistogram::Snapshot &snapshot) {
+  QJsonArray buckets;
+  for (const std::uint64_t count : snapshot.buckets) {
+    buckets.append(static_cast<double>(count));
+  }
+  return QJsonObject{{"count", static_cast<double>(snapshot.count)},
+                     {"meanMs", snapshot.meanUs() / 1000.0},
+                     {"p50Ms", snapshot.quantileUs(0.5) / 1000.0},
+                     {"p90Ms", snapshot.quantileUs(0.9) / 1000.0},
+                     {"p99Ms", snapshot.quantileUs(0.99) / 1000.0},
+                     {"buckets", buckets}};
+}
+
+QJsonObject sampleJson(const PowerData &sample) {
+  return QJsonObject{{"t", static_cast<double>(sample.timestamp)},
+                     {"v", sample.voltage},
+                     {"i", sample.current},
+                     {"p", sample.power},
+                     {"e", sample.energy}};
+}
+
+double median(std::vector<double> &values) {
+  const std::size_t mid = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + mid, values.end());
+  if (values.size() % 2 == 1) {
+    return values[mid];
+  }
+  return (*std::max_element(values.begin(), values.begin() + mid) + values[mid]) / 2.0;
+}
+
+// Statistics of the samples pushed to the history between the push counts
+// from and to, as far as they are still in it
+QJsonObject intervalStats(const MeasurementHistory &history, quint64 from, quint64 to) {
+  const quint64 oldest = history.pushCount() - history.size();
+  const bool truncated = from < oldest;
+  from = std::max(from, oldest);
+  const std::size_t count = to > from ? static_cast<std::size_t>(to - from) : 0;
+
+  std::vector<double> currents;
+  currents.reserve(count);
+  double minVoltage = 0.0;
+  double maxVoltage = 0.0;
+  double maxPower = 0.0;
+  double sumVoltage = 0.0;
+  double sumPower = 0.0;
+  double energyWh = 0.0;
+  quint64 first = 0;
+  quint64 last = 0;
+  history.forEachLastNOldestFirst(
+      static_cast<std::size_t>(history.pushCount() - from),
+      [&](const PowerData &sample, PowerDelivery::PD_VOLTS) {
+        if (currents.size() == count) {
+          return;
+        }
+        if (currents.empty()) {
+          first = sample.timestamp;
+          minVoltage = maxVoltage = sample.voltage;
+          maxPower = sample.power;
+        } else if (sample.timestamp > last && sample.timestamp - last <= kMaxSampleGapMs) {
+          energyWh += sample.power * static_cast<double>(sample.timestamp - last) / 3600000.0;
+        }
+        last = sample.timestamp;
+        currents.push_back(sample.current);
+        minVoltage = std::min(minVoltage, sample.voltage);
+        maxVoltage = std::max(maxVoltage, sample.voltage);
+        maxPower = std::max(maxPower, sample.power);
+        sumVoltage += sample.voltage;
+        sumPower += sample.power;
+      });
+
+  QJsonObject result{{"samples", static_cast<double>(currents.size())},
+                     {"truncated", truncated}};
+  if (currents.empty()) {
+    return result;
+  }
+  const double n = static_cast<double>(currents.size());
+  const auto [minCurrent, maxCurrent] = std::minmax_element(currents.begin(), currents.end());
+  const double minimum = *minCurrent;
+  const double maximum = *maxCurrent;
+  double sumCurrent = 0.0;
+  for (const double current : currents) {
+    sumCurrent += current;
+  }
+  const double meanCurrent = sumCurrent / n;
+  double variance = 0.0;
+  for (const double current : currents) {
+    variance += (current - meanCurrent) * (current - meanCurrent);
+  }
+  result.insert("durationMs", static_cast<double>(last - first));
+  result.insert("current", QJsonObject{{"min", minimum},
+                                       {"max", maximum},
+                                       {"mean", meanCurrent},
+                                       {"stddev", std::sqrt(variance / n)},
+                                       {"median", median(currents)}});
+  result.insert("voltage",
+                QJsonObject{{"min", minVoltage}, {"max", maxVoltage}, {"mean", sumVoltage / n}});
+  result.insert("power", QJsonObject{{"max", maxPower}, {"mean", sumPower / n}});
+  result.insert("energyWh", energyWh);
+  return result;
+}
+
+QByteArray levelLabel(int level) {
+  const int volts = PowerDelivery::getVoltage(static_cast<PowerDelivery::PD_VOLTS>(level));
+  return volts == 0 ? QByteArray("level=\"none\"")
+                    : "level=\"" + QByteArray::number(volts) + "V\"";
+}
+} // namespace
+
+AcquisitionCore::AcquisitionCore(OsdSettings *settings, QObject *parent)
+    : QObject(parent), m_settings(settings),
+      m_deviceManager(new DeviceManager(this)),
+      m_recorder(new SessionRecorder(this)),
+      m_streamServer(new StreamServer(this)),
+      m_sharedRing(new SharedRingPublisher(this)),
+      m_metricsServer(new MetricsServer(this)),
+      m_controlServer(new ControlServer(this)),
+      m_history(new MeasurementHistory(settings->history_size)),
+      m_reconnectTimer(new QTimer(this)) {
+  m_recorder->setCurrentDiffMa(settings->current_diff_ma);
+  m_streamServer->setCurrentDiffMa(settings->current_diff_ma);
+  m_sharedRing->setCurrentDiffMa(settings->current_diff_ma);
+
+  connect(m_deviceManager, &DeviceManager::powerDataReceived, this,
+          &AcquisitionCore::onPowerDataReceived);
+  connect(m_deviceManager, &DeviceManager::sampleAcquired, m_recorder,
+          &SessionRecorder::push, Qt::DirectConnection);
+  connect(m_deviceManager, &DeviceManager::sampleAcquired, m_streamServer,
+          &StreamServer::publish, Qt::DirectConnection);
+  connect(m_deviceManager, &DeviceManager::sampleAcquired, m_sharedRing,
+          &SharedRingPublisher::publish, Qt::DirectConnection);
+  connect(
+      m_deviceManager, &DeviceManager::sampleAcquired, this,
+      [this] { m_samplesAcquired.fetch_add(1, std::memory_order_relaxed); },
+      Qt::DirectConnection);
+  connect(m_deviceManager, &DeviceManager::deviceConnected, this,
+          &AcquisitionCore::onDeviceConnected);
+  connect(m_deviceManager, &DeviceManager::deviceDisconnected, this, [this] {
+    QMutexLocker locker(&m_metricsMutex);
+    m_metrics.connected = false;
+  });
+  connect(m_deviceManager, &DeviceManager::reconnectRequested, this,
+          &AcquisitionCore::startReconnectTimer);
+  connect(m_deviceManager, &DeviceManager::lastDeviceChanged, this,
+          [this](const QString &device) {
+            m_settings->last_device = device;
+            m_settings->saveSettings();
+          });
+
+  registerControlMethods();
+
+  m_reconnectTimer->setInterval(1000);
+  connect(m_reconnectTimer, &QTimer::timeout, this, [this] {
+    if (connectLastDevice()) {
+      m_reconnects.fetch_add(1, std::memory_order_relaxed);
+      m_reconnectTimer->stop();
+    }
+  });
+}
+
+AcquisitionCore::~AcquisitionCore() {
+  // A scrape reads the device manager, which is deleted before the server
+  m_metricsServer->close();
+  delete m_history;
+}
+
+PowerData AcquisitionCore::normalize(const PowerData &data) const {
+  if (m_settings->current_diff_ma == 0) return data;
+  PowerData normalized = data;
+  normalized.current = data.current - (static_cast<float>(m_settings->current_diff_ma) / 1000.0f);
+  if (normalized.current < 0) normalized.current = 0;
+  return normalized;
+}
+
+void AcquisitionCore::applySettings() {
+  m_recorder->setCurrentDiffMa(m_settings->current_diff_ma);
+  m_streamServer->setCurrentDiffMa(m_settings->current_diff_ma);
+  m_sharedRing->setCurrentDiffMa(m_settings->current_diff_ma);
+  if (m_history->capacity() != static_cast<std::size_t>(m_settings->history_size)) {
+    m_history->setCapacity(m_settings->history_size);
+    emit historyChanged();
+  }
+}
+
+void AcquisitionCore::resetHistory() {
+  m_history->reset();
+  emit historyChanged();
+}
+
+bool AcquisitionCore::connectLastDevice() {
+  return !m_settings->last_device.isEmpty() &&
+         m_deviceManager->tryConnect(m_settings->last_device);
+}
+
+void AcquisitionCore::startReconnectTimer() { m_reconnectTimer->start(); }
+
+void AcquisitionCore::stopReconnectTimer() { m_reconnectTimer->stop(); }
+
+void AcquisitionCore::addExtraMeters() {
+  for (const auto &portName : m_settings->extra_devices) {
+    m_deviceManager->addMeter(portName, m_history->capacity());
+  }
+}
+
+bool AcquisitionCore::startStreaming(const QStringList &addresses, QString *error) {
+  for (const QString &address : addresses) {
+    if (!m_streamServer->listen(address, error)) {
+      m_streamServer->close();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AcquisitionCore::startSharedRing(const QString &name, QString *error) {
+  std::string message;
+  if (!m_sharedRing->open(name.toStdString(), kSharedRingCapacity, &message)) {
+    *error = QString::fromStdString(message);
+    return false;
+  }
+  return true;
+}
+
+bool AcquisitionCore::startMetrics(const QString &address, QString *error) {
+  m_metricsServer->setRenderer([this] { return renderMetrics(); });
+  return m_metricsServer->listen(address, error);
+}
+
+bool AcquisitionCore::startControl(const QString &path, QString *error) {
+  return m_controlServer->listen(path, error);
+}
+
+const AcquisitionCore::PhaseMark *AcquisitionCore::findMark(const QJsonValue &reference) const {
+  if (reference.isDouble()) {
+    const double index = reference.toDouble();
+    return index >= 0 && index < static_cast<double>(m_marks.size()) && index == std::floor(index)
+               ? &m_marks[static_cast<std::size_t>(index)]
+               : nullptr;
+  }
+  const QString label = reference.toString();
+  const auto found = std::find_if(m_marks.rbegin(), m_marks.rend(),
+                                  [&label](const PhaseMark &mark) { return mark.label == label; });
+  return reference.isString() && found != m_marks.rend() ? &*found : nullptr;
+}
+
+void AcquisitionCore::registerControlMethods() {
+  // Currents are in A like everywhere else, less the base current; t is
+  // the meter's timestamp in ms
+  m_controlServer->registerMethod("ping", [](const QJsonObject &, QString *) -> QJsonValue {
+    return true;
+  });
+  m_controlServer->registerMethod(
+      "getReading", [this](const QJsonObject &, QString *) -> QJsonValue {
+        bool connected = false;
+        {
+          QMutexLocker locker(&m_metricsMutex);
+          connected = m_metrics.connected;
+        }
+        QJsonObject reading{{"connected", connected},
+                            {"baseCurrentMa", m_settings->current_diff_ma},
+                            {"recording", m_recorder->isRecording()}};
+        if (!m_history->is_empty()) {
+          reading.insert("sample", sampleJson(m_history->atByAge(0)));
+        }
+        return reading;
+      });
+  m_controlServer->registerMethod(
+      "getStats", [this](const QJsonObject &params, QString *) -> QJsonValue {
+        // {"lastN": n} limits them to the newest n samples
+        const std::size_t lastN =
+            params.contains("lastN")
+                ? static_cast<std::size_t>(std::max(0.0, params.value("lastN").toDouble()))
+                : m_history->size();
+        QJsonObject stats{
+            {"samples", static_cast<double>(std::min(lastN, m_history->size()))}};
+        double minCurrent = 0.0;
+        double maxCurrent = 0.0;
+        double medianVoltage = 0.0;
+        double medianCurrent = 0.0;
+        double medianPower = 0.0;
+        double maxVoltage = 0.0;
+        double maxPower = 0.0;
+        if (m_history->minMaxCurrentLastN(lastN, minCurrent, maxCurrent) &&
+            m_history->medianValuesLastN(lastN, medianVoltage, medianCurrent, medianPower) &&
+            m_history->maxValuesLastN(lastN, maxVoltage, maxCurrent, maxPower)) {
+          stats.insert("current",
+                       QJsonObject{{"min", minCurrent},
+                                   {"max", maxCurrent},
+                                   {"median", medianCurrent},
+                                   {"stddev", m_history->getCurrentStdDevLastN(lastN)}});
+          stats.insert("voltage", QJsonObject{{"max", maxVoltage}, {"median", medianVoltage}});
+          stats.insert("power", QJsonObject{{"max", maxPower}, {"median", medianPower}});
+        }
+        return stats;
+      });
+  m_controlServer->registerMethod(
+      "getLatency", [this](const QJsonObject &, QString *) -> QJsonValue {
+        // Per stage since start; bucket counts are per bound in boundsMs,
+        // the last one above them
+        QJsonArray bounds;
+        for (const std::uint64_t bound : LatencyHistogram::kBoundsUs) {
+          bounds.append(static_cast<double>(bound) / 1000.0);
+        }
+        QJsonObject stages;
+        for (int stage = 0; stage < PipelineLatency::StageCount; ++stage) {
+          const auto id = static_cast<PipelineLatency::Stage>(stage);
+          stages.insert(PipelineLatency::stageName(id),
+                        latencyJson(m_pipelineLatency.snapshot(id)));
+        }
+        return QJsonObject{{"boundsMs", bounds},
+                           {"stages", stages},
+                           {"ingest", latencyJson(m_ingestLatency.snapshot())},
+                           {"paint", latencyJson(m_paintLatency.snapshot())}};
+      });
+  m_controlServer->registerMethod("resetHistory",
+                                  [this](const QJsonObject &, QString *) -> QJsonValue {
+                                    resetHistory();
+                                    return true;
+                                  });
+
+  // Like the window's "Set Base Current": {} subtracts the current reading
+  // from now on, {"ma": n} sets the offset itself
+  m_controlServer->registerMethod(
+      "setBaseCurrent", [this](const QJsonObject &params, QString *error) -> QJsonValue {
+        if (params.contains("ma")) {
+          if (!params.value("ma").isDouble()) {
+            *error = "ma must be a number";
+            return {};
+          }
+          m_settings->current_diff_ma = static_cast<int>(std::lround(params.value("ma").toDouble()));
+        } else if (m_history->is_empty()) {
+          *error = "No reading to take the base current from";
+          return {};
+        } else {
+          m_settings->current_diff_ma +=
+              static_cast<int>(m_history->atByAge(0).current * 1000.0f);
+        }
+        applySettings();
+        emit calibrationChanged();
+        return m_settings->current_diff_ma;
+      });
+  m_controlServer->registerMethod(
+      "resetBaseCurrent", [this](const QJsonObject &, QString *) -> QJsonValue {
+        m_settings->current_diff_ma = 0;
+        applySettings();
+        emit calibrationChanged();
+        return true;
+      });
+
+  m_controlServer->registerMethod(
+      "startRecording", [this](const QJsonObject &params, QString *error) -> QJsonValue {
+        const QString path = params.value("path").toString();
+        if (path.isEmpty()) {
+          *error = "path is required";
+        } else if (m_recorder->isRecording()) {
+          *error = "Already recording to " + m_recorder->path();
+        } else if (!m_recorder->start(path)) {
+          *error = "Cannot record to " + path;
+        } else {
+          emit recordingChanged(true);
+        }
+        return path;
+      });
+  m_controlServer->registerMethod(
+      "stopRecording", [this](const QJsonObject &, QString *error) -> QJsonValue {
+        if (!m_recorder->isRecording()) {
+          *error = "Not recording";
+          return {};
+        }
+        m_recorder->stop();
+        emit recordingChanged(false);
+        return QJsonObject{{"path", m_recorder->path()},
+                           {"samples", static_cast<double>(m_recorder->recordedSamples())},
+                           {"dropped", static_cast<double>(m_recorder->droppedSamples())}};
+      });
+
+  // Test phases: mark {"label": s} notes where the history stands and
+  // returns the mark's index; intervalStats {"from": m, "to": m} summarizes
+  // the samples between two marks (to defaults to now), each given by
+  // index or label (the latest mark with it)
+  m_controlServer->registerMethod(
+      "mark", [this](const QJsonObject &params, QString *) -> QJsonValue {
+        PhaseMark mark;
+        mark.label = params.value("label").toString();
+        mark.pushCount = m_history->pushCount();
+        mark.epoch = m_history->epoch();
+        mark.timestamp = m_history->is_empty() ? 0 : m_history->atByAge(0).timestamp;
+        m_marks.push_back(mark);
+        return QJsonObject{{"index", static_cast<double>(m_marks.size() - 1)},
+                           {"t", static_cast<double>(mark.timestamp)}};
+      });
+  m_controlServer->registerMethod(
+      "marks", [this](const QJsonObject &, QString *) -> QJsonValue {
+        QJsonArray marks;
+        for (const PhaseMark &mark : m_marks) {
+          marks.append(QJsonObject{{"label", mark.label},
+                                   {"t", static_cast<double>(mark.timestamp)},
+                                   {"valid", mark.epoch == m_history->epoch()}});
+        }
+        return marks;
+      });
+  m_controlServer->registerMethod("clearMarks",
+                                  [this](const QJsonObject &, QString *) -> QJsonValue {
+                                    m_marks.clear();
+                                    return true;
+                                  });
+  m_controlServer->registerMethod(
+      "intervalStats", [this](const QJsonObject &params, QString *error) -> QJsonValue {
+        const PhaseMark *from = findMark(params.value("from"));
+        const PhaseMark *to =
+            params.contains("to") ? findMark(params.value("to")) : nullptr;
+        if (!from || (params.contains("to") && !to)) {
+          *error = "Unknown mark";
+          return {};
+        }
+        if (from->epoch != m_history->epoch() || (to && to->epoch != m_history->epoch())) {
+          *error = "The history was reset or resized after the mark";
+          return {};
+        }
+        const quint64 end = to ? to->pushCount : m_history->pushCount();
+        if (end < from->pushCount) {
+          *error = "to is before from";
+          return {};
+        }
+        return intervalStats(*m_history, from->pushCount, end);
+      });
+}
+
+void AcquisitionCore::onPowerDataReceived(const PowerData &data,
+                                          const SampleStamps &stamps) {
+  QElapsedTimer ingest;
+  ingest.start();
+  m_lastRaw = data;
+  const auto normalized = normalize(data);
+  // Classified once for the history and the per-level metrics
+  const auto level = PowerDelivery::getEnum(static_cast<float>(normalized.voltage));
+
+  // Below the threshold only the first sample is kept, so the graph drops
+  // to zero once instead of filling with idle readings
+  if (normalized.current < m_settings->min_current || normalized.voltage < 2.0) {
+    if (!m_lastWasInvalid) {
+      m_history->push(normalized, level);
+      m_pipelineLatency.inserted(stamps);
+      emit historyChanged();
+      m_lastWasInvalid = true;
+    }
+  } else {
+    m_lastWasInvalid = false;
+    m_history->push(normalized, level);
+    m_pipelineLatency.inserted(stamps);
+    emit historyChanged();
+  }
+  updateMetrics(normalized, level);
+  m_ingestLatency.record(static_cast<std::uint64_t>(ingest.nsecsElapsed()));
+}
+
+void AcquisitionCore::onDeviceConnected(const QString &deviceName) {
+  m_recorder->setSource(deviceName, m_deviceManager->protocolName());
+  QMutexLocker locker(&m_metricsMutex);
+  m_metrics.connected = true;
+}
+
+void AcquisitionCore::updateMetrics(const PowerData &normalized,
+                                    PowerDelivery::PD_VOLTS level) {
+  // Time and energy are attributed to the level of the sample that ends
+  // the interval
+  double intervalMs = 0.0;
+  if (m_lastTimestamp != 0 && normalized.timestamp > m_lastTimestamp &&
+      normalized.timestamp - m_lastTimestamp <= kMaxSampleGapMs) {
+    intervalMs = static_cast<double>(normalized.timestamp - m_lastTimestamp);
+  }
+  m_lastTimestamp = normalized.timestamp;
+
+  const double sampleRate = m_sampleRate.add(normalized.timestamp);
+
+  double minCurrent = 0.0;
+  double maxCurrent = 0.0;
+  m_history->minMaxCurrent(minCurrent, maxCurrent);
+
+  QMutexLocker locker(&m_metricsMutex);
+  m_metrics.hasSample = true;
+  m_metrics.last = normalized;
+  m_metrics.minCurrent = minCurrent;
+  m_metrics.maxCurrent = maxCurrent;
+  m_metrics.historySize = m_history->size();
+  if (sampleRate >= 0.0) {
+    m_metrics.sampleRate = sampleRate;
+  }
+  m_metrics.levelSeconds[level] += intervalMs / 1000.0;
+  m_metrics.levelEnergyWh[level] += normalized.power * intervalMs / 3600000.0;
+}
+
+QByteArray AcquisitionCore::renderMetrics() const {
+  MetricsSnapshot metrics;
+  {
+    QMutexLocker locker(&m_metricsMutex);
+    metrics = m_metrics;
+  }
+
+  MetricsText text;
+  text.family("usbpower_device_connected", "gauge",
+              "1 while the primary device is connected.");
+  text.value("usbpower_device_connected", metrics.connected ? 1 : 0);
+  if (metrics.hasSample) {
+    text.family("usbpower_voltage_volts", "gauge", "Latest voltage.");
+    text.value("usbpower_voltage_volts", metrics.last.voltage);
+    text.family("usbpower_current_amperes", "gauge",
+                "Latest current, less the base current.");
+    text.value("usbpower_current_amperes", metrics.last.current);
+    text.family("usbpower_power_watts", "gauge", "Latest power.");
+    text.value("usbpower_power_watts", metrics.last.power);
+    text.family("usbpower_energy_watthours", "gauge", "Energy counter of the meter.");
+    text.value("usbpower_energy_watthours", metrics.last.energy);
+    text.family("usbpower_history_current_min_amperes", "gauge",
+                "Lowest current in the measurement history.");
+    text.value("usbpower_history_current_min_amperes", metrics.minCurrent);
+    text.family("usbpower_history_current_max_amperes", "gauge",
+                "Highest current in the measurement history.");
+    text.value("usbpower_history_current_max_amperes", metrics.maxCurrent);
+  }
+  text.family("usbpower_history_samples", "gauge", "Samples in the measurement history.");
+  text.value("usbpower_history_samples", static_cast<double>(metrics.historySize));
+
+  text.family("usbpower_pd_level_seconds_total", "counter",
+              "Time spent at each USB PD voltage level.");
+  for (int level = PowerDelivery::PD_NONE; level <= PowerDelivery::PD_48V; ++level) {
+    text.value("usbpower_pd_level_seconds_total", metrics.levelSeconds[level],
+               levelLabel(level).constData());
+  }
+  text.family("usbpower_pd_level_energy_watthours_total", "counter",
+              "Energy delivered at each USB PD voltage level.");
+  for (int level = PowerDelivery::PD_NONE; level <= PowerDelivery::PD_48V; ++level) {
+    text.value("usbpower_pd_level_energy_watthours_total", metrics.levelEnergyWh[level],
+               levelLabel(level).constData());
+  }
+
+  text.family("usbpower_samples_total", "counter", "Samples acquired.");
+  text.value("usbpower_samples_total", static_cast<double>(m_samplesAcquired.load()));
+  text.family("usbpower_sample_rate_hertz", "gauge",
+              "Samples per second over the last second of the sample clock.");
+  text.value("usbpower_sample_rate_hertz", metrics.sampleRate);
+  text.family("usbpower_parse_errors_total", "counter",
+              "Serial lines or BLE notifications that did not decode.");
+  text.value("usbpower_parse_errors_total",
+             static_cast<double>(m_deviceManager->serialParseErrors()),
+             "transport=\"serial\"");
+  text.value("usbpower_parse_errors_total",
+             static_cast<double>(m_deviceManager->bleParseErrors()), "transport=\"ble\"");
+  text.family("usbpower_queue_dropped_total", "counter",
+              "Samples (capture: records) lost because a consumer fell behind.");
+  text.value("usbpower_queue_dropped_total",
+             static_cast<double>(m_recorder->droppedSamples()), "queue=\"recorder\"");
+  text.value("usbpower_queue_dropped_total",
+             static_cast<double>(m_streamServer->droppedSamples()), "queue=\"stream\"");
+  text.value("usbpower_queue_dropped_total",
+             static_cast<double>(m_deviceManager->rawCapture()->droppedRecords()),
+             "queue=\"capture\"");
+  text.family("usbpower_reconnects_total", "counter",
+              "Times the primary device was connected again after it was lost.");
+  text.value("usbpower_reconnects_total", static_cast<double>(m_reconnects.load()));
+  text.family("usbpower_stream_subscribers", "gauge", "Connected stream subscribers.");
+  text.value("usbpower_stream_subscribers", m_streamServer->subscriberCount());
+
+  text.histogram("usbpower_ingest_seconds",
+                 "Time to add a sample to the history and its statistics.",
+                 m_ingestLatency.snapshot());
+  text.histogram("usbpower_paint_seconds",
+                 "Time from handing a graph frame to the renderer until it is painted.",
+                 m_paintLatency.snapshot());
+  text.family("usbpower_pipeline_latency_seconds", "histogram",
+              "Time a sample took from the transport read through each stage to the screen.");
+  for (int stage = 0; stage < PipelineLatency::StageCount; ++stage) {
+    const auto id = static_cast<PipelineLatency::Stage>(stage);
+    const QByteArray labels =
+        QByteArray("stage=\"") + PipelineLatency::stageName(id) + '"';
+    text.histogramValues("usbpower_pipeline_latency_seconds",
+                         m_pipelineLatency.snapshot(id), labels.constData());
+  }
+  return text.text();
+}
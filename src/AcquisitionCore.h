@@ -0,0 +1,147 @@
+#ifndef ACQUISITIONCORE_H
+#define ACQUISITIONCORE_H
+
+#include "ControlServer.h"
+#include "DeviceManager.h"
+#include "LatencyHistogram.h"
+#include "MeasurementHistory.h"
+#include "MetricsServer.h"
+#include "OsdSettings.h"
+#include "PipelineLatency.h"
+#include "PowerData.h"
+#include "SampleRateWindow.h"
+#include "SessionRecorder.h"
+#include "SharedRingPublisher.h"
+#include "StreamServer.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Everything that keeps measuring without a window: the primary device and
+// its reconnects, the additional meters, the measurement history fed with
+// calibrated samples, session recording, and streaming to local
+// subscribers and into shared memory, and the control socket test scripts
+// drive it through. MainWindow puts a user interface on
+// top of it; the headless mode (HeadlessDaemon) runs it alone under a
+// QCoreApplication.
+class AcquisitionCore : public QObject {
+  Q_OBJECT
+
+public:
+  explicit AcquisitionCore(OsdSettings *settings, QObject *parent = nullptr);
+  ~AcquisitionCore() override;
+
+  [[nodiscard]] DeviceManager *deviceManager() const { return m_deviceManager; }
+  [[nodiscard]] MeasurementHistory *history() const { return m_history; }
+  [[nodiscard]] SessionRecorder *recorder() const { return m_recorder; }
+  [[nodiscard]] StreamServer *streamServer() const { return m_streamServer; }
+  [[nodiscard]] ControlServer *controlServer() const { return m_controlServer; }
+  [[nodiscard]] OsdSettings *settings() const { return m_settings; }
+  // Last sample as received, before calibration and filtering
+  [[nodiscard]] const PowerData &lastRaw() const { return m_lastRaw; }
+
+  // Subtracts the base current offset (settings->current_diff_ma)
+  [[nodiscard]] PowerData normalize(const PowerData &data) const;
+  // Picks up changed calibration and history size from the settings
+  void applySettings();
+  void resetHistory();
+
+  // Tries settings->last_device once; false if there is none or it failed
+  bool connectLastDevice();
+  // Retries connectLastDevice() every second until it succeeds
+  void startReconnectTimer();
+  void stopReconnectTimer();
+  // Starts monitoring the meters in settings->extra_devices
+  void addExtraMeters();
+  // Publishes the samples on the given addresses (see StreamServer::listen);
+  // false with a message in error if one of them cannot be bound
+  bool startStreaming(const QStringList &addresses, QString *error);
+  // Exposes the samples in the POSIX shared-memory ring of that name (see
+  // SharedRingFormat.h); false with a message in error if it fails
+  bool startSharedRing(const QString &name, QString *error);
+  // Serves the readings and pipeline health on http://<address>/metrics
+  // (see MetricsServer::listen)
+  bool startMetrics(const QString &address, QString *error);
+  // Accepts JSON-RPC requests on the Unix socket at path (see
+  // ControlServer); false with a message in error if it cannot be bound
+  bool startControl(const QString &path, QString *error);
+  // Frame latency of the graph, filled in by the window
+  [[nodiscard]] LatencyHistogram *paintLatency() { return &m_paintLatency; }
+  // Per-stage latency of the samples from the transport to the screen; the
+  // window reports when they are drawn and shown
+  [[nodiscard]] PipelineLatency *pipelineLatency() { return &m_pipelineLatency; }
+
+signals:
+  // A sample was added to the history, or the history was reset or resized
+  void historyChanged();
+  // A control request changed the base current or started or stopped the
+  // recording, for the window to catch up
+  void calibrationChanged();
+  void recordingChanged(bool recording);
+
+private slots:
+  void onPowerDataReceived(const PowerData &data, const SampleStamps &stamps);
+  void onDeviceConnected(const QString &deviceName);
+
+private:
+  // What the metrics thread reports, copied out under m_metricsMutex
+  struct MetricsSnapshot {
+    bool connected = false;
+    bool hasSample = false;
+    PowerData last;
+    double minCurrent = 0.0;
+    double maxCurrent = 0.0;
+    std::size_t historySize = 0;
+    double sampleRate = 0.0;
+    std::array<double, PowerDelivery::PD_48V + 1> levelSeconds{};
+    std::array<double, PowerDelivery::PD_48V + 1> levelEnergyWh{};
+  };
+
+  // A test phase boundary set over the control socket, as a position in
+  // the history
+  struct PhaseMark {
+    QString label;
+    quint64 pushCount = 0;
+    quint64 epoch = 0;
+    quint64 timestamp = 0;
+  };
+
+  void registerControlMethods();
+  // The mark named by a control parameter: its index, or the latest mark
+  // with that label
+  [[nodiscard]] const PhaseMark *findMark(const QJsonValue &reference) const;
+  void updateMetrics(const PowerData &normalized, PowerDelivery::PD_VOLTS level);
+  // Runs on the metrics thread
+  [[nodiscard]] QByteArray renderMetrics() const;
+
+  OsdSettings *m_settings;
+  DeviceManager *m_deviceManager;
+  // Created after the device manager so it outlives the acquisition thread
+  SessionRecorder *m_recorder;
+  StreamServer *m_streamServer;
+  SharedRingPublisher *m_sharedRing;
+  MetricsServer *m_metricsServer;
+  ControlServer *m_controlServer;
+  MeasurementHistory *m_history;
+  QTimer *m_reconnectTimer;
+  PowerData m_lastRaw;
+  bool m_lastWasInvalid = false;
+  std::vector<PhaseMark> m_marks;
+
+  std::atomic<quint64> m_samplesAcquired{0};
+  std::atomic<quint64> m_reconnects{0};
+  LatencyHistogram m_ingestLatency;
+  LatencyHistogram m_paintLatency;
+  PipelineLatency m_pipelineLatency;
+  mutable QMutex m_metricsMutex;
+  MetricsSnapshot m_metrics;
+  // Sample clock of the metrics, GUI thread only
+  quint64 m_lastTimestamp = 0;
+  SampleRateWindow m_sampleRate;
+};
+
+#endif // ACQUISITIONCORE_H
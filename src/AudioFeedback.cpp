@@ -0,0 +1,196 @@
+#include "AudioFeedback.h"
+
+#include "AudioGenerator.h"
+
+#include <QAudioDevice>
+#include <QAudioSink>
+#include <QDebug>
+#include <QMediaDevices>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+qint64 steadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+} // namespace
+
+AudioFeedback::AudioFeedback(QObject *parent)
+    : QObject(parent), m_thread(new QThread(this)),
+      m_audioContext(new QObject) {
+  m_thread->setObjectName("audio");
+  m_audioContext->moveToThread(m_thread);
+  m_thread->start(QThread::TimeCriticalPriority);
+}
+
+AudioFeedback::~AudioFeedback() {
+  m_activeGenerator.store(nullptr);
+  QMetaObject::invokeMethod(
+      m_audioContext,
+      [this] {
+        destroySink();
+        delete m_generator;
+        m_generator = nullptr;
+      },
+      Qt::BlockingQueuedConnection);
+  m_thread->quit();
+  m_thread->wait();
+  delete m_audioContext;
+}
+
+void AudioFeedback::start(bool lowLatency, int bufferMs) {
+  if (m_running) {
+    stop();
+  }
+  QMetaObject::invokeMethod(
+      m_audioContext, [=] { createSink(lowLatency, bufferMs); },
+      Qt::BlockingQueuedConnection);
+  m_activeGenerator.store(m_generator);
+  m_running = true;
+}
+
+void AudioFeedback::stop() {
+  if (!m_running) {
+    return;
+  }
+  m_activeGenerator.store(nullptr);
+  QMetaObject::invokeMethod(
+      m_audioContext, [this] { destroySink(); }, Qt::BlockingQueuedConnection);
+  m_running = false;
+}
+
+void AudioFeedback::createSink(bool lowLatency, int bufferMs) {
+  const QAudioDevice device = QMediaDevices::defaultAudioOutput();
+  QAudioFormat format;
+  format.setSampleRate(44100);
+  format.setChannelCount(1);
+  format.setSampleFormat(QAudioFormat::Float);
+  if (!device.isFormatSupported(format)) {
+    format.setSampleFormat(QAudioFormat::Int16);
+  }
+
+  // The generator survives stop() so a sample racing with it never touches
+  // a deleted object; it only goes away with this AudioFeedback
+  if (!m_generator) {
+    m_generator = new AudioGenerator(format);
+  } else {
+    m_generator->setFormat(format);
+  }
+
+  m_sink = new QAudioSink(device, format);
+  if (lowLatency) {
+    m_sink->setBufferSize(
+        format.bytesForDuration(std::max(1, bufferMs) * qint64(1000)));
+  }
+  m_generator->setAmplitude(0.0);
+  m_generator->start();
+  m_sink->start(m_generator);
+  qDebug() << "Audio output started, buffer" << m_sink->bufferSize()
+           << "bytes =" << format.durationForBytes(m_sink->bufferSize()) / 1000.0
+           << "ms";
+}
+
+void AudioFeedback::destroySink() {
+  if (m_sink) {
+    m_sink->stop();
+    delete m_sink;
+    m_sink = nullptr;
+  }
+  if (m_generator) {
+    m_generator->stop();
+  }
+}
+
+void AudioFeedback::setNormalization(double baseCurrent, double minCurrent) {
+  m_baseCurrent.store(baseCurrent, std::memory_order_relaxed);
+  m_minCurrent.store(minCurrent, std::memory_order_relaxed);
+}
+
+void AudioFeedback::onSample(const PowerData &sample) {
+  AudioGenerator *generator = m_activeGenerator.load(std::memory_order_acquire);
+  if (!generator) {
+    return;
+  }
+  const qint64 arrivedNs = steadyNowNs();
+  const double current = std::max(
+      0.0, sample.current - m_baseCurrent.load(std::memory_order_relaxed));
+  if (current < m_minCurrent.load(std::memory_order_relaxed) ||
+      sample.voltage < 2.0) {
+    generator->setTone(440.0, 0.0, arrivedNs);
+    return;
+  }
+
+  if (m_resetRecent.exchange(false, std::memory_order_relaxed)) {
+    m_recentCount = 0;
+  }
+  m_recent[m_recentHead] = current;
+  m_recentHead = (m_recentHead + 1) % kRecent;
+  m_recentCount = std::min(m_recentCount + 1, kRecent);
+  const auto stdDevLastN = [this](std::size_t lastN) {
+    lastN = std::min(lastN, m_recentCount);
+    if (lastN < 2) {
+      return 0.0;
+    }
+    double sum = 0.0;
+    for (std::size_t i = 1; i <= lastN; ++i) {
+      sum += m_recent[(m_recentHead + kRecent - i) % kRecent];
+    }
+    const double mean = sum / static_cast<double>(lastN);
+    double squares = 0.0;
+    for (std::size_t i = 1; i <= lastN; ++i) {
+      const double diff = m_recent[(m_recentHead + kRecent - i) % kRecent] - mean;
+      squares += diff * diff;
+    }
+    return std::sqrt(squares / static_cast<double>(lastN));
+  };
+
+  // Frequency: 400Hz to 4kHz depending on current (0 to 5A), sqrt for
+  // higher sensitivity at low currents
+  const double normalizedCurrent = std::min(current / 5.0, 1.0);
+  const double frequency = 400.0 + (4000.0 - 400.0) * std::sqrt(normalizedCurrent);
+
+  // Amplitude: louder while the current changes, i.e. the short-term
+  // stddev differs from the longer one; 50mA difference is full volume (0.1)
+  const double diff = std::abs(stdDevLastN(3) - stdDevLastN(10));
+  const double amplitude = std::min(diff / 0.05, 1.0) * 0.1;
+
+  generator->setTone(frequency, amplitude, arrivedNs);
+}
+
+void AudioFeedback::silence() {
+  m_resetRecent.store(true, std::memory_order_relaxed);
+  if (AudioGenerator *generator = m_activeGenerator.load()) {
+    generator->setAmplitude(0.0);
+  }
+}
+
+AudioFeedback::Latency AudioFeedback::latency() const {
+  Latency latency;
+  if (!m_running) {
+    return latency;
+  }
+  QMetaObject::invokeMethod(
+      m_audioContext,
+      [this] {
+        Latency measured;
+        if (!m_sink || !m_generator) {
+          return measured;
+        }
+        const QAudioFormat format = m_sink->format();
+        const qint64 bufferBytes = m_sink->bufferSize();
+        const qint64 queuedBytes =
+            std::max<qint64>(0, bufferBytes - m_sink->bytesFree());
+        const qint64 pickupNs = m_generator->pickupDelayNs();
+        measured.valid = pickupNs >= 0;
+        measured.pickupMs = static_cast<double>(std::max<qint64>(0, pickupNs)) / 1e6;
+        measured.outputMs = static_cast<double>(format.durationForBytes(queuedBytes)) / 1000.0;
+        measured.bufferBytes = static_cast<int>(bufferBytes);
+        measured.bufferMs = static_cast<double>(format.durationForBytes(bufferBytes)) / 1000.0;
+        return measured;
+      },
+      Qt::BlockingQueuedConnection, &latency);
+  return latency;
+}
@@ -0,0 +1,77 @@
+#ifndef AUDIOFEEDBACK_H
+#define AUDIOFEEDBACK_H
+
+#include "PowerData.h"
+
+#include <QObject>
+#include <QThread>
+#include <array>
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+class QAudioSink;
+QT_END_NAMESPACE
+class AudioGenerator;
+
+// Audible current probe.
+// The tone is produced by an AudioGenerator pulled by a QAudioSink, both
+// living on a dedicated audio thread so GUI work cannot delay the pulls.
+// Samples are fed in with onSample() straight from the acquisition thread;
+// nothing on the way from the meter to the pitch waits for the event loop.
+class AudioFeedback : public QObject {
+  Q_OBJECT
+
+public:
+  struct Latency {
+    bool valid = false;
+    double pickupMs = 0.0; // sample decoded -> oscillator picked it up
+    double outputMs = 0.0; // audio queued in the sink at the time of asking
+    int bufferBytes = 0;   // sink buffer size the backend actually granted
+    double bufferMs = 0.0;
+    [[nodiscard]] double totalMs() const { return pickupMs + outputMs; }
+  };
+
+  explicit AudioFeedback(QObject *parent = nullptr);
+  ~AudioFeedback() override;
+
+  // lowLatency requests a sink buffer of bufferMs instead of the backend
+  // default (typically several hundred ms)
+  void start(bool lowLatency, int bufferMs);
+  void stop();
+  [[nodiscard]] bool isRunning() const { return m_running; }
+
+  // Same normalization MainWindow applies before storing a sample
+  void setNormalization(double baseCurrent, double minCurrent);
+
+  // Called on the acquisition thread, by one producer at a time
+  void onSample(const PowerData &sample);
+  // Mutes the tone, e.g. when the device disconnects
+  void silence();
+
+  // Measured on the audio thread; blocks briefly
+  [[nodiscard]] Latency latency() const;
+
+private:
+  void createSink(bool lowLatency, int bufferMs);
+  void destroySink();
+
+  QThread *m_thread;
+  QObject *m_audioContext;
+  // Owned by the audio thread
+  AudioGenerator *m_generator = nullptr;
+  QAudioSink *m_sink = nullptr;
+  std::atomic<AudioGenerator *> m_activeGenerator{nullptr};
+  bool m_running = false;
+
+  std::atomic<double> m_baseCurrent{0.0};
+  std::atomic<double> m_minCurrent{0.0};
+
+  // Recent valid currents for the volume envelope, acquisition thread only
+  static constexpr std::size_t kRecent = 10;
+  std::array<double, kRecent> m_recent{};
+  std::size_t m_recentCount = 0;
+  std::size_t m_recentHead = 0;
+  std::atomic<bool> m_resetRecent{false};
+};
+
+#endif // AUDIOFEEDBACK_H
@@ -0,0 +1,128 @@
+#include "AudioGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr int kTableBits = 11;
+constexpr std::uint32_t kTableSize = 1u << kTableBits;
+constexpr int kFractionBits = 32 - kTableBits;
+constexpr std::uint32_t kFractionMask = (1u << kFractionBits) - 1;
+constexpr float kFractionScale = 1.0f / static_cast<float>(1u << kFractionBits);
+constexpr double kPhaseRange = 4294967296.0; // 2^32, one full cycle
+
+// One sine cycle plus a guard entry, so interpolation never wraps
+const std::array<float, kTableSize + 1> &sineTable() {
+    static const auto table = [] {
+        std::array<float, kTableSize + 1> values{};
+        for (std::uint32_t i = 0; i <= kTableSize; ++i) {
+            values[i] = static_cast<float>(std::sin(2.0 * M_PI * i / kTableSize));
+        }
+        return values;
+    }();
+    return table;
+}
+} // namespace
+
+AudioGenerator::AudioGenerator(const QAudioFormat &format, QObject *parent)
+    : QIODevice(parent), m_format(format) {
+    sineTable();
+}
+
+qint64 AudioGenerator::readData(char *data, qint64 len) {
+    const int channelCount = std::max(1, m_format.channelCount());
+    const int sampleSize = m_format.bytesPerSample();
+    const int sampleRate = m_format.sampleRate();
+    const auto sampleFormat = m_format.sampleFormat();
+    if (sampleSize <= 0 || sampleRate <= 0 ||
+        (sampleFormat != QAudioFormat::Int16 && sampleFormat != QAudioFormat::Float)) {
+        std::memset(data, 0, static_cast<std::size_t>(len));
+        return len;
+    }
+    const qint64 frameSize = static_cast<qint64>(sampleSize) * channelCount;
+    const qint64 frames = len / frameSize;
+    if (frames <= 0) {
+        return 0;
+    }
+
+    // Parameters are read once per call and ramped across it
+    const qint64 sampleTimeNs = m_sampleTimeNs.load(std::memory_order_acquire);
+    if (sampleTimeNs != 0 && sampleTimeNs != m_pickedUpSampleNs) {
+        m_pickedUpSampleNs = sampleTimeNs;
+        const qint64 nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        m_pickupDelayNs.store(nowNs - sampleTimeNs, std::memory_order_relaxed);
+    }
+    const double frequency = std::clamp(
+        static_cast<double>(m_frequency.load(std::memory_order_relaxed)), 0.0, sampleRate / 2.0);
+    const auto targetIncrement = static_cast<float>(frequency / sampleRate * kPhaseRange);
+    const float targetAmplitude =
+        std::clamp(m_amplitude.load(std::memory_order_relaxed), 0.0f, 1.0f);
+    if (m_currentIncrement < 0.0f) {
+        m_currentIncrement = targetIncrement;
+    }
+    const float incrementStep = (targetIncrement - m_currentIncrement) / static_cast<float>(frames);
+    const float amplitudeStep = (targetAmplitude - m_currentAmplitude) / static_cast<float>(frames);
+
+    float increment = m_currentIncrement;
+    float amplitude = m_currentAmplitude;
+    char *out = data;
+    for (qint64 done = 0; done < frames;) {
+        const int count = static_cast<int>(std::min<qint64>(kBlockFrames, frames - done));
+        renderBlock(m_block.data(), count, amplitude, amplitudeStep, increment, incrementStep);
+        increment += incrementStep * static_cast<float>(count);
+        amplitude += amplitudeStep * static_cast<float>(count);
+
+        if (sampleFormat == QAudioFormat::Float) {
+            auto *samples = reinterpret_cast<float *>(out);
+            if (channelCount == 1) {
+                std::memcpy(samples, m_block.data(), count * sizeof(float));
+            } else {
+                for (int i = 0; i < count; ++i) {
+                    for (int c = 0; c < channelCount; ++c) {
+                        *samples++ = m_block[i];
+                    }
+                }
+            }
+        } else {
+            auto *samples = reinterpret_cast<std::int16_t *>(out);
+            std::array<std::int16_t, kBlockFrames> converted;
+            for (int i = 0; i < count; ++i) {
+                converted[i] = static_cast<std::int16_t>(
+                    std::clamp(m_block[i] * 32767.0f, -32768.0f, 32767.0f));
+            }
+            for (int i = 0; i < count; ++i) {
+                for (int c = 0; c < channelCount; ++c) {
+                    *samples++ = converted[i];
+                }
+            }
+        }
+        out += count * frameSize;
+        done += count;
+    }
+
+    // Land exactly on the targets so rounding errors cannot accumulate
+    m_currentIncrement = targetIncrement;
+    m_currentAmplitude = targetAmplitude;
+    return frames * frameSize;
+}
+
+void AudioGenerator::renderBlock(float *out, int frames, float amplitude, float amplitudeStep,
+                                 float increment, float incrementStep) {
+    const auto &table = sineTable();
+    std::uint32_t phase = m_phase;
+    for (int i = 0; i < frames; ++i) {
+        const std::uint32_t index = phase >> kFractionBits;
+        const float fraction = static_cast<float>(phase & kFractionMask) * kFractionScale;
+        out[i] = table[index] + (table[index + 1] - table[index]) * fraction;
+        phase += static_cast<std::uint32_t>(increment + incrementStep * static_cast<float>(i));
+    }
+    m_phase = phase;
+
+    // Separate pass without a loop-carried dependency, so it vectorizes
+    for (int i = 0; i < frames; ++i) {
+        out[i] *= amplitude + amplitudeStep * static_cast<float>(i);
+    }
+}
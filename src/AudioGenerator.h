@@ -3,16 +3,21 @@
 
 #include <QIODevice>
 #include <QAudioFormat>
-#include <cmath>
+#include <array>
 #include <atomic>
+#include <limits>
+#include <cstdint>
 
+// Sine tone source for the audio feedback.
+// A phase-accumulator oscillator reads a shared wavetable; frequency and
+// amplitude are picked up once per readData() call and ramped linearly
+// across it, so parameter updates never produce clicks. Supports Int16 and
+// Float sample formats with any channel count.
 class AudioGenerator : public QIODevice {
     Q_OBJECT
 
 public:
-    explicit AudioGenerator(const QAudioFormat &format, QObject *parent = nullptr)
-        : QIODevice(parent), m_format(format) {
-    }
+    explicit AudioGenerator(const QAudioFormat &format, QObject *parent = nullptr);
 
     void start() {
         open(QIODevice::ReadOnly);
@@ -22,50 +27,35 @@ public:
         close();
     }
 
+    // Only while stopped, e.g. when the output device changed
+    void setFormat(const QAudioFormat &format) {
+        m_format = format;
+    }
+
+    // Both are safe to call from any thread
     void setFrequency(double frequency) {
-        m_frequency.store(frequency);
+        m_frequency.store(static_cast<float>(frequency), std::memory_order_relaxed);
     }
 
     void setAmplitude(double amplitude) {
-        m_amplitude.store(amplitude);
+        m_amplitude.store(static_cast<float>(amplitude), std::memory_order_relaxed);
     }
 
-    qint64 readData(char *data, qint64 len) override {
-        const int sampleSize = m_format.sampleFormat() == QAudioFormat::Int16 ? 2 : 4;
-        const int channelCount = m_format.channelCount();
-        const int sampleRate = m_format.sampleRate();
-        qint64 samplesToRead = len / (sampleSize * channelCount);
-        
-        if (m_format.sampleFormat() == QAudioFormat::Int16) {
-            auto *ptr = reinterpret_cast<std::int16_t *>(data);
-            for (qint64 i = 0; i < samplesToRead; ++i) {
-                double freq = m_frequency.load();
-                double amp = m_amplitude.load();
-                double val = std::sin(m_phase) * amp * 32767.0;
-                std::int16_t sample = static_cast<std::int16_t>(std::clamp(val, -32768.0, 32767.0));
-                for (int j = 0; j < channelCount; ++j) {
-                    *ptr++ = sample;
-                }
-                m_phase += 2.0 * M_PI * freq / sampleRate;
-                if (m_phase > 2.0 * M_PI) m_phase -= 2.0 * M_PI;
-            }
-        } else if (m_format.sampleFormat() == QAudioFormat::Float) {
-            auto *ptr = reinterpret_cast<float *>(data);
-            for (qint64 i = 0; i < samplesToRead; ++i) {
-                double freq = m_frequency.load();
-                double amp = m_amplitude.load();
-                auto sample = static_cast<float>(std::sin(m_phase) * amp);
-                for (int j = 0; j < channelCount; ++j) {
-                    *ptr++ = sample;
-                }
-                m_phase += 2.0 * M_PI * freq / sampleRate;
-                if (m_phase > 2.0 * M_PI) m_phase -= 2.0 * M_PI;
-            }
-        }
-
-        return samplesToRead * sampleSize * channelCount;
+    // Sets both parameters for a sample that arrived at sampleTimeNs
+    // (steady clock); readData() reports how long the tone took to pick it up
+    void setTone(double frequency, double amplitude, qint64 sampleTimeNs) {
+        setFrequency(frequency);
+        setAmplitude(amplitude);
+        m_sampleTimeNs.store(sampleTimeNs, std::memory_order_release);
     }
 
+    // Time from the last stamped sample to the oscillator picking it up, or -1
+    [[nodiscard]] qint64 pickupDelayNs() const {
+        return m_pickupDelayNs.load(std::memory_order_relaxed);
+    }
+
+    qint64 readData(char *data, qint64 len) override;
+
     qint64 writeData(const char *data, qint64 len) override {
         Q_UNUSED(data);
         Q_UNUSED(len);
@@ -77,10 +67,27 @@ public:
     }
 
 private:
+    // Mono samples are rendered in blocks of this size before being
+    // converted and interleaved into the output buffer
+    static constexpr int kBlockFrames = 256;
+
+    void renderBlock(float *out, int frames, float amplitude, float amplitudeStep,
+                     float increment, float incrementStep);
+
     QAudioFormat m_format;
-    double m_phase = 0.0;
-    std::atomic<double> m_frequency{440.0};
-    std::atomic<double> m_amplitude{0.0};
+    std::array<float, kBlockFrames> m_block{};
+
+    // Oscillator state, only touched by the audio thread
+    std::uint32_t m_phase = 0;
+    float m_currentIncrement = -1.0f; // < 0: not started yet
+    float m_currentAmplitude = 0.0f;
+
+    qint64 m_pickedUpSampleNs = 0;
+
+    std::atomic<float> m_frequency{440.0f};
+    std::atomic<float> m_amplitude{0.0f};
+    std::atomic<qint64> m_sampleTimeNs{0};
+    std::atomic<qint64> m_pickupDelayNs{-1};
 };
 
 #endif // AUDIOGENERATOR_H
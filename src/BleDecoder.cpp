@@ -0,0 +1,62 @@
+#include "BleDecoder.h"
+
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QVariant>
+
+bool BleDecoder::decode(const QByteArray &payload, std::uint64_t timestampMs,
+                        PowerData &sample, QString *error) {
+  QJsonParseError parseError;
+  const QJsonDocument doc = QJsonDocument::fromJson(payload, &parseError);
+  if (parseError.error != QJsonParseError::NoError) {
+    if (error) {
+      *error = "JSON parse error: " + parseError.errorString();
+    }
+    return false;
+  }
+  if (!doc.isObject()) {
+    if (error) {
+      *error = "JSON data is not an object";
+    }
+    return false;
+  }
+
+  sample = parseJsonToPowerData(doc.object(), timestampMs);
+
+  // Update energy accumulation for BLE data
+  if (m_lastTimestamp != 0) {
+    const double timeDelta =
+        (static_cast<double>(sample.timestamp) - static_cast<double>(m_lastTimestamp)) /
+        1000.0; // Convert to seconds
+    if (timeDelta > 0 && timeDelta < 3600) { // Sanity check (less than 1 hour)
+      m_energyAccumulator += sample.power * (timeDelta / 3600.0); // Convert to hours
+    }
+  }
+  sample.energy = m_energyAccumulator;
+  m_lastTimestamp = sample.timestamp;
+  return true;
+}
+
+void BleDecoder::reset() {
+  m_energyAccumulator = 0.0;
+  m_lastTimestamp = 0;
+}
+
+PowerData BleDecoder::parseJsonToPowerData(const QJsonObject &json,
+                                           std::uint64_t timestampMs) {
+  PowerData data;
+
+  // Parse JSON fields from your device format
+  data.current = json.value("current").toDouble(0.0);
+  data.voltage = json.value("voltage").toDouble(0.0);
+  data.power = json.value("power").toDouble(0.0);
+  data.energy = json.value("charge").toDouble(0.0);
+  // You might need to convert charge to energy units here
+
+  // Use device timestamp if available, otherwise the time of arrival
+  data.timestamp = json.value("timestamp").toVariant().toULongLong();
+  if (data.timestamp == 0) {
+    data.timestamp = timestampMs;
+  }
+  return data;
+}
@@ -0,0 +1,31 @@
+#ifndef BLEDECODER_H
+#define BLEDECODER_H
+
+#include "PowerData.h"
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <cstdint>
+
+// Turns the JSON notifications of a USB Power OSD V2-BLE meter into samples
+// and integrates their power into energy. Used by BluetoothManager on live
+// notifications and by the replay of raw captures.
+class BleDecoder {
+public:
+  // One notification; timestampMs stands in when the meter sends none.
+  // False with a reason in error if the payload is not a JSON object.
+  bool decode(const QByteArray &payload, std::uint64_t timestampMs,
+              PowerData &sample, QString *error = nullptr);
+  // Restarts the energy integration
+  void reset();
+
+  static PowerData parseJsonToPowerData(const QJsonObject &json,
+                                        std::uint64_t timestampMs);
+
+private:
+  double m_energyAccumulator = 0.0;
+  std::uint64_t m_lastTimestamp = 0;
+};
+
+#endif // BLEDECODER_H
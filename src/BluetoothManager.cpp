@@ -1,12 +1,6 @@
 #include "BluetoothManager.h"
 
-#include "DeviceManager.h"
-
-#include <QDateTime>
 #include <QDebug>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonParseError>
 #include <QTimer>
 
 // These UUIDs should match your V2-BLE firmware implementation
@@ -305,6 +299,9 @@ void BluetoothManager::setupService()
     }
     
     m_isConnected = true;
+    if (m_capture) {
+        m_capture->setSource(CaptureSource::Ble, "BLE", m_targetDevice.name());
+    }
     emit deviceConnected(m_targetDevice.name());
     
     qDebug() << "BLE service setup complete";
@@ -321,62 +318,31 @@ void BluetoothManager::onCharacteristicChanged(const QLowEnergyCharacteristic &c
 {
     if (characteristic == m_dataCharacteristic) {
         //qDebug() << "Received notification data:" << value;
+        const quint64 readNs = PipelineLatency::nowNs();
+        const quint64 timestampUs = RawCapture::timestampUs();
+        if (m_capture) {
+            m_capture->append(CaptureSource::Ble, value.constData(), value.size(), timestampUs);
+        }
         emit dataReceived(value);  // Keep raw data signal for compatibility
-        parseJsonAndEmitPowerData(value);  // Parse and emit PowerData
+        parseJsonAndEmitPowerData(value, timestampUs, readNs);  // Parse and emit PowerData
     }
 }
 
-void BluetoothManager::parseJsonAndEmitPowerData(const QByteArray &data)
+void BluetoothManager::parseJsonAndEmitPowerData(const QByteArray &data,
+                                                 quint64 timestampUs, quint64 readNs)
 {
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
-    
-    if (error.error != QJsonParseError::NoError) {
-        qWarning() << "JSON parse error:" << error.errorString();
+    PowerData powerData;
+    QString error;
+    if (!m_decoder.decode(data, timestampUs / 1000, powerData, &error)) {
+        m_parseErrors.fetch_add(1, std::memory_order_relaxed);
+        qWarning() << error;
         qWarning() << "Raw data:" << data;
         return;
     }
-    
-    if (!doc.isObject()) {
-        qWarning() << "JSON data is not an object";
-        return;
-    }
-    
-    QJsonObject json = doc.object();
-    PowerData powerData = parseJsonToPowerData(json);
-    
-    // Update energy accumulation for BLE data
-    if (m_lastTimestamp != 0) {
-        double timeDelta = (powerData.timestamp - m_lastTimestamp) / 1000.0; // Convert to seconds
-        if (timeDelta > 0 && timeDelta < 3600) { // Sanity check (less than 1 hour)
-            m_energyAccumulator += powerData.power * (timeDelta / 3600.0); // Convert to hours
-        }
-    }
-    powerData.energy = m_energyAccumulator;
-    m_lastTimestamp = powerData.timestamp;
-    
+    const SampleStamps stamps{readNs, PipelineLatency::nowNs()};
+
     // qDebug() << "Parsed BLE data - V:" << powerData.voltage << "A:" << powerData.current
     //          << "W:" << powerData.power << "E:" << powerData.energy;
-    
-    emit powerDataReceived(powerData);
-}
 
-PowerData BluetoothManager::parseJsonToPowerData(const QJsonObject &json)
-{
-    PowerData data;
-    
-    // Parse JSON fields from your device format
-    data.current = json.value("current").toDouble(0.0);
-    data.voltage = json.value("voltage").toDouble(0.0);
-    data.power = json.value("power").toDouble(0.0);
-    data.energy = json.value("charge").toDouble(0.0);
-    // You might need to convert charge to energy units here
-
-    // Use device timestamp if available, otherwise use current time
-    data.timestamp = json.value("timestamp").toVariant().toULongLong();
-    if (data.timestamp == 0) {
-        data.timestamp = QDateTime::currentMSecsSinceEpoch();
-    }
-    
-    return data;
+    emit powerDataReceived(powerData, stamps);
 }
@@ -6,9 +6,11 @@
 #include <QBluetoothDeviceInfo>
 #include <QLowEnergyController>
 #include <QLowEnergyService>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include "BleDecoder.h"
+#include "PipelineLatency.h"
 #include "PowerMonitor.h"
+#include "RawCapture.h"
+#include <atomic>
 
 QT_FORWARD_DECLARE_CLASS(QTimer)
 
@@ -23,12 +25,16 @@ public:
     void startScanning();
     void stopScanning();
     void disconnect();
+    // Notification payloads are also appended to the capture while it runs
+    void setCapture(RawCapture *capture) { m_capture = capture; }
+    // Notifications that did not decode, since construction; thread-safe
+    [[nodiscard]] quint64 parseErrors() const { return m_parseErrors.load(); }
 
   signals:
     void deviceConnected(const QString &deviceName);
     void deviceDisconnected();
     void dataReceived(const QByteArray &data);           // Keep raw data signal
-    void powerDataReceived(const PowerData &powerData); // Add parsed data signal
+    void powerDataReceived(const PowerData &powerData, const SampleStamps &stamps); // Add parsed data signal
 
 private slots:
     void onDeviceDiscovered(const QBluetoothDeviceInfo &info);
@@ -44,8 +50,7 @@ private slots:
 private:
     void connectToDevice(const QBluetoothDeviceInfo &device);
     void setupService();
-    void parseJsonAndEmitPowerData(const QByteArray &data);
-    static PowerData parseJsonToPowerData(const QJsonObject &json);
+    void parseJsonAndEmitPowerData(const QByteArray &data, quint64 timestampUs, quint64 readNs);
     
     QBluetoothDeviceDiscoveryAgent *m_discoveryAgent;
     QLowEnergyController *m_controller;
@@ -57,9 +62,10 @@ private:
     QTimer *m_scanTimer;
     bool m_isConnected = false;
     
-    // Energy accumulation for BLE data
-    double m_energyAccumulator = 0.0;
-    quint64 m_lastTimestamp = 0;
+    // Parses notifications and accumulates their energy
+    BleDecoder m_decoder;
+    RawCapture *m_capture = nullptr;
+    std::atomic<quint64> m_parseErrors{0};
     bool m_isActive;
 
     // USB Power OSD V2-BLE service and characteristic UUIDs
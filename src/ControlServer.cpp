@@ -0,0 +1,164 @@
+#include "ControlServer.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStringList>
+
+namespace {
+// A client that sends this much without a newline is not speaking the
+// protocol and is disconnected
+constexpr qint64 kMaxLineBytes = 1 << 20;
+
+// What call() returns for requests that get no response
+const QJsonValue kNoResponse(QJsonValue::Undefined);
+
+QJsonObject errorResponse(const QJsonValue &id, int code, const QString &message) {
+  return QJsonObject{{"jsonrpc", "2.0"},
+                     {"id", id},
+                     {"error", QJsonObject{{"code", code}, {"message", message}}}};
+}
+} // namespace
+
+ControlServer::ControlServer(QObject *parent) : QObject(parent) {
+  registerMethod("listMethods", [this](const QJsonObject &, QString *) -> QJsonValue {
+    QStringList names = m_methods.keys();
+    names.sort();
+    return QJsonArray::fromStringList(names);
+  });
+}
+
+ControlServer::~ControlServer() { close(); }
+
+void ControlServer::registerMethod(const QString &name, Method method) {
+  m_methods.insert(name, std::move(method));
+}
+
+bool ControlServer::listen(const QString &path, QString *error) {
+  close();
+  auto *server = new QLocalServer(this);
+  server->setSocketOptions(QLocalServer::UserAccessOption);
+  // A socket file left behind by a crashed instance
+  QLocalServer::removeServer(path);
+  if (!server->listen(path)) {
+    if (error) {
+      *error = "Cannot listen on " + path + ": " + server->errorString();
+    }
+    delete server;
+    return false;
+  }
+  connect(server, &QLocalServer::newConnection, this, [this, server] {
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+      connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+      connect(socket, &QLocalSocket::readyRead, this,
+              [this, socket] { onReadyRead(socket); });
+    }
+  });
+  qDebug() << "Accepting control requests on" << path;
+  m_server = server;
+  return true;
+}
+
+void ControlServer::close() {
+  if (!m_server) {
+    return;
+  }
+  // Clients are children of the server and go with it
+  delete m_server;
+  m_server = nullptr;
+}
+
+void ControlServer::onReadyRead(QLocalSocket *socket) {
+  bool answered = false;
+  while (socket->canReadLine()) {
+    const QByteArray line = socket->readLine().trimmed();
+    if (line.isEmpty()) {
+      continue;
+    }
+    const QByteArray response = handle(line);
+    if (!response.isEmpty()) {
+      socket->write(response + '\n');
+      answered = true;
+    }
+  }
+  if (socket->bytesAvailable() > kMaxLineBytes) {
+    socket->abort();
+    return;
+  }
+  // Written now rather than when the event loop gets to it, which is what
+  // keeps the round trip short
+  if (answered) {
+    socket->flush();
+  }
+}
+
+QByteArray ControlServer::handle(const QByteArray &line) {
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+  if (parseError.error != QJsonParseError::NoError) {
+    return QJsonDocument(errorResponse(QJsonValue::Null, kParseError,
+                                       parseError.errorString()))
+        .toJson(QJsonDocument::Compact);
+  }
+
+  if (document.isArray()) {
+    const QJsonArray requests = document.array();
+    if (requests.isEmpty()) {
+      return QJsonDocument(errorResponse(QJsonValue::Null, kInvalidRequest, "Empty batch"))
+          .toJson(QJsonDocument::Compact);
+    }
+    QJsonArray responses;
+    for (const QJsonValue &request : requests) {
+      const QJsonValue response = call(request);
+      if (!response.isUndefined()) {
+        responses.append(response);
+      }
+    }
+    return responses.isEmpty() ? QByteArray()
+                               : QJsonDocument(responses).toJson(QJsonDocument::Compact);
+  }
+
+  const QJsonValue response = call(document.object());
+  return response.isUndefined()
+             ? QByteArray()
+             : QJsonDocument(response.toObject()).toJson(QJsonDocument::Compact);
+}
+
+QJsonValue ControlServer::call(const QJsonValue &request) {
+  const QJsonObject object = request.toObject();
+  const QJsonValue id = object.value("id");
+  const QJsonValue method = object.value("method");
+  if (!request.isObject() || object.value("jsonrpc") != "2.0" || !method.isString()) {
+    return errorResponse(id.isUndefined() ? QJsonValue(QJsonValue::Null) : id,
+                         kInvalidRequest, "Invalid request");
+  }
+  // Notifications (no id) are carried out but not answered
+  const bool notification = id.isUndefined();
+
+  const auto found = m_methods.constFind(method.toString());
+  if (found == m_methods.constEnd()) {
+    return notification ? kNoResponse
+                        : errorResponse(id, kMethodNotFound,
+                                        "Unknown method " + method.toString());
+  }
+  const QJsonValue params = object.value("params");
+  if (!params.isUndefined() && !params.isObject()) {
+    return notification ? kNoResponse
+                        : errorResponse(id, kInvalidParams, "params must be an object");
+  }
+
+  QString error;
+  const QJsonValue result = (*found)(params.toObject(), &error);
+  if (notification) {
+    return kNoResponse;
+  }
+  if (!error.isEmpty()) {
+    return errorResponse(id, kMethodFailed, error);
+  }
+  return QJsonObject{{"jsonrpc", "2.0"},
+                     {"id", id},
+                     {"result", result.isUndefined() ? QJsonValue(QJsonValue::Null) : result}};
+}
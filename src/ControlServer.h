@@ -0,0 +1,64 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QObject>
+#include <QString>
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+class QLocalServer;
+class QLocalSocket;
+QT_END_NAMESPACE
+
+// Lets test scripts drive the application over a Unix domain socket with
+// JSON-RPC 2.0, one request or batch per line and one response line per
+// request that has an id. Methods are registered by the owner and run on
+// its thread between two events, so they may use the same objects as the
+// rest of it without locking; a call costs well under a millisecond unless
+// that thread is busy.
+class ControlServer : public QObject {
+  Q_OBJECT
+
+public:
+  // JSON-RPC error codes
+  static constexpr int kParseError = -32700;
+  static constexpr int kInvalidRequest = -32600;
+  static constexpr int kMethodNotFound = -32601;
+  static constexpr int kInvalidParams = -32602;
+  // Reported when a method sets its error message
+  static constexpr int kMethodFailed = -32000;
+
+  // Returns the result; a method that fails sets error and its result is
+  // ignored. params is empty if the request had none.
+  using Method = std::function<QJsonValue(const QJsonObject &params, QString *error)>;
+
+  explicit ControlServer(QObject *parent = nullptr);
+  ~ControlServer() override;
+
+  // Replaces a method of the same name
+  void registerMethod(const QString &name, Method method);
+
+  // Accepts clients on the socket at path, replacing a stale socket file;
+  // false with a message in error if it cannot be bound
+  bool listen(const QString &path, QString *error = nullptr);
+  // Disconnects all clients and removes the socket file
+  void close();
+  [[nodiscard]] bool isListening() const { return m_server != nullptr; }
+
+  // Answers one request or batch, as read from a line; empty if nothing is
+  // to be answered (only notifications)
+  [[nodiscard]] QByteArray handle(const QByteArray &line);
+
+private:
+  void onReadyRead(QLocalSocket *socket);
+  [[nodiscard]] QJsonValue call(const QJsonValue &request);
+
+  QLocalServer *m_server = nullptr;
+  QHash<QString, Method> m_methods;
+};
+
+#endif // CONTROLSERVER_H
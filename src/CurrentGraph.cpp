@@ -4,21 +4,43 @@
 #include "OsdSettings.h"
 #include "PowerDelivery.h"
 
+#include <QFontMetrics>
+#include <QMouseEvent>
+#include <QMutexLocker>
 #include <QPaintEvent>
 #include <QPainter>
+#include <QResizeEvent>
+#include <QStringList>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
 
 CurrentGraph::CurrentGraph(QWidget *parent, MeasurementHistory *history,
                            OsdSettings *settings)
     : QWidget(parent), history(history), settings(settings),
-      m_refreshTimer(new QTimer(this)) {
+      m_scheduler(new RepaintScheduler(this)),
+      m_renderThread(new QThread(this)), m_renderer(new GraphRenderer()) {
   setMinimumSize(200, 150);
   setAttribute(Qt::WA_OpaquePaintEvent); // optional perf hint
 
-  // Setup the refresh timer
-  connect(m_refreshTimer, &QTimer::timeout, this, &CurrentGraph::updateGraph);
+  // Rasterization runs on a worker thread, paintEvent only blits the result
+  m_renderThread->setObjectName("CurrentGraph renderer");
+  m_renderer->moveToThread(m_renderThread);
+  connect(m_renderer, &GraphRenderer::frameReady, this,
+          &CurrentGraph::onFrameReady);
+  connect(m_scheduler, &RepaintScheduler::frameDue, this,
+          &CurrentGraph::prepareFrame);
+  m_renderThread->start();
 
-  m_refreshTimer->start(50);
+  onColorsChanged();
 }
+
+CurrentGraph::~CurrentGraph() {
+  m_renderThread->quit();
+  m_renderThread->wait();
+  delete m_renderer;
+}
+
 double CurrentGraph::findLowBox(double min_current) {
   if (min_current < .1) {
     return 0.0;
@@ -53,40 +75,189 @@ double CurrentGraph::findHighBox(double max_current) {
   return ceil(max_current);
 }
 
-void CurrentGraph::updateGraph() {
-  // This slot is called by the timer to trigger a repaint
-  update(); // This schedules a paintEvent
+void CurrentGraph::onHistoryChanged() {
+  // Repaints are driven by new data only, rate-limited to the display refresh
+  m_scheduler->requestFrame();
 }
 
-void CurrentGraph::paintEvent(QPaintEvent *event) {
-  Q_UNUSED(event);
-  QPainter p(this);
-  p.setRenderHint(QPainter::Antialiasing, true);
+void CurrentGraph::onColorsChanged() {
+  for (int level = PowerDelivery::PD_NONE; level <= PowerDelivery::PD_48V;
+       ++level) {
+    m_levelColors[level] =
+        settings->voltsRgb(static_cast<PowerDelivery::PD_VOLTS>(level));
+  }
+  m_levelColors[PowerDelivery::PD_NONE] = QColor(255, 128, 128);
 
-  // Background
-  p.fillRect(rect(), QColor(30, 30, 30));
+  // Colors are baked into the backing store
+  m_needFull = true;
+  m_scheduler->requestFrame();
+}
 
-  // Only draw if we have data
+void CurrentGraph::setRecording(RecordingView *recording) {
+  m_recording = recording;
+  connect(recording, &RecordingView::indexProgress, this, [this](int percent) {
+    m_indexPercent = percent;
+    update();
+  });
+  connect(recording, &RecordingView::indexReady, m_scheduler,
+          &RepaintScheduler::requestFrame);
+  setCursor(Qt::OpenHandCursor);
+  setView(0.0, static_cast<double>(recording->sampleCount()));
+}
+
+void CurrentGraph::setView(double firstSample, double sampleCount) {
+  const auto total = static_cast<double>(m_recording->sampleCount());
+  sampleCount = std::clamp(sampleCount, std::min<double>(width(), total), total);
+  firstSample = std::clamp(firstSample, 0.0, total - sampleCount);
+  const auto count = static_cast<std::uint64_t>(std::llround(sampleCount));
+  const auto first = std::min(static_cast<std::uint64_t>(std::llround(firstSample)),
+                              m_recording->sampleCount() - count);
+  if (first == m_viewFirst && count == m_viewCount) {
+    return;
+  }
+  m_viewFirst = first;
+  m_viewCount = count;
+  emit viewChanged(first, count);
+  m_scheduler->requestFrame();
+}
+
+void CurrentGraph::wheelEvent(QWheelEvent *event) {
+  if (!m_recording || width() <= 0) {
+    QWidget::wheelEvent(event);
+    return;
+  }
+  // 120 units per notch, 20% per notch
+  const double factor = std::pow(0.8, event->angleDelta().y() / 120.0);
+  const double anchor = event->position().x() / width();
+  const double count = static_cast<double>(m_viewCount);
+  const double anchorSample = static_cast<double>(m_viewFirst) + anchor * count;
+  setView(anchorSample - anchor * count * factor, count * factor);
+  event->accept();
+}
+
+void CurrentGraph::mousePressEvent(QMouseEvent *event) {
+  if (!m_recording || event->button() != Qt::LeftButton) {
+    QWidget::mousePressEvent(event);
+    return;
+  }
+  m_dragging = true;
+  m_dragX = qRound(event->position().x());
+  m_dragFirst = m_viewFirst;
+  setCursor(Qt::ClosedHandCursor);
+}
+
+void CurrentGraph::mouseMoveEvent(QMouseEvent *event) {
+  if (!m_dragging || width() <= 0) {
+    QWidget::mouseMoveEvent(event);
+    return;
+  }
+  const double dx = event->position().x() - m_dragX;
+  setView(static_cast<double>(m_dragFirst) -
+              dx / width() * static_cast<double>(m_viewCount),
+          static_cast<double>(m_viewCount));
+}
+
+void CurrentGraph::mouseReleaseEvent(QMouseEvent *event) {
+  if (!m_dragging) {
+    QWidget::mouseReleaseEvent(event);
+    return;
+  }
+  m_dragging = false;
+  setCursor(Qt::OpenHandCursor);
+}
+
+void CurrentGraph::mouseDoubleClickEvent(QMouseEvent *event) {
+  if (!m_recording) {
+    QWidget::mouseDoubleClickEvent(event);
+    return;
+  }
+  setView(0.0, static_cast<double>(m_recording->sampleCount()));
+}
+
+void CurrentGraph::resizeEvent(QResizeEvent *event) {
+  QWidget::resizeEvent(event);
+  m_needFull = true;
+  m_scheduler->requestFrame();
+}
+
+// Runs at most once per display refresh: folds the new samples into the
+// pixel columns and hands the changed columns to the renderer
+void CurrentGraph::prepareFrame() {
+  if (m_recording) {
+    prepareRecordingFrame();
+    return;
+  }
+  QMutexLocker locker(m_historyLock);
   if (!history || history->is_empty()) {
-    p.setPen(Qt::white);
-    p.drawText(rect(), Qt::AlignCenter, "No Data");
+    if (!m_frame.isNull()) {
+      m_frame = QImage();
+      m_needFull = true;
+    }
+    update();
     return;
   }
 
-  // Get recent samples for smooth animation
-  const int maxSamples = width(); // One sample per pixel width
-  auto samples = history->lastNSamplesNewestFirst(maxSamples);
+  const auto synced = m_columns.sync(*history, width());
+  locker.unlock();
+  m_needFull = m_needFull || synced.rebuilt;
+  m_pendingChange = m_pendingChange || synced.changed;
+  m_pendingShift += synced.shifted;
+  submitFrame();
+}
 
-  if (samples.empty())
+// A zoomed or panned view shares no columns with the last frame, so every
+// recording frame is a full one
+void CurrentGraph::prepareRecordingFrame() {
+  // A narrower widget may now show fewer samples than columns
+  setView(static_cast<double>(m_viewFirst), static_cast<double>(m_viewCount));
+  m_viewColumns.assign(static_cast<std::size_t>(std::max(width(), 1)), GraphColumn{});
+  if (m_viewCount == 0 ||
+      !m_recording->columns(m_viewFirst, m_viewCount, m_viewColumns)) {
+    m_viewColumns.clear();
+    update();
     return;
+  }
+  m_needFull = true;
+  submitFrame();
+}
+
+int CurrentGraph::availableColumns() const {
+  return m_recording ? static_cast<int>(m_viewColumns.size())
+                     : m_columns.columnCount();
+}
 
-  // Find min/max for scaling
-  double minCurrent = std::numeric_limits<double>::max();
-  double maxCurrent = std::numeric_limits<double>::lowest();
+const GraphColumn &CurrentGraph::columnByAge(int age) const {
+  if (m_recording) {
+    return m_viewColumns[m_viewColumns.size() - 1 - static_cast<std::size_t>(age)];
+  }
+  return m_columns.atByAge(age);
+}
+
+bool CurrentGraph::columnsMinMax(double &minCurrent, double &maxCurrent) const {
+  if (!m_recording) {
+    return m_columns.minMax(minCurrent, maxCurrent);
+  }
+  bool found = false;
+  for (const auto &column : m_viewColumns) {
+    if (column.count == 0) {
+      continue;
+    }
+    minCurrent = found ? std::min<double>(minCurrent, column.min) : column.min;
+    maxCurrent = found ? std::max<double>(maxCurrent, column.max) : column.max;
+    found = true;
+  }
+  return found;
+}
+
+void CurrentGraph::submitFrame() {
+  if (m_renderBusy || (!m_needFull && !m_pendingChange)) {
+    return;
+  }
 
-  for (const auto &sample : samples) {
-    minCurrent = std::min(minCurrent, sample.current);
-    maxCurrent = std::max(maxCurrent, sample.current);
+  double minCurrent;
+  double maxCurrent;
+  if (!columnsMinMax(minCurrent, maxCurrent)) {
+    return;
   }
   minCurrent = findLowBox(minCurrent);
   maxCurrent = findHighBox(maxCurrent);
@@ -100,84 +271,171 @@ void CurrentGraph::paintEvent(QPaintEvent *event) {
   if (maxCurrent <= minCurrent) {
     maxCurrent = minCurrent + 0.01; // Avoid division by zero
   }
-  const int graphHeight = height() - 10; // Leave margin for labels
-  const int graphTop = 5;
 
-  QPen pen(Qt::darkGray, 1);
-  pen.setStyle(Qt::DotLine);
-  // Draw grid
-  p.setPen(pen);
-  p.setBrush(Qt::NoBrush);
-  p.setFont(QFont("Arial", 8));
+  // Only a rescale, resize or history reset requires a full re-render, and
+  // columns wider than a pixel cannot be scrolled by whole pixels
+  const int slots = m_recording ? static_cast<int>(m_viewColumns.size())
+                                : m_columns.slotCount();
+  GraphFrame frame;
+  frame.size = size();
+  frame.dpr = std::max(1, qRound(devicePixelRatioF()));
+  frame.minCurrent = minCurrent;
+  frame.maxCurrent = maxCurrent;
+  frame.full = m_needFull || frame.size != m_submitted.size ||
+               frame.dpr != m_submitted.dpr ||
+               minCurrent != m_submitted.minCurrent ||
+               maxCurrent != m_submitted.maxCurrent ||
+               m_pendingShift + 2 >= width() || slots != width();
+  frame.shifted = frame.full ? 0 : m_pendingShift;
+  frame.available = availableColumns();
+  frame.slots = slots;
+  frame.colors = m_levelColors;
 
-  for (float yy : {10.0, 9.0, 8.0, 7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.5, 0.25,
-                   0.1, 0.0}) {
-    if (yy >= minCurrent && yy <= maxCurrent) {
-      const int y = graphTop +
-        static_cast<int>((maxCurrent - yy) / (maxCurrent - minCurrent) * graphHeight);
+  const int count = frame.full ? availableColumns()
+                               : std::min(availableColumns(),
+                                          m_pendingShift + 2);
+  frame.columns.reserve(static_cast<std::size_t>(count));
+  for (int age = 0; age < count; ++age) {
+    frame.columns.push_back(columnByAge(age));
+  }
 
-      p.drawLine(1, y, width() - 1, y);
-      if (yy > 0.01)
-        p.drawText(1, y - 1, QString("%1A").arg(yy, 0, 'f', 2));
-    }
+  m_submitted.size = frame.size;
+  m_submitted.dpr = frame.dpr;
+  m_submitted.minCurrent = minCurrent;
+  m_submitted.maxCurrent = maxCurrent;
+  m_needFull = false;
+  m_pendingChange = false;
+  m_pendingShift = 0;
+  m_renderBusy = true;
+  m_frameSubmitted.start();
+  // A recording frame shows no live samples
+  if (m_pipelineLatency && !m_recording) {
+    m_submitted.through = m_pipelineLatency->insertedCount();
   }
 
-  // Draw the current graph
-
-  QPointF lastPoint;
-  bool hasLastPoint = false;
-
-  for (int i = 0; i < samples.size() && i < width(); ++i) {
-    const double current = samples[i].current;
-
-    const double voltage = samples[i].voltage;
-    auto pdVolts = PowerDelivery::getEnum(voltage);
-    switch (pdVolts) {
-    case PowerDelivery::PD_NONE:
-      p.setPen(QPen(QColor(255, 128, 128), 1)); // Red line
-      break;
-    case PowerDelivery::PD_5V:
-      p.setPen(QPen(settings->color_5v, 1)); // Green line
-      break;
-    case PowerDelivery::PD_9V:
-      p.setPen(QPen(settings->color_9v, 1)); // Blue line
-      break;
-    case PowerDelivery::PD_15V:
-      p.setPen(QPen(settings->color_15v, 1)); // Yellow line
-      break;
-    case PowerDelivery::PD_20V:
-      p.setPen(QPen(settings->color_20v, 1)); // Orange line
-      break;
-    case PowerDelivery::PD_28V:
-      p.setPen(QPen(settings->color_28v, 1)); // Purple line
-      break;
-    case PowerDelivery::PD_36V:
-      p.setPen(QPen(settings->color_36v, 1)); // Pink line
-      break;
-    case PowerDelivery::PD_48V:
-      p.setPen(QPen(settings->color_48v, 1)); // Brown line
-    }
+  QMetaObject::invokeMethod(
+      m_renderer,
+      [renderer = m_renderer, frame = std::move(frame)] {
+        renderer->render(frame);
+      },
+      Qt::QueuedConnection);
+}
 
-    // Scale to widget coordinates
-    const int x = width() - 1 - i; // Newest on right, oldest on left
-    const int y = graphTop + static_cast<int>((maxCurrent - current) /
-                                              (maxCurrent - minCurrent) * graphHeight);
+void CurrentGraph::onFrameReady(const QImage &image, double minCurrent,
+                                double maxCurrent) {
+  m_renderBusy = false;
+  m_frame = image;
+  m_frameMinCurrent = minCurrent;
+  m_frameMaxCurrent = maxCurrent;
+  m_frameUnpainted = true;
+  m_frameThrough = m_submitted.through;
+  update();
 
-    QPointF currentPoint(x, y);
+  // Data that arrived while rendering goes into the next frame
+  if (m_needFull || m_pendingChange) {
+    m_scheduler->requestFrame();
+  }
+}
 
-    if (hasLastPoint) {
-      p.drawLine(lastPoint, currentPoint);
+void CurrentGraph::paintEvent(QPaintEvent *event) {
+  Q_UNUSED(event);
+  QPainter p(this);
+
+  // Only draw if we have data
+  bool hasData = !m_viewColumns.empty();
+  if (!m_recording) {
+    QMutexLocker locker(m_historyLock);
+    hasData = history && !history->is_empty();
+  }
+  if (m_frame.isNull() || !hasData) {
+    p.fillRect(rect(), GraphRenderer::background);
+    p.setPen(Qt::white);
+    if (m_recording && !m_recording->isIndexed() && m_recording->sampleCount() > 0) {
+      p.drawText(rect(), Qt::AlignCenter,
+                 QString("Indexing %1%").arg(m_indexPercent));
+    } else {
+      p.drawText(rect(), Qt::AlignCenter, "No Data");
     }
+    return;
+  }
 
-    lastPoint = currentPoint;
-    hasLastPoint = true;
+  // A resize is pending in the renderer; show the last frame meanwhile
+  const QSize frameSize = m_frame.deviceIndependentSize().toSize();
+  if (frameSize != size()) {
+    p.fillRect(rect(), GraphRenderer::background);
   }
+  p.drawImage(0, 0, m_frame);
 
   // Draw scale labels
-  p.setPen(Qt::white);
+  p.setPen(Qt::darkGray);
+  p.setFont(QFont("Arial", 8));
+  for (float yy : GraphRenderer::gridLines) {
+    if (yy > 0.01 && yy >= m_frameMinCurrent && yy <= m_frameMaxCurrent) {
+      const int y = GraphRenderer::toY(yy, m_frameMinCurrent,
+                                       m_frameMaxCurrent, frameSize.height());
+      p.drawText(1, y - 1, QString("%1A").arg(yy, 0, 'f', 2));
+    }
+  }
+
+  if (m_frameUnpainted && m_paintLatency && m_frameSubmitted.isValid()) {
+    m_paintLatency->record(static_cast<std::uint64_t>(m_frameSubmitted.nsecsElapsed()));
+  }
+  if (m_frameUnpainted && m_pipelineLatency) {
+    m_pipelineLatency->drawn(m_frameThrough);
+  }
+  m_frameUnpainted = false;
 
-  // // Outline
-  // p.setPen(QPen(Qt::white, 1));
-  // p.setBrush(Qt::NoBrush);
-  // p.drawRect(rect().adjusted(0, 0, -1, -1));
+  if (m_latencyOverlay) {
+    drawLatencyOverlay(p);
+  }
+}
+
+void CurrentGraph::setLatencyOverlay(bool visible) {
+  m_latencyOverlay = visible;
+  update();
+}
+
+// Mean and estimated percentiles per stage, top right
+void CurrentGraph::drawLatencyOverlay(QPainter &p) const {
+  QStringList lines{QString("%1 %2 %3 %4 %5")
+                        .arg("stage ms", -16)
+                        .arg("mean", 7)
+                        .arg("p50", 7)
+                        .arg("p99", 7)
+                        .arg("n", 9)};
+  auto addLine = [&lines](const QString &name, const LatencyHistogram::Snapshot &snapshot) {
+    lines << QString("%1 %2 %3 %4 %5")
+                 .arg(name, -16)
+                 .arg(snapshot.meanUs() / 1000.0, 7, 'f', 2)
+                 .arg(snapshot.quantileUs(0.5) / 1000.0, 7, 'f', 2)
+                 .arg(snapshot.quantileUs(0.99) / 1000.0, 7, 'f', 2)
+                 .arg(snapshot.count, 9);
+  };
+  if (m_pipelineLatency) {
+    for (int stage = 0; stage < PipelineLatency::StageCount; ++stage) {
+      const auto id = static_cast<PipelineLatency::Stage>(stage);
+      addLine(PipelineLatency::stageName(id), m_pipelineLatency->snapshot(id));
+    }
+  }
+  if (m_paintLatency) {
+    addLine("submit_to_paint", m_paintLatency->snapshot());
+  }
+
+  QFont font("Monospace", 8);
+  font.setStyleHint(QFont::TypeWriter);
+  p.setFont(font);
+  const QFontMetrics metrics(font);
+  int textWidth = 0;
+  for (const QString &line : lines) {
+    textWidth = std::max(textWidth, metrics.horizontalAdvance(line));
+  }
+  const QRect box(width() - textWidth - 12, 4, textWidth + 8,
+                  metrics.height() * static_cast<int>(lines.size()) + 6);
+  p.fillRect(box, QColor(0, 0, 0, 180));
+  p.setPen(Qt::white);
+  int y = box.top() + 3 + metrics.ascent();
+  for (const QString &line : lines) {
+    p.drawText(box.left() + 4, y, line);
+    y += metrics.height();
+  }
 }
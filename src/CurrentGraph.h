@@ -1,23 +1,118 @@
 #pragma once
+#include "GraphColumns.h"
+#include "GraphRenderer.h"
+#include "LatencyHistogram.h"
 #include "MeasurementHistory.h"
 #include "OsdSettings.h"
+#include "PipelineLatency.h"
+#include "PowerDelivery.h"
+#include "RecordingView.h"
+#include "RepaintScheduler.h"
 
-#include <QTimer>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMutex>
+#include <QThread>
 #include <QWidget>
+#include <array>
+#include <vector>
 
 class CurrentGraph : public QWidget {
     Q_OBJECT
 public:
     explicit CurrentGraph(QWidget* parent, MeasurementHistory *history, OsdSettings *settings);
+    ~CurrentGraph() override;
+
+    // Shows a recording instead of the history: the mouse wheel zooms around
+    // the pointer, dragging pans and a double-click shows the whole file
+    void setRecording(RecordingView *recording);
+
+    // Records how long each frame takes from submission to the screen
+    void setPaintLatency(LatencyHistogram *histogram) { m_paintLatency = histogram; }
+    // Reports when the inserted samples are first drawn
+    void setPipelineLatency(PipelineLatency *latency) { m_pipelineLatency = latency; }
+    // Held while reading a history that another thread pushes to
+    void setHistoryLock(QMutex *lock) { m_historyLock = lock; }
+    // Shows the per-stage latencies on top of the graph
+    void setLatencyOverlay(bool visible);
+    [[nodiscard]] bool latencyOverlay() const { return m_latencyOverlay; }
+
+signals:
+    // Recording mode only
+    void viewChanged(quint64 firstSample, quint64 sampleCount);
+
+public slots:
+    // To be called whenever samples were pushed to or removed from the history
+    void onHistoryChanged();
+    // Picks up changed per-PD-level colors from the settings
+    void onColorsChanged();
 
 protected:
     double findLowBox(double min_current);
   double findHighBox(double max_current);
   void paintEvent(QPaintEvent* event) override;
+  void resizeEvent(QResizeEvent *event) override;
+  void wheelEvent(QWheelEvent *event) override;
+  void mousePressEvent(QMouseEvent *event) override;
+  void mouseMoveEvent(QMouseEvent *event) override;
+  void mouseReleaseEvent(QMouseEvent *event) override;
+  void mouseDoubleClickEvent(QMouseEvent *event) override;
 private slots:
-    void updateGraph();
+    void prepareFrame();
+    void onFrameReady(const QImage &image, double minCurrent, double maxCurrent);
 private:
+    void submitFrame();
+    void prepareRecordingFrame();
+    [[nodiscard]] int availableColumns() const;
+    [[nodiscard]] const GraphColumn &columnByAge(int age) const;
+    bool columnsMinMax(double &minCurrent, double &maxCurrent) const;
+    void drawLatencyOverlay(QPainter &p) const;
+    // Clamps to the recording and at least one sample per pixel column
+    void setView(double firstSample, double sampleCount);
+
     MeasurementHistory *history;
+    QMutex *m_historyLock = nullptr;
     OsdSettings * settings;
-    QTimer *m_refreshTimer;
+    RepaintScheduler *m_scheduler;
+    QThread *m_renderThread;
+    GraphRenderer *m_renderer;
+
+    GraphColumns m_columns;
+    std::array<QColor, PowerDelivery::PD_48V + 1> m_levelColors;
+
+    // Changes not yet handed to the renderer; at most one frame is in flight
+    bool m_renderBusy = false;
+    bool m_needFull = true;
+    bool m_pendingChange = false;
+    int m_pendingShift = 0;
+    struct {
+        QSize size;
+        int dpr = 0;
+        double minCurrent = 0.0;
+        double maxCurrent = 0.0;
+        // PipelineLatency::insertedCount() the frame is based on
+        std::uint64_t through = 0;
+    } m_submitted;
+
+    // Recording mode: visible range and its columns, oldest first
+    RecordingView *m_recording = nullptr;
+    std::uint64_t m_viewFirst = 0;
+    std::uint64_t m_viewCount = 0;
+    std::vector<GraphColumn> m_viewColumns;
+    int m_indexPercent = 0;
+    bool m_dragging = false;
+    int m_dragX = 0;
+    std::uint64_t m_dragFirst = 0;
+
+    // Last finished frame and the scale it was rendered with
+    QImage m_frame;
+    double m_frameMinCurrent = 0.0;
+    double m_frameMaxCurrent = 0.0;
+
+    LatencyHistogram *m_paintLatency = nullptr;
+    QElapsedTimer m_frameSubmitted;
+    bool m_frameUnpainted = false;
+    PipelineLatency *m_pipelineLatency = nullptr;
+    std::uint64_t m_frameThrough = 0;
+    bool m_latencyOverlay = false;
 };
@@ -1,14 +1,19 @@
 #include "DeviceManager.h"
 
-#include "MainWindow.h"
 #include "PowerMonitor.h"
 #include <QDebug>
+#include <QFileInfo>
+#include <QMutexLocker>
 
 DeviceManager::DeviceManager(QObject *parent)
     : QObject(parent), m_bluetoothManager(new BluetoothManager(this)),
       m_serialManager(new SerialManager()),
       m_serialThread(new QThread(this)),
-      m_powerMonitor(new PowerMonitor(this)) {
+      m_powerMonitor(new PowerMonitor(this)),
+      m_replayManager(new ReplayManager(this)),
+      m_rawCapture(new RawCapture(this)) {
+  m_bluetoothManager->setCapture(m_rawCapture);
+  m_serialManager->setCapture(m_rawCapture);
   m_serialManager->moveToThread(m_serialThread);
 
   // Connect Bluetooth signals
@@ -21,9 +26,10 @@ DeviceManager::DeviceManager(QObject *parent)
 
   // NEW: Connect to parsed power data from Bluetooth
   connect(m_bluetoothManager, &BluetoothManager::powerDataReceived, this,
-          [this](const PowerData &data) {
+          [this](const PowerData &data, const SampleStamps &stamps) {
             // Forward the parsed power data directly
-            emit powerDataReceived(data);
+            emitSampleAcquired(data);
+            emit powerDataReceived(data, stamps);
           });
 
   // Connect Serial signals
@@ -33,20 +39,46 @@ DeviceManager::DeviceManager(QObject *parent)
           &DeviceManager::onSerialDeviceDisconnected);
   connect(m_serialManager, &SerialManager::dataReceived, this,
           &DeviceManager::onSerialDataReceived);
+  connect(
+      m_serialManager, &SerialManager::dataReceived, this,
+      [this](const PowerData &data) { emitSampleAcquired(data); },
+      Qt::DirectConnection);
+
+  // Replayed samples take the same two paths as serial ones
+  connect(m_replayManager, &ReplayManager::dataReceived, this,
+          &DeviceManager::onReplayDataReceived);
+  connect(
+      m_replayManager, &ReplayManager::dataReceived, this,
+      [this](const PowerData &data) { emitSampleAcquired(data); },
+      Qt::DirectConnection);
+  connect(m_replayManager, &ReplayManager::finished, this,
+          &DeviceManager::onReplayFinished);
 
   // Forward power data signals from PowerMonitor (for serial data)
   connect(m_powerMonitor, &PowerMonitor::powerDataReceived, this,
-          [this](const PowerData &data) { emit powerDataReceived(data); });
+          [this](const PowerData &data) { emit powerDataReceived(data, SampleStamps{}); });
 
   m_serialThread->start();
 }
 
 DeviceManager::~DeviceManager() {
+  // No replayFinished()/deviceDisconnected() while tearing down
+  m_replayManager->disconnect(this);
+  m_replayManager->stop();
+  qDeleteAll(m_meters);
+  m_meters.clear();
   m_serialThread->quit();
   m_serialThread->wait();
   delete m_serialManager;
 }
 
+// The serial thread, the GUI thread (BLE) and the replay worker all acquire
+// samples, and the old source may still deliver while the next one starts
+void DeviceManager::emitSampleAcquired(const PowerData &data) {
+  QMutexLocker locker(&m_sampleAcquiredMutex);
+  emit sampleAcquired(data);
+}
+
 void DeviceManager::startBtScanning() {
   m_bluetoothManager->startScanning();
   QMetaObject::invokeMethod(m_serialManager, "disconnect", Qt::QueuedConnection);
@@ -60,6 +92,9 @@ void DeviceManager::stopBtScanning() {
 
 bool DeviceManager::tryConnect(const QString &portName) {
   //qDebug() << "DeviceManager::tryConnect: Trying to connect to " << portName;
+  if (m_isReplaying) {
+    return false;
+  }
   if (portName.startsWith("ble")) {
     m_bluetoothManager->startScanning();
     return true;
@@ -76,24 +111,93 @@ bool DeviceManager::tryConnect(const QString &portName) {
 
   return false;
 }
+bool DeviceManager::startReplay(const QString &path, double speed,
+                                QString *error) {
+  stopReplay();
+  // An unreadable file leaves the live device connected
+  if (!ReplayManager::isReplayable(path, error)) {
+    return false;
+  }
+  // Set first, so the disconnects below are not reported or reconnected
+  m_isReplaying = true;
+  // The live sources have stopped delivering before the replay starts
+  m_bluetoothManager->stopScanning();
+  m_bluetoothManager->disconnect();
+  m_isBluetoothConnected = false;
+  m_isSerialConnected = false;
+  QMetaObject::invokeMethod(m_serialManager, "disconnect",
+                            Qt::BlockingQueuedConnection);
+  if (!m_replayManager->start(path, speed, error)) {
+    m_isReplaying = false;
+    emit deviceDisconnected();
+    return false;
+  }
+  emit deviceConnected(QFileInfo(path).fileName() + " (Replay)");
+  return true;
+}
+
+void DeviceManager::stopReplay() {
+  // Emits finished(), which ends the replay in onReplayFinished()
+  m_replayManager->stop();
+}
+
+MeterChannel *DeviceManager::addMeter(const QString &portName,
+                                      std::size_t historyCapacity) {
+  if (portName.isEmpty() || portName.startsWith("ble") ||
+      (m_isSerialConnected && portName == m_serialDevice)) {
+    return nullptr;
+  }
+  for (auto *meter : m_meters) {
+    if (meter->portName() == portName) {
+      return meter;
+    }
+  }
+
+  auto *meter = new MeterChannel(portName, historyCapacity, this);
+  m_meters.append(meter);
+  emit meterAdded(meter);
+  meter->open();
+  return meter;
+}
+
+void DeviceManager::removeMeter(const QString &portName) {
+  for (int i = 0; i < m_meters.size(); ++i) {
+    if (m_meters[i]->portName() == portName) {
+      auto *meter = m_meters.takeAt(i);
+      emit meterRemoved(portName);
+      meter->shutdown();
+      return;
+    }
+  }
+}
+
 bool DeviceManager::isBLEAutoConnect() const {
   return m_isBluetoothConnected;
 }
 
+QString DeviceManager::protocolName() const {
+  if (m_isReplaying) {
+    return "Replay";
+  }
+  if (m_isBluetoothConnected) {
+    return "BLE";
+  }
+  return m_serialManager->protocolName();
+}
+
 void DeviceManager::onBluetoothDeviceConnected(const QString &deviceName) {
   m_isBluetoothConnected = true;
   if (this->m_isSerialConnected) {
     m_isSerialConnected = false;
     QMetaObject::invokeMethod(m_serialManager, "disconnect", Qt::QueuedConnection);
   }
-  this->m_settings->last_device = "ble";
-  this->m_settings->saveSettings();
+  emit lastDeviceChanged("ble");
   emit deviceConnected(deviceName + " (Bluetooth)");
 }
 
 void DeviceManager::onBluetoothDeviceDisconnected() {
   m_isBluetoothConnected = false;
-  if (!m_isSerialConnected) {
+  if (!m_isSerialConnected && !m_isReplaying) {
     emit deviceDisconnected();
   }
 }
@@ -101,8 +205,8 @@ void DeviceManager::onBluetoothDeviceDisconnected() {
 void DeviceManager::onSerialDeviceConnected(const QString &deviceName) {
   m_isSerialConnected = true;
   m_isBluetoothConnected = false;
-  this->m_settings->last_device = deviceName;
-  this->m_settings->saveSettings();
+  m_serialDevice = deviceName;
+  emit lastDeviceChanged(deviceName);
   this->m_bluetoothManager->stopScanning();
   this->m_bluetoothManager->disconnect();
   emit deviceConnected(deviceName + " (Serial)");
@@ -110,14 +214,36 @@ void DeviceManager::onSerialDeviceConnected(const QString &deviceName) {
 
 void DeviceManager::onSerialDeviceDisconnected() {
   m_isSerialConnected = false;
+  if (m_isReplaying) {
+    return;
+  }
   if (!m_isBluetoothConnected) {
     emit deviceDisconnected();
   }
-    if (auto *mw = qobject_cast<MainWindow*>(parent())) {
-        mw->startReconnectTimer();
-    }
+  emit reconnectRequested();
+}
+
+void DeviceManager::onSerialDataReceived(const PowerData &data,
+                                         const SampleStamps &stamps) {
+  emit powerDataReceived(data, stamps);
 }
 
-void DeviceManager::onSerialDataReceived(const PowerData &data) {
-  emit powerDataReceived(data);
+void DeviceManager::onReplayDataReceived(const PowerData &data,
+                                         const SampleStamps &stamps,
+                                         quint64 generation) {
+  // Still queued when the replay was stopped; the live meter took over
+  if (!m_replayManager->sampleConsumed(generation)) {
+    return;
+  }
+  emit powerDataReceived(data, stamps);
+}
+
+void DeviceManager::onReplayFinished(quint64 samples, qint64 elapsedMs,
+                                     bool completed) {
+  if (!m_isReplaying) {
+    return;
+  }
+  m_isReplaying = false;
+  emit deviceDisconnected();
+  emit replayFinished(samples, elapsedMs, completed);
 }
@@ -2,9 +2,13 @@
 #define DEVICEMANAGER_H
 
 #include "BluetoothManager.h"
-#include "OsdSettings.h"
+#include "MeterChannel.h"
 #include "PowerMonitor.h"
+#include "RawCapture.h"
+#include "ReplayManager.h"
 #include "SerialManager.h"
+#include <QList>
+#include <QMutex>
 #include <QObject>
 #include <QThread>
 
@@ -18,30 +22,78 @@ public:
   void startBtScanning();
   void stopBtScanning();
   bool tryConnect(const QString &portName);
-  void setSettings(OsdSettings *settings) { m_settings = settings; }
   bool isBLEAutoConnect() const;
+  // Protocol of the connected primary device, e.g. "PLD28" or "BLE"
+  [[nodiscard]] QString protocolName() const;
+
+  // Replaces the primary device with a recording played back at the given
+  // speed (0 = as fast as possible) until it ends or stopReplay() is called.
+  // Live devices are disconnected meanwhile and not reconnected.
+  bool startReplay(const QString &path, double speed, QString *error = nullptr);
+  void stopReplay();
+  [[nodiscard]] bool isReplaying() const { return m_isReplaying; }
+
+  // Undecodable serial lines and BLE notifications of the primary device;
+  // thread-safe
+  [[nodiscard]] quint64 serialParseErrors() const { return m_serialManager->parseErrors(); }
+  [[nodiscard]] quint64 bleParseErrors() const { return m_bluetoothManager->parseErrors(); }
+
+  // Tees the bytes of the primary device's transport into a capture file
+  [[nodiscard]] RawCapture *rawCapture() const { return m_rawCapture; }
+
+  // Additional meters, monitored concurrently with the primary device
+  MeterChannel *addMeter(const QString &portName, std::size_t historyCapacity);
+  void removeMeter(const QString &portName);
+  [[nodiscard]] const QList<MeterChannel *> &meters() const { return m_meters; }
 
 signals:
   void deviceConnected(const QString &deviceName);
   void deviceDisconnected();
-  void powerDataReceived(const PowerData &powerData); // Add this signal
+  // The serial device went away; the owner should retry connecting it
+  void reconnectRequested();
+  // A device connected and should be remembered for the next start;
+  // "ble" for Bluetooth, else the serial port
+  void lastDeviceChanged(const QString &device);
+  void powerDataReceived(const PowerData &powerData, const SampleStamps &stamps); // Add this signal
+  // Same samples as powerDataReceived, but emitted on the thread that
+  // acquired them. Connect with Qt::DirectConnection to see a sample without
+  // waiting for the GUI event loop; receivers must be fast. Emissions never
+  // overlap, even while one transport hands over to another, so receivers
+  // may treat it as a single producer.
+  void sampleAcquired(const PowerData &powerData);
+  // After the last replayed sample was delivered, or the replay was stopped
+  void replayFinished(quint64 samples, qint64 elapsedMs, bool completed);
+  void meterAdded(MeterChannel *meter);
+  void meterRemoved(const QString &portName);
 
 private slots:
   void onBluetoothDeviceConnected(const QString &deviceName);
   void onBluetoothDeviceDisconnected();
   void onSerialDeviceConnected(const QString &deviceName);
   void onSerialDeviceDisconnected();
-  void onSerialDataReceived(const PowerData &data);
+  void onSerialDataReceived(const PowerData &data, const SampleStamps &stamps);
+  void onReplayDataReceived(const PowerData &data, const SampleStamps &stamps,
+                            quint64 generation);
+  void onReplayFinished(quint64 samples, qint64 elapsedMs, bool completed);
 
 private:
+  void emitSampleAcquired(const PowerData &data);
+
   BluetoothManager *m_bluetoothManager;
   SerialManager *m_serialManager;
   QThread *m_serialThread;
   PowerMonitor *m_powerMonitor;
-  OsdSettings *m_settings = nullptr;
+  ReplayManager *m_replayManager;
+  RawCapture *m_rawCapture;
+  // Port of the connected primary serial device
+  QString m_serialDevice;
+  QList<MeterChannel *> m_meters;
+  // Held while emitting sampleAcquired()
+  QMutex m_sampleAcquiredMutex;
 
   bool m_isBluetoothConnected = false;
   bool m_isSerialConnected = false;
+  bool m_isReplaying = false;
 };
 
 #endif // DEVICEMANAGER_H
@@ -0,0 +1,139 @@
+#include "GraphColumns.h"
+
+#include <algorithm>
+#include <limits>
+
+void GraphColumn::add(float current, PowerDelivery::PD_VOLTS sampleLevel) noexcept {
+    if (count == 0) {
+        *this = GraphColumn{current, current, current, current, 1, sampleLevel, false};
+        return;
+    }
+    if (current < min) {
+        min = current;
+        maxIsLast = false;
+    }
+    if (current > max) {
+        max = current;
+        maxIsLast = true;
+    }
+    last = current;
+    level = sampleLevel;
+    ++count;
+}
+
+void GraphColumn::append(const GraphColumn &later) noexcept {
+    if (later.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = later;
+        return;
+    }
+    // Like add(), ties keep the earlier extreme
+    const bool minFromLater = later.min < min;
+    const bool maxFromLater = later.max > max;
+    if (minFromLater != maxFromLater) {
+        maxIsLast = maxFromLater;
+    } else if (minFromLater) {
+        maxIsLast = later.maxIsLast;
+    }
+    if (minFromLater) {
+        min = later.min;
+    }
+    if (maxFromLater) {
+        max = later.max;
+    }
+    last = later.last;
+    level = later.level;
+    count += later.count;
+}
+
+GraphColumns::Update GraphColumns::sync(const MeasurementHistory &history,
+                                        int width) {
+    Update update;
+    if (width <= 0) {
+        return update;
+    }
+
+    const std::uint64_t fresh = history.pushCount() - m_pushCount;
+    if (width != m_width || history.capacity() != m_capacity ||
+        history.epoch() != m_epoch || fresh > history.size()) {
+        rebuild(history, width);
+        update.rebuilt = true;
+        update.changed = true;
+        return update;
+    }
+    if (fresh == 0) {
+        return update;
+    }
+
+    const bool hadColumns = m_valid > 0;
+    const std::uint64_t newestBefore = m_newestColumn;
+    history.forEachLastNOldestFirst(fresh, [this](const PowerData &sample, PowerDelivery::PD_VOLTS level) { add(sample, level); });
+    dropEvicted(history);
+
+    update.changed = true;
+    update.shifted = hadColumns
+        ? static_cast<int>(std::min<std::uint64_t>(m_newestColumn - newestBefore,
+                                                   static_cast<std::uint64_t>(m_slots)))
+        : m_slots;
+    return update;
+}
+
+const GraphColumn &GraphColumns::atByAge(int age) const {
+    return m_ring[(m_newestColumn - static_cast<std::uint64_t>(age)) % m_ring.size()];
+}
+
+bool GraphColumns::minMax(double &outMin, double &outMax) const noexcept {
+    if (m_valid == 0) {
+        return false;
+    }
+    float minValue = std::numeric_limits<float>::infinity();
+    float maxValue = -std::numeric_limits<float>::infinity();
+    for (int age = 0; age < m_valid; ++age) {
+        const GraphColumn &column = atByAge(age);
+        minValue = std::min(minValue, column.min);
+        maxValue = std::max(maxValue, column.max);
+    }
+    outMin = minValue;
+    outMax = maxValue;
+    return true;
+}
+
+void GraphColumns::rebuild(const MeasurementHistory &history, int width) {
+    m_width = width;
+    m_capacity = std::max<std::size_t>(1, history.capacity());
+    m_slots = static_cast<int>(std::min<std::size_t>(static_cast<std::size_t>(width), m_capacity));
+    m_ring.assign(static_cast<std::size_t>(m_slots), GraphColumn{});
+    m_valid = 0;
+    m_epoch = history.epoch();
+    m_pushCount = history.pushCount() - history.size();
+    m_newestColumn = 0;
+    history.forEachLastNOldestFirst(history.size(), [this](const PowerData &sample, PowerDelivery::PD_VOLTS level) { add(sample, level); });
+}
+
+// The oldest column stays while any of its samples is still in the history
+void GraphColumns::dropEvicted(const MeasurementHistory &history) noexcept {
+    if (m_valid == 0 || history.is_empty()) {
+        m_valid = 0;
+        return;
+    }
+    const std::uint64_t oldestColumn = columnOf(history.pushCount() - history.size());
+    m_valid = static_cast<int>(
+        std::min<std::uint64_t>(static_cast<std::uint64_t>(m_valid),
+                                m_newestColumn - oldestColumn + 1));
+}
+
+void GraphColumns::add(const PowerData &sample, PowerDelivery::PD_VOLTS level) noexcept {
+    const std::uint64_t columnIndex = columnOf(m_pushCount);
+    const auto current = static_cast<float>(sample.current);
+    GraphColumn &column = m_ring[columnIndex % m_ring.size()];
+
+    if (m_valid == 0 || columnIndex != m_newestColumn) {
+        column = GraphColumn{};
+        m_newestColumn = columnIndex;
+        m_valid = std::min(m_valid + 1, m_slots);
+    }
+    column.add(current, level);
+    ++m_pushCount;
+}
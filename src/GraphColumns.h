@@ -0,0 +1,83 @@
+#ifndef GRAPHCOLUMNS_H
+#define GRAPHCOLUMNS_H
+
+#include "MeasurementHistory.h"
+#include "PowerDelivery.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief M4 aggregate of all samples that fall into one pixel column.
+ *
+ * Drawing first -> min/max (in the order they occurred) -> last per column
+ * reproduces the exact visual envelope of the raw trace, so short spikes are
+ * never lost when there are more samples than pixels.
+ */
+struct GraphColumn {
+    float first = 0.0f;
+    float last = 0.0f;
+    float min = 0.0f;
+    float max = 0.0f;
+    std::uint32_t count = 0;
+    PowerDelivery::PD_VOLTS level = PowerDelivery::PD_NONE; // of the newest sample
+    bool maxIsLast = false; // the maximum was reached after the minimum
+
+    // Folds in a sample that occurred after all samples of this column
+    void add(float current, PowerDelivery::PD_VOLTS sampleLevel) noexcept;
+    // Folds in the aggregate of samples that occurred after this column's
+    void append(const GraphColumn &later) noexcept;
+};
+
+/**
+ * @brief Incrementally maintained per-pixel-column decimation of a MeasurementHistory.
+ *
+ * The whole capacity is mapped onto one column per pixel, so a full history
+ * spans the width. Sample k of all samples ever pushed falls into column
+ * k * slots / capacity; a column covers a fractional number of samples, and
+ * the mapping does not change while the history fills up. With fewer samples
+ * than pixels there is one column per sample, stretched across the width.
+ * Columns are aligned to absolute sample indices: new samples only touch the
+ * newest columns, which lets CurrentGraph scroll its backing store by whole
+ * columns. A full rebuild is only needed
+ * after a resize, capacity change or reset. Columns whose samples were all
+ * evicted from the history are dropped, so the columns never show more than
+ * the history holds.
+ */
+class GraphColumns {
+public:
+    struct Update {
+        bool rebuilt = false; // all columns were recomputed
+        bool changed = false; // at least the newest column changed
+        int shifted = 0;      // number of columns that started since the last sync
+    };
+
+    Update sync(const MeasurementHistory &history, int width);
+
+    [[nodiscard]] int columnCount() const noexcept { return m_valid; }
+    // Column positions across the width: the width, or the capacity if that
+    // is smaller
+    [[nodiscard]] int slotCount() const noexcept { return m_slots; }
+    // 0 = newest (rightmost) column
+    [[nodiscard]] const GraphColumn &atByAge(int age) const;
+    bool minMax(double &outMin, double &outMax) const noexcept;
+
+private:
+    void rebuild(const MeasurementHistory &history, int width);
+    [[nodiscard]] std::uint64_t columnOf(std::uint64_t sample) const noexcept {
+        return sample * static_cast<std::uint64_t>(m_slots) / m_capacity;
+    }
+    void add(const PowerData &sample, PowerDelivery::PD_VOLTS level) noexcept;
+    void dropEvicted(const MeasurementHistory &history) noexcept;
+
+    std::vector<GraphColumn> m_ring;
+    int m_width = 0;
+    int m_slots = 0;
+    int m_valid = 0;
+    std::size_t m_capacity = 0;
+    std::uint64_t m_epoch = 0;
+    std::uint64_t m_pushCount = 0; // absolute index of the next sample
+    std::uint64_t m_newestColumn = 0;
+};
+
+#endif // GRAPHCOLUMNS_H
@@ -0,0 +1,166 @@
+#include "GraphRenderer.h"
+
+#include <QPainter>
+#include <QPolygonF>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const int kGraphTop = 5;
+}
+
+const std::array<float, 14> GraphRenderer::gridLines = {
+    10.0, 9.0, 8.0, 7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.5, 0.25, 0.1, 0.0};
+const QColor GraphRenderer::background(30, 30, 30);
+
+int GraphRenderer::toY(double current, double minCurrent, double maxCurrent,
+                       int height) {
+  const int graphHeight = height - 10; // Leave margin for labels
+  return kGraphTop + static_cast<int>((maxCurrent - current) /
+                                      (maxCurrent - minCurrent) *
+                                      graphHeight);
+}
+
+void GraphRenderer::render(const GraphFrame &frame) {
+  updatePens(frame);
+  // At most one frame is in flight, so the GUI has let go of the back image
+  const QImage &previous = m_traces[m_front];
+  QImage &trace = m_traces[1 - m_front];
+  const QSize size = frame.size * frame.dpr;
+  if (trace.size() != size) {
+    trace = QImage(size, QImage::Format_RGB32);
+  }
+  trace.setDevicePixelRatio(frame.dpr);
+  if (frame.full || previous.size() != size) {
+    renderFull(frame, trace);
+  } else {
+    scrollTrace(frame, previous, trace);
+  }
+  m_front = 1 - m_front;
+  emit frameReady(trace, frame.minCurrent, frame.maxCurrent);
+}
+
+void GraphRenderer::updatePens(const GraphFrame &frame) {
+  if (frame.colors == m_colors) {
+    return;
+  }
+  m_colors = frame.colors;
+  for (std::size_t level = 0; level < m_colors.size(); ++level) {
+    m_levelPens[level] = QPen(m_colors[level], 1);
+  }
+}
+
+void GraphRenderer::drawGrid(QPainter &p, const GraphFrame &frame, int fromX,
+                             int toX) const {
+  QPen pen(Qt::darkGray, 1);
+  pen.setStyle(Qt::DotLine);
+  p.setPen(pen);
+  p.setBrush(Qt::NoBrush);
+
+  const int width = frame.size.width();
+  for (float yy : gridLines) {
+    if (yy >= frame.minCurrent && yy <= frame.maxCurrent) {
+      const int y = toY(yy, frame.minCurrent, frame.maxCurrent,
+                        frame.size.height());
+      p.drawLine(std::max(fromX, 1), y, std::min(toX, width - 1), y);
+    }
+  }
+}
+
+// Draws the trace through the newest `count` columns, newest on the right
+// edge. Each column contributes its M4 points (first, min/max in the order
+// they occurred, last), so the envelope of all samples in a pixel column is
+// exact. Consecutive columns on the same PD level form one polyline, so pen
+// changes and draw calls scale with voltage transitions, not samples. A
+// segment between columns takes the color of the older column.
+void GraphRenderer::drawColumns(QPainter &p, const GraphFrame &frame,
+                                int count) const {
+  count = std::min(count, static_cast<int>(frame.columns.size()));
+  if (count <= 0) {
+    return;
+  }
+
+  QPolygonF run;
+  run.reserve(static_cast<qsizetype>(count) * 4);
+  auto flushRun = [&p, &run, this](PowerDelivery::PD_VOLTS level) {
+    if (run.size() > 1) {
+      p.setPen(m_levelPens[level]);
+      p.drawPolyline(run);
+    }
+  };
+  auto toY = [&frame](float current) {
+    return GraphRenderer::toY(current, frame.minCurrent, frame.maxCurrent,
+                              frame.size.height());
+  };
+
+  const int right = frame.size.width() - 1; // Newest on right, oldest on left
+  const qreal step = frame.slots > 0 ? static_cast<qreal>(frame.size.width()) / frame.slots
+                                     : 1.0;
+  auto runLevel = frame.columns[0].level;
+  for (int age = 0; age < count; ++age) {
+    const GraphColumn &column = frame.columns[age];
+    if (column.level != runLevel) {
+      flushRun(runLevel);
+      const QPointF joint = run.last();
+      run.clear();
+      run.append(joint);
+      runLevel = column.level;
+    }
+
+    // Walking backwards in time: last, extremes, first
+    const qreal x = right - age * step;
+    run.append(QPointF(x, toY(column.last)));
+    if (column.count > 1) {
+      if (column.maxIsLast) {
+        run.append(QPointF(x, toY(column.max)));
+        run.append(QPointF(x, toY(column.min)));
+      } else {
+        run.append(QPointF(x, toY(column.min)));
+        run.append(QPointF(x, toY(column.max)));
+      }
+      run.append(QPointF(x, toY(column.first)));
+    }
+  }
+  flushRun(runLevel);
+}
+
+void GraphRenderer::renderFull(const GraphFrame &frame, QImage &trace) {
+  trace.fill(background);
+
+  QPainter p(&trace);
+  p.setRenderHint(QPainter::Antialiasing, true);
+  drawGrid(p, frame, 0, frame.size.width());
+  drawColumns(p, frame, static_cast<int>(frame.columns.size()));
+}
+
+// Copies the previous trace `shifted` pixels to the left and redraws the
+// uncovered columns plus the previously newest one, which may have received
+// further samples
+void GraphRenderer::scrollTrace(const GraphFrame &frame, const QImage &previous,
+                                QImage &trace) {
+  const int shift = frame.shifted * frame.dpr;
+  const qsizetype bytesPerPixel = trace.depth() / 8;
+  const qsizetype keptBytes = (trace.width() - shift) * bytesPerPixel;
+  for (int y = 0; y < trace.height(); ++y) {
+    std::memcpy(trace.scanLine(y),
+                previous.constScanLine(y) + shift * bytesPerPixel, keptBytes);
+  }
+
+  const int width = frame.size.width();
+  const int dirty = frame.shifted + 1;
+  QPainter p(&trace);
+  p.fillRect(QRect(width - dirty, 0, dirty, frame.size.height()), background);
+  p.setRenderHint(QPainter::Antialiasing, true);
+  drawGrid(p, frame, width - dirty - 1, width);
+  // One extra column connects the new segments to the existing trace
+  drawColumns(p, frame, dirty + 1);
+
+  // Columns whose samples left the history scrolled past the oldest one
+  const int oldestX = width - frame.available;
+  if (oldestX > 0) {
+    const int staleX = std::max(0, oldestX - frame.shifted - 1);
+    p.setRenderHint(QPainter::Antialiasing, false);
+    p.fillRect(QRect(staleX, 0, oldestX - staleX, frame.size.height()), background);
+    drawGrid(p, frame, staleX, oldestX);
+  }
+}
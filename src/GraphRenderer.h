@@ -0,0 +1,73 @@
+#ifndef GRAPHRENDERER_H
+#define GRAPHRENDERER_H
+
+#include "GraphColumns.h"
+#include "PowerDelivery.h"
+
+#include <QColor>
+#include <QImage>
+#include <QObject>
+#include <QPen>
+#include <array>
+#include <vector>
+
+// Everything the renderer needs for one frame, copied on the GUI thread so
+// the worker never touches MeasurementHistory or OsdSettings.
+struct GraphFrame {
+  QSize size;
+  int dpr = 1;
+  double minCurrent = 0.0;
+  double maxCurrent = 0.0;
+  // Full re-render, or scroll by `shifted` columns and redraw the newest ones
+  bool full = true;
+  int shifted = 0;
+  // Columns holding samples; the pixel columns left of them stay blank
+  int available = 0;
+  // Column positions across the width, each width / slots pixels wide;
+  // 0 for one per pixel. Only full frames stretch columns.
+  int slots = 0;
+  // Newest first: all columns for a full render, the dirty ones otherwise
+  std::vector<GraphColumn> columns;
+  std::array<QColor, PowerDelivery::PD_48V + 1> colors;
+};
+
+// Rasterizes the current graph into a persistent QImage on a worker thread.
+// Grid and trace are kept in the backing store and scrolled left as columns
+// fill up, so an incremental frame only draws the new columns. The store is
+// double-buffered: the GUI keeps the last frame while the next one is drawn
+// into the other image, so neither image is ever detached and copied.
+class GraphRenderer : public QObject {
+  Q_OBJECT
+
+public:
+  using QObject::QObject;
+
+  static int toY(double current, double minCurrent, double maxCurrent,
+                 int height);
+
+  // Grid values in Ampere, also used by CurrentGraph for the scale labels
+  static const std::array<float, 14> gridLines;
+  static const QColor background;
+
+  void render(const GraphFrame &frame);
+
+signals:
+  void frameReady(const QImage &image, double minCurrent, double maxCurrent);
+
+private:
+  void renderFull(const GraphFrame &frame, QImage &trace);
+  void scrollTrace(const GraphFrame &frame, const QImage &previous,
+                   QImage &trace);
+  void drawGrid(QPainter &p, const GraphFrame &frame, int fromX,
+                int toX) const;
+  void drawColumns(QPainter &p, const GraphFrame &frame, int count) const;
+  void updatePens(const GraphFrame &frame);
+
+  // The front image was handed to the GUI; the back one is drawn next
+  std::array<QImage, 2> m_traces;
+  int m_front = 0;
+  std::array<QColor, PowerDelivery::PD_48V + 1> m_colors;
+  std::array<QPen, PowerDelivery::PD_48V + 1> m_levelPens;
+};
+
+#endif // GRAPHRENDERER_H
@@ -0,0 +1,257 @@
+#include "HeadlessDaemon.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+
+namespace {
+// Flushes the CSV output and polls for signals
+constexpr int kTickIntervalMs = 100;
+
+std::atomic<bool> quitRequested{false};
+
+void requestQuit(int) { quitRequested.store(true); }
+} // namespace
+
+bool HeadlessDaemon::isRequested(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--headless") == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+HeadlessDaemon::HeadlessDaemon(OsdSettings *settings, QObject *parent)
+    : QObject(parent), m_settings(settings),
+      m_core(new AcquisitionCore(settings, this)), m_tickTimer(new QTimer(this)) {
+  connect(m_core->deviceManager(), &DeviceManager::powerDataReceived, this,
+          &HeadlessDaemon::onPowerDataReceived);
+  connect(m_core->deviceManager(), &DeviceManager::deviceConnected, this,
+          &HeadlessDaemon::onDeviceConnected);
+  connect(m_core->deviceManager(), &DeviceManager::deviceDisconnected, this,
+          &HeadlessDaemon::onDeviceDisconnected);
+  connect(m_core->deviceManager(), &DeviceManager::replayFinished, this,
+          &HeadlessDaemon::onReplayFinished);
+  connect(m_core->recorder(), &SessionRecorder::recordingError, this,
+          [](const QString &message) { qWarning().noquote() << message; });
+  connect(m_core->deviceManager()->rawCapture(), &RawCapture::captureError, this,
+          [](const QString &message) { qWarning().noquote() << message; });
+
+  m_tickTimer->setInterval(kTickIntervalMs);
+  connect(m_tickTimer, &QTimer::timeout, this, &HeadlessDaemon::tick);
+}
+
+HeadlessDaemon::~HeadlessDaemon() {
+  m_core->deviceManager()->rawCapture()->stop();
+  m_core->recorder()->stop();
+  if (m_csv) {
+    std::fflush(m_csv);
+    if (m_csv != stdout) {
+      std::fclose(m_csv);
+    }
+  }
+}
+
+bool HeadlessDaemon::start(const QStringList &arguments, QString *error) {
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Headless USB power acquisition");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addOption({"headless", "Run without a window."});
+  parser.addOption({"device",
+                    "Serial port or \"ble\" to acquire from, instead of the "
+                    "last used device.",
+                    "port"});
+  parser.addOption({"extra-meters", "Also monitor the additional meters of the window."});
+  parser.addOption({"replay",
+                    "Replay a recording or raw capture instead of acquiring, "
+                    "then exit.",
+                    "file"});
+  parser.addOption({"speed", "Replay speed factor, 0 = as fast as possible (default 1).",
+                    "factor", "1"});
+  parser.addOption({"csv", "Write every sample as CSV to a file, - for stdout.", "file"});
+  parser.addOption({"record", "Record the session to a .upr file.", "file"});
+  parser.addOption({"capture", "Capture the raw device bytes to a .upc file.", "file"});
+  parser.addOption({"stream",
+                    "Publish the samples on unix:<path> or tcp:[<host>:]<port>, "
+                    "unix+json:/tcp+json: for JSON lines; repeatable, replaces "
+                    "the configured addresses.",
+                    "address"});
+  parser.addOption({"shm",
+                    "Expose the samples in the POSIX shared-memory ring of this "
+                    "name, e.g. /usb-power-osd.",
+                    "name"});
+  parser.addOption({"metrics",
+                    "Serve Prometheus metrics on http://[<host>:]<port>/metrics, "
+                    "localhost unless a host is given.",
+                    "address"});
+  parser.addOption({"control",
+                    "Accept JSON-RPC control requests on the Unix socket at "
+                    "this path.",
+                    "path"});
+  parser.addOption({"stats",
+                    "Log a summary every this many seconds, 0 to disable "
+                    "(default 10).",
+                    "seconds", "10"});
+  parser.process(arguments);
+
+  bool ok = false;
+  m_statsIntervalMs = parser.value("stats").toInt(&ok) * 1000;
+  if (!ok || m_statsIntervalMs < 0) {
+    *error = "Invalid --stats value " + parser.value("stats");
+    return false;
+  }
+  const double speed = parser.value("speed").toDouble(&ok);
+  if (!ok || speed < 0.0) {
+    *error = "Invalid --speed value " + parser.value("speed");
+    return false;
+  }
+
+  if (parser.isSet("csv")) {
+    const QString path = parser.value("csv");
+    m_csv = path == "-" ? stdout : std::fopen(path.toLocal8Bit().constData(), "w");
+    if (!m_csv) {
+      *error = "Cannot create " + path;
+      return false;
+    }
+    std::fputs("timestamp_ms,voltage_v,current_a,power_w,energy_wh\n", m_csv);
+  }
+  if (parser.isSet("record") && !m_core->recorder()->start(parser.value("record"))) {
+    *error = "Cannot record to " + parser.value("record");
+    return false;
+  }
+  if (parser.isSet("capture") &&
+      !m_core->deviceManager()->rawCapture()->start(parser.value("capture"))) {
+    *error = "Cannot capture to " + parser.value("capture");
+    return false;
+  }
+
+  const QStringList streamAddresses =
+      parser.isSet("stream") ? parser.values("stream") : m_settings->stream_listen;
+  if (!m_core->startStreaming(streamAddresses, error)) {
+    return false;
+  }
+  const QString sharedRing =
+      parser.isSet("shm") ? parser.value("shm") : m_settings->shared_ring_name;
+  if (!sharedRing.isEmpty() && !m_core->startSharedRing(sharedRing, error)) {
+    return false;
+  }
+  const QString metrics =
+      parser.isSet("metrics") ? parser.value("metrics") : m_settings->metrics_listen;
+  if (!metrics.isEmpty() && !m_core->startMetrics(metrics, error)) {
+    return false;
+  }
+  const QString control =
+      parser.isSet("control") ? parser.value("control") : m_settings->control_socket;
+  if (!control.isEmpty() && !m_core->startControl(control, error)) {
+    return false;
+  }
+
+  if (parser.isSet("replay")) {
+    if (!m_core->deviceManager()->startReplay(parser.value("replay"), speed, error)) {
+      return false;
+    }
+  } else {
+    if (parser.isSet("device")) {
+      m_settings->last_device = parser.value("device");
+    }
+    if (m_settings->last_device.isEmpty()) {
+      *error = "No device to acquire from, pass --device";
+      return false;
+    }
+    if (parser.isSet("extra-meters")) {
+      m_core->addExtraMeters();
+    }
+    if (!m_core->connectLastDevice()) {
+      qInfo().noquote() << "Waiting for" << m_settings->last_device;
+      m_core->startReconnectTimer();
+    }
+  }
+
+  std::signal(SIGINT, requestQuit);
+  std::signal(SIGTERM, requestQuit);
+  m_sinceStats.start();
+  m_tickTimer->start();
+  return true;
+}
+
+void HeadlessDaemon::onPowerDataReceived(const PowerData &data) {
+  ++m_samples;
+  if (!m_csv) {
+    return;
+  }
+  // Calibrated like the history, i.e. like the window shows it
+  const PowerData sample = m_core->normalize(data);
+  std::fprintf(m_csv, "%llu,%.3f,%.3f,%.3f,%.6f\n",
+               static_cast<unsigned long long>(sample.timestamp), sample.voltage,
+               sample.current, sample.power, sample.energy);
+}
+
+void HeadlessDaemon::onDeviceConnected(const QString &deviceName) {
+  qInfo().noquote() << "Connected to" << deviceName;
+}
+
+void HeadlessDaemon::onDeviceDisconnected() { qInfo() << "Device disconnected"; }
+
+void HeadlessDaemon::onReplayFinished(quint64 samples, qint64 elapsedMs,
+                                      bool completed) {
+  const double seconds = std::max<qint64>(elapsedMs, 1) / 1000.0;
+  qInfo().noquote() << QString("Replay %1: %2 samples in %3 s (%4 samples/s)")
+                           .arg(completed ? "finished" : "stopped")
+                           .arg(samples)
+                           .arg(seconds, 0, 'f', 1)
+                           .arg(static_cast<double>(samples) / seconds, 0, 'f', 0);
+  QCoreApplication::quit();
+}
+
+void HeadlessDaemon::tick() {
+  if (m_csv) {
+    std::fflush(m_csv);
+  }
+  if (quitRequested.load()) {
+    QCoreApplication::quit();
+    return;
+  }
+  if (m_statsIntervalMs > 0 && m_sinceStats.elapsed() >= m_statsIntervalMs) {
+    logStatistics();
+  }
+}
+
+void HeadlessDaemon::logStatistics() {
+  const double seconds = m_sinceStats.restart() / 1000.0;
+  const quint64 samples = m_samples - m_samplesAtStats;
+  m_samplesAtStats = m_samples;
+
+  const MeasurementHistory *history = m_core->history();
+  if (history->is_empty()) {
+    qInfo().noquote() << QString("%1 samples/s, no data").arg(samples / seconds, 0, 'f', 1);
+    return;
+  }
+  const PowerData &last = history->atByAge(0);
+  double minCurrent = 0.0;
+  double maxCurrent = 0.0;
+  history->minMaxCurrent(minCurrent, maxCurrent);
+  QString line = QString("%1 samples/s, %2 V %3 A %4 W, history %5-%6 A")
+                     .arg(samples / seconds, 0, 'f', 1)
+                     .arg(last.voltage, 0, 'f', 3)
+                     .arg(last.current, 0, 'f', 3)
+                     .arg(last.power, 0, 'f', 3)
+                     .arg(minCurrent, 0, 'f', 3)
+                     .arg(maxCurrent, 0, 'f', 3);
+  if (m_core->recorder()->isRecording()) {
+    line += QString(", recorded %1 (%2 dropped)")
+                .arg(m_core->recorder()->recordedSamples())
+                .arg(m_core->recorder()->droppedSamples());
+  }
+  if (m_core->streamServer()->isListening()) {
+    line += QString(", %1 subscribers (%2 dropped)")
+                .arg(m_core->streamServer()->subscriberCount())
+                .arg(m_core->streamServer()->droppedSamples());
+  }
+  qInfo().noquote() << line;
+}
@@ -0,0 +1,53 @@
+#ifndef HEADLESSDAEMON_H
+#define HEADLESSDAEMON_H
+
+#include "AcquisitionCore.h"
+#include "OsdSettings.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <cstdio>
+
+// Runs the acquisition core without any widgets, for machines without a
+// display (usb-power-osd --headless). Samples can be written to stdout as
+// CSV, published to local subscribers, recorded and captured like in the
+// window, and a summary is logged periodically. SIGINT/SIGTERM end it
+// cleanly, closing recordings.
+class HeadlessDaemon : public QObject {
+  Q_OBJECT
+
+public:
+  // True if the command line asks for the headless mode; checked before
+  // any application object exists
+  static bool isRequested(int argc, char *argv[]);
+
+  explicit HeadlessDaemon(OsdSettings *settings, QObject *parent = nullptr);
+  ~HeadlessDaemon() override;
+
+  // Parses the options and starts acquiring; false with a message in
+  // error if the options are unusable
+  bool start(const QStringList &arguments, QString *error);
+
+private slots:
+  void onPowerDataReceived(const PowerData &data);
+  void onDeviceConnected(const QString &deviceName);
+  void onDeviceDisconnected();
+  void onReplayFinished(quint64 samples, qint64 elapsedMs, bool completed);
+  void tick();
+
+private:
+  void logStatistics();
+
+  OsdSettings *m_settings;
+  AcquisitionCore *m_core;
+  QTimer *m_tickTimer;
+  std::FILE *m_csv = nullptr;
+  int m_statsIntervalMs = 0;
+  QElapsedTimer m_sinceStats;
+  quint64 m_samples = 0;
+  quint64 m_samplesAtStats = 0;
+};
+
+#endif // HEADLESSDAEMON_H
@@ -0,0 +1,39 @@
+#include "LatencyHistogram.h"
+
+void LatencyHistogram::record(std::uint64_t durationNs) {
+  std::size_t bucket = 0;
+  while (bucket < kBounds && durationNs > kBoundsUs[bucket] * 1000) {
+    ++bucket;
+  }
+  m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  m_sumNs.fetch_add(durationNs, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+  Snapshot snapshot;
+  for (std::size_t i = 0; i < m_buckets.size(); ++i) {
+    snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    // Summed from the buckets, so the total always matches them
+    snapshot.count += snapshot.buckets[i];
+  }
+  snapshot.sumNs = m_sumNs.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+double LatencyHistogram::Snapshot::quantileUs(double q) const {
+  if (count == 0) {
+    return 0.0;
+  }
+  const double rank = q * static_cast<double>(count);
+  double below = 0.0;
+  for (std::size_t i = 0; i < kBounds; ++i) {
+    const auto inBucket = static_cast<double>(buckets[i]);
+    if (inBucket > 0.0 && below + inBucket >= rank) {
+      const double lower = i == 0 ? 0.0 : static_cast<double>(kBoundsUs[i - 1]);
+      const double upper = static_cast<double>(kBoundsUs[i]);
+      return lower + (upper - lower) * (rank - below) / inBucket;
+    }
+    below += inBucket;
+  }
+  return static_cast<double>(kBoundsUs.back());
+}
@@ -0,0 +1,40 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Distribution of durations with fixed, roughly logarithmic buckets from
+// 50 µs to 250 ms, for the metrics endpoint. record() is wait-free and may
+// be called from any thread; snapshot() is consistent enough for
+// monitoring, not exact while samples are being recorded.
+class LatencyHistogram {
+public:
+  // Upper bounds in microseconds; one more bucket catches everything slower
+  static constexpr std::size_t kBounds = 12;
+  static constexpr std::array<std::uint64_t, kBounds> kBoundsUs = {
+      50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000};
+
+  struct Snapshot {
+    // Per bucket, not cumulative; the last one is above kBoundsUs.back()
+    std::array<std::uint64_t, kBounds + 1> buckets{};
+    std::uint64_t count = 0;
+    std::uint64_t sumNs = 0;
+
+    [[nodiscard]] double meanUs() const { return count ? sumNs / 1e3 / count : 0.0; }
+    // Estimate of the q-quantile (0..1), interpolated within its bucket;
+    // anything above the last bound reads as that bound
+    [[nodiscard]] double quantileUs(double q) const;
+  };
+
+  void record(std::uint64_t durationNs);
+  [[nodiscard]] Snapshot snapshot() const;
+
+private:
+  std::array<std::atomic<std::uint64_t>, kBounds + 1> m_buckets{};
+  std::atomic<std::uint64_t> m_sumNs{0};
+};
+
+#endif // LATENCYHISTOGRAM_H
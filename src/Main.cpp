@@ -1,11 +1,38 @@
+#include "HeadlessDaemon.h"
 #include "MainWindow.h"
+#include "PipelineLatency.h"
 #include "PowerData.h"
 #include <QApplication>
 #include <QDir>
+#include <cstdio>
+
+namespace {
+// Without widgets, a display server or a GUI event dispatcher
+int runHeadless(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  app.setApplicationName("USB Power OSD");
+  app.setApplicationVersion("2.0.0");
+  app.setOrganizationName("MacWake");
+  app.setOrganizationDomain("de.macwake.usb-power-osd");
+
+  auto settings = new OsdSettings("MacWake", "USB Display", nullptr);
+  HeadlessDaemon daemon(settings);
+  QString error;
+  if (!daemon.start(app.arguments(), &error)) {
+    std::fprintf(stderr, "%s\n", qPrintable(error));
+    return 1;
+  }
+  return app.exec();
+}
+} // namespace
 
 // NOLINT(clang-tidy-static-accessed-through-instance)
 int main(int argc, char *argv[]) {
   qRegisterMetaType<PowerData>();
+  qRegisterMetaType<SampleStamps>();
+  if (HeadlessDaemon::isRequested(argc, argv)) {
+    return runHeadless(argc, argv);
+  }
   QApplication app(argc, argv);
 
   app.setApplicationName("USB Power OSD");
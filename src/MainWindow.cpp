@@ -3,8 +3,15 @@
 #include "AboutDialog.h"
 #include "DeviceSelectionDialog.h"
 #include <QApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDockWidget>
+#include <QFileDialog>
+#include <QGridLayout>
+#include <QInputDialog>
 #include <QLabel>
 #include <QMenuBar>
+#include <QSerialPortInfo>
 #include <QStatusBar>
 #include <QTimer>
 #include <QWidget>
@@ -15,13 +22,19 @@ MainWindow::MainWindow(OsdSettings *settings,
                        QWidget *parent) // NOLINT(*-pro-type-member-init)
     : QMainWindow(parent), settings(settings),
       m_powerMonitor(new PowerMonitor(this)),
-      m_deviceManager(new DeviceManager(this)),
+      m_core(new AcquisitionCore(settings, this)),
+      m_deviceManager(m_core->deviceManager()),
       m_settingsdialog(new SettingsDialog(settings, this)),
-      m_history(new MeasurementHistory(1000)), // todo change hard coded value
+      m_history(m_core->history()),
       m_updateTimer(new QTimer(this)), m_statusBarHideTimer(new QTimer(this)),
       m_deviceSelectionDialog(nullptr) {
     this->m_currentGraph = new CurrentGraph(this, m_history, settings);
-    this->m_deviceManager->setSettings(settings);
+    m_currentGraph->setPaintLatency(m_core->paintLatency());
+    m_currentGraph->setPipelineLatency(m_core->pipelineLatency());
+    // Created after the device manager so it outlives the acquisition thread
+    this->m_audioFeedback = new AudioFeedback(this);
+    this->m_recorder = m_core->recorder();
+    applyCalibration();
     statusBar()->setVisible(false);
 
     if (MainWindow::settings->window_width > 0 &&
@@ -35,26 +48,73 @@ MainWindow::MainWindow(OsdSettings *settings,
 
 
     // Connect signals
-    connect(m_deviceManager, &DeviceManager::powerDataReceived, this,
-            &MainWindow::onPowerDataReceived);
+    connect(m_core, &AcquisitionCore::historyChanged, m_currentGraph,
+            &CurrentGraph::onHistoryChanged);
+    // The tone follows the meter directly on the acquisition thread
+    connect(m_deviceManager, &DeviceManager::sampleAcquired, m_audioFeedback,
+            &AudioFeedback::onSample, Qt::DirectConnection);
+    connect(m_recorder, &SessionRecorder::recordingError, this,
+            [this](const QString &message) {
+                m_recordAction->setChecked(false);
+                showStatusMessage(message, 5000);
+            });
+    connect(m_deviceManager->rawCapture(), &RawCapture::captureError, this,
+            [this](const QString &message) {
+                m_captureAction->setChecked(false);
+                showStatusMessage(message, 5000);
+            });
     connect(m_deviceManager, &DeviceManager::deviceConnected, this,
             &MainWindow::onDeviceConnected);
     connect(m_deviceManager, &DeviceManager::deviceDisconnected, this,
             &MainWindow::onDeviceDisconnected);
+    connect(m_deviceManager, &DeviceManager::replayFinished, this,
+            &MainWindow::onReplayFinished);
+    connect(m_deviceManager, &DeviceManager::meterAdded, this,
+            &MainWindow::onMeterAdded);
+    connect(m_deviceManager, &DeviceManager::meterRemoved, this,
+            &MainWindow::onMeterRemoved);
+
+    connect(m_settingsdialog, &QDialog::accepted, this, &MainWindow::applyCalibration);
+
+    // Changes made over the control socket
+    connect(m_core, &AcquisitionCore::calibrationChanged, this, &MainWindow::applyCalibration);
+    connect(m_core, &AcquisitionCore::recordingChanged, m_recordAction, &QAction::setChecked);
+    m_core->controlServer()->registerMethod(
+        "setEnergyDisplayed", [this](const QJsonObject &params, QString *) -> QJsonValue {
+            // {"displayed": bool}, toggles without it
+            const bool displayed = params.value("displayed").toBool(!settings->is_energy_displayed);
+            if (displayed != settings->is_energy_displayed) {
+                toggleEnergy();
+            }
+            return displayed;
+        });
 
     // Setup timers
-    m_updateTimer->setInterval(200);
+    // Readouts only repaint the digits that changed, so a snappy refresh is cheap
+    m_updateTimer->setInterval(33);
     connect(m_updateTimer, &QTimer::timeout, [this] { this->updateLabels(); });
     m_statusBarHideTimer->setSingleShot(true); // Only fire once
     connect(m_statusBarHideTimer, &QTimer::timeout, this,
             &MainWindow::hideStatusBar);
 
-    QTimer::singleShot(50, [this] { MainWindow::connectLastDevice(false); });
-
-    this->m_reconnect_timer = new QTimer(this);
-    this->m_reconnect_timer->setInterval(1000);
-    connect(this->m_reconnect_timer, &QTimer::timeout,
-            [this] { this->connectLastDevice(true); });
+    QTimer::singleShot(50, [this] { MainWindow::connectLastDevice(); });
+    m_core->addExtraMeters();
+    QString streamError;
+    if (!m_core->startStreaming(settings->stream_listen, &streamError)) {
+        qWarning().noquote() << streamError;
+    }
+    if (!settings->shared_ring_name.isEmpty() &&
+        !m_core->startSharedRing(settings->shared_ring_name, &streamError)) {
+        qWarning().noquote() << streamError;
+    }
+    if (!settings->metrics_listen.isEmpty() &&
+        !m_core->startMetrics(settings->metrics_listen, &streamError)) {
+        qWarning().noquote() << streamError;
+    }
+    if (!settings->control_socket.isEmpty() &&
+        !m_core->startControl(settings->control_socket, &streamError)) {
+        qWarning().noquote() << streamError;
+    }
     // } else {
     //   // Start scanning with last known device settings
     //   m_deviceManager->startScanning();
@@ -64,8 +124,6 @@ MainWindow::MainWindow(OsdSettings *settings,
 
 MainWindow::~MainWindow() = default;
 
-void MainWindow::startReconnectTimer() const { this->m_reconnect_timer->start(); }
-
 void MainWindow::showStatusMessage(const QString &message,
                                    int hideAfterMs = 5000) {
     statusBar()->setVisible(true);
@@ -101,19 +159,9 @@ void MainWindow::hideStatusBar() {
     }
 }
 
-void MainWindow::connectLastDevice(bool reconnecting = false) {
-    // qDebug() << "Trying to connect to last device...
-    // (reconnect="<<reconnecting<<")";
-    if (!settings->last_device.isEmpty()) {
-        // qDebug() << "Trying to connect to last device " << settings->last_device;
-        if (this->m_deviceManager->tryConnect(settings->last_device)) {
-            if (reconnecting) {
-                this->m_reconnect_timer->stop();
-            }
-            return;
-        }
-    }
-    if (!reconnecting) {
+void MainWindow::connectLastDevice() {
+    // Reconnects after a lost device are retried by the core
+    if (!m_core->connectLastDevice()) {
         this->showDeviceSelectionDialog();
     }
 }
@@ -122,10 +170,11 @@ void MainWindow::toggleEnergy() const {
     this->settings->is_energy_displayed = !this->settings->is_energy_displayed;
     this->settings->saveSettings();
     this->lblEnergy->setVisible(this->settings->is_energy_displayed);
+    this->m_energyAction->setChecked(this->settings->is_energy_displayed);
 }
 
 void MainWindow::showDeviceSelectionDialog() {
-    this->m_reconnect_timer->stop();
+    m_core->stopReconnectTimer();
     m_deviceManager->stopBtScanning();
 
     if (!m_deviceSelectionDialog) {
@@ -153,7 +202,7 @@ void MainWindow::showDeviceSelectionDialog() {
             statusBar()->showMessage(QString("Connected to %1").arg(selectedPort));
         }
     } else {
-        this->startReconnectTimer();
+        m_core->startReconnectTimer();
     }
 }
 
@@ -162,11 +211,11 @@ void MainWindow::setupUI() {
     setWindowTitle("MacWake USB Power OSD");
 
     setBackgroundColor(settings->color_bg);
-    this->lblVoltage = new QLabel("");
-    this->lblCurrent = new QLabel("");
-    this->lblPower = new QLabel("");
-    this->lblEnergy = new QLabel("");
-    this->lblMinMaxCurrent = new QLabel("");
+    this->lblVoltage = new ReadoutLabel;
+    this->lblCurrent = new ReadoutLabel;
+    this->lblPower = new ReadoutLabel;
+    this->lblEnergy = new ReadoutLabel;
+    this->lblMinMaxCurrent = new ReadoutLabel;
     this->fntPrimary = QFont(this->settings->primary_font_name,
                              this->settings->primary_font_size);
     this->fntSecondary = QFont(this->settings->secondary_font_name,
@@ -177,16 +226,11 @@ void MainWindow::setupUI() {
     this->lblEnergy->setFont(fntSecondary);
     this->lblMinMaxCurrent->setFont(fntSecondary);
 
-    this->lblVoltage->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
-    this->lblCurrent->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
-    this->lblPower->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
-    this->lblEnergy->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
-    this->lblMinMaxCurrent->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
+    this->lblVoltage->setColor(settings->color_text);
+    this->lblCurrent->setColor(settings->color_text);
+    this->lblPower->setColor(settings->color_text);
+    this->lblEnergy->setColor(settings->color_text);
+    this->lblMinMaxCurrent->setColor(settings->color_text);
 
     this->lblVoltage->setAlignment(Qt::AlignLeft | Qt::AlignVCenter);
     this->lblCurrent->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
@@ -211,11 +255,11 @@ void MainWindow::setupUI() {
     lblMinMaxCurrent->setParent(centralWidget);
     m_currentGraph->setParent(centralWidget);
 
-    auto toggleEnergyAction = new QAction("Toggle Energy", this);
-    toggleEnergyAction->setShortcut(QKeySequence("e"));
-    toggleEnergyAction->setCheckable(true);
-    toggleEnergyAction->setChecked(this->settings->is_energy_displayed);
-    connect(toggleEnergyAction, &QAction::triggered, this, &MainWindow::toggleEnergy);
+    m_energyAction = new QAction("Toggle Energy", this);
+    m_energyAction->setShortcut(QKeySequence("e"));
+    m_energyAction->setCheckable(true);
+    m_energyAction->setChecked(this->settings->is_energy_displayed);
+    connect(m_energyAction, &QAction::triggered, this, &MainWindow::toggleEnergy);
 
     auto resetHistoryAction = new QAction("Reset History", this);
     resetHistoryAction->setShortcut(QKeySequence("r"));
@@ -229,12 +273,29 @@ void MainWindow::setupUI() {
     resetBaseCurrentAction->setShortcut(QKeySequence("x"));
     connect(resetBaseCurrentAction, &QAction::triggered, this, &MainWindow::resetBaseCurrent);
 
+    auto addMeterAction = new QAction("Add Meter...", this);
+    addMeterAction->setShortcut(QKeySequence("m"));
+    connect(addMeterAction, &QAction::triggered, this, &MainWindow::addMeter);
+
+    // Additional meters are shown as tiles in a dock below the main readout
+    auto *meterContainer = new QWidget;
+    m_meterGrid = new QGridLayout(meterContainer);
+    m_meterGrid->setContentsMargins(2, 2, 2, 2);
+    m_meterDock = new QDockWidget("Meters", this);
+    m_meterDock->setObjectName("meterDock");
+    m_meterDock->setFeatures(QDockWidget::DockWidgetMovable |
+                             QDockWidget::DockWidgetFloatable);
+    m_meterDock->setWidget(meterContainer);
+    addDockWidget(Qt::BottomDockWidgetArea, m_meterDock);
+    m_meterDock->hide();
+
     // Menu bar
     auto *fileMenu = menuBar()->addMenu("&File");
     fileMenu->addAction("&Settings", this, &MainWindow::showSettings);
     fileMenu->addSeparator();
     fileMenu->addAction("&Change Device", this, &MainWindow::showDeviceSelectionDialog);
-    fileMenu->addAction(toggleEnergyAction);
+    fileMenu->addAction(addMeterAction);
+    fileMenu->addAction(m_energyAction);
     fileMenu->addAction(setBaseCurrentAction);
     fileMenu->addAction(resetBaseCurrentAction);
     fileMenu->addAction(resetHistoryAction);
@@ -245,6 +306,35 @@ void MainWindow::setupUI() {
     audioAction->setShortcut(QKeySequence("a"));
     connect(audioAction, &QAction::toggled, this, &MainWindow::toggleAudio);
 
+    m_recordAction = fileMenu->addAction(tr("Record Session..."));
+    m_recordAction->setCheckable(true);
+    m_recordAction->setShortcut(QKeySequence("s"));
+    connect(m_recordAction, &QAction::triggered, this, &MainWindow::toggleRecording);
+
+    m_captureAction = fileMenu->addAction(tr("Capture Raw Bytes..."));
+    m_captureAction->setCheckable(true);
+    m_captureAction->setShortcut(QKeySequence("c"));
+    connect(m_captureAction, &QAction::triggered, this, &MainWindow::toggleCapture);
+
+    auto *openRecordingAction = fileMenu->addAction(tr("Open Recording..."));
+    openRecordingAction->setShortcut(QKeySequence("o"));
+    connect(openRecordingAction, &QAction::triggered, this, &MainWindow::openRecording);
+
+    m_replayAction = fileMenu->addAction(tr("Replay Recording..."));
+    m_replayAction->setCheckable(true);
+    m_replayAction->setShortcut(QKeySequence("p"));
+    connect(m_replayAction, &QAction::triggered, this, &MainWindow::toggleReplay);
+
+    auto *audioLatencyAction = fileMenu->addAction(tr("Audio Latency"));
+    audioLatencyAction->setShortcut(QKeySequence("l"));
+    connect(audioLatencyAction, &QAction::triggered, this, &MainWindow::showAudioLatency);
+
+    auto *latencyOverlayAction = fileMenu->addAction(tr("Pipeline Latency"));
+    latencyOverlayAction->setCheckable(true);
+    latencyOverlayAction->setShortcut(QKeySequence("t"));
+    connect(latencyOverlayAction, &QAction::toggled, m_currentGraph,
+            &CurrentGraph::setLatencyOverlay);
+
     fileMenu->addSeparator();
     fileMenu->addAction("E&xit", this, &QWidget::close);
 
@@ -336,46 +426,6 @@ void MainWindow::moveEvent(QMoveEvent *event) {
     this->settings->saveSettings();
 }
 
-void MainWindow::onPowerDataReceived(const PowerData &data) {
-    this->lastDataRaw = data;
-    static bool lastWasInvalid = false;
-    auto norm_data = this->normalize(data);
-
-    if (norm_data.current < settings->min_current || norm_data.voltage < 2.0) {
-        if (!lastWasInvalid) {
-            this->m_history->push(norm_data);
-            lastWasInvalid = true;
-        }
-        if (m_audioGenerator) {
-            m_audioGenerator->setAmplitude(0.0);
-        }
-    } else {
-        lastWasInvalid = false;
-        this->m_history->push(norm_data);
-
-        if (settings->is_audio_enabled && m_audioGenerator) {
-            // Frequency: 400Hz to 4kHz depending on current (0 to say 5A)
-            // Use sqrt for higher sensitivity at low currents
-            double currentA = std::abs(norm_data.current);
-            double normalizedCurrent = std::min(currentA / 5.0, 1.0);
-            double freq = 400.0 + (4000.0 - 400.0) * std::sqrt(normalizedCurrent);
-            m_audioGenerator->setFrequency(freq);
-
-            // Amplitude: Compare stddev of last 10 against last 3
-            double stddev10 = m_history->getCurrentStdDevLastN(10);
-            double stddev3 = m_history->getCurrentStdDevLastN(3);
-
-            // If stddev3 is much higher than stddev10, it means it's noisier now.
-            // A common way to detect change/noise is the difference.
-            double diff = std::abs(stddev3 - stddev10);
-
-            // Assume diff of 50mA is "full" volume (0.1)
-            double amp = std::min(diff / 0.05, 1.0) * 0.1;
-            m_audioGenerator->setAmplitude(amp);
-        }
-    }
-}
-
 void MainWindow::onDeviceConnected(const QString &deviceName) {
     showStatusMessage("Connected to " + deviceName);
     m_updateTimer->start();
@@ -404,37 +454,34 @@ void MainWindow::updateLabels() {
     //     this->updateUINoData();
     //     return;
     // }
-    this->m_history->minMaxCurrentLastN(this->m_history->size(), totalMinCurrent,
-                                        totalMaxCurrent);
+    this->m_history->minMaxCurrent(totalMinCurrent, totalMaxCurrent);
     if (!this->m_history->maxValuesLastN(3, maxVoltage, maxCurrent, maxPower)) {
-        maxVoltage = this->lastDataRaw.voltage;
-        maxCurrent = this->lastDataRaw.current;
+        maxVoltage = m_core->lastRaw().voltage;
+        maxCurrent = m_core->lastRaw().current;
         maxPower = maxCurrent * maxVoltage;
     }
-    lblVoltage->setText(QString("%1V").arg(maxVoltage, 0, 'f', 2));
-    lblCurrent->setText(QString("%1A").arg(maxCurrent, 0, 'f', 4));
-    lblPower->setText(QString("%1W").arg(maxPower, 0, 'f', 3));
-    lblEnergy->setText(QString("%1Wh").arg(last.energy, 0, 'f', 3));
-    lblMinMaxCurrent->setText(QString("%1-%2A")
-        .arg(totalMinCurrent, 0, 'f', 3)
-        .arg(totalMaxCurrent, 0, 'f', 3));
+    lblVoltage->setValue(maxVoltage, 2, "V");
+    lblCurrent->setValue(maxCurrent, 4, "A");
+    lblPower->setValue(maxPower, 3, "W");
+    lblEnergy->setValue(last.energy, 3, "Wh");
+    lblMinMaxCurrent->setRange(totalMinCurrent, totalMaxCurrent, 3, "A");
+    auto *latency = m_core->pipelineLatency();
+    latency->shown(latency->insertedCount());
 }
 
 void MainWindow::updateUINoData() {
-    if (m_audioGenerator) {
-        m_audioGenerator->setAmplitude(0.0);
-    }
+    m_audioFeedback->silence();
     double totalMinCurrent;
     double totalMaxCurrent;
-    this->m_history->minMaxCurrentLastN(this->m_history->size(), totalMinCurrent,
-                                        totalMaxCurrent);
-    lblVoltage->setText(QString("---"));
-    lblCurrent->setText(QString("---"));
-    lblPower->setText(QString("---"));
-    lblEnergy->setText(QString("---"));
-    lblMinMaxCurrent->setText(QString("%1 - %2A")
-        .arg(totalMinCurrent, 0, 'f', 3)
-        .arg(totalMaxCurrent, 0, 'f', 3));
+    lblVoltage->setNoData();
+    lblCurrent->setNoData();
+    lblPower->setNoData();
+    lblEnergy->setNoData();
+    if (this->m_history->minMaxCurrent(totalMinCurrent, totalMaxCurrent)) {
+        lblMinMaxCurrent->setRange(totalMinCurrent, totalMaxCurrent, 3, "A");
+    } else {
+        lblMinMaxCurrent->setNoData();
+    }
 }
 
 void MainWindow::setBackgroundColor(const QColor &color) {
@@ -445,7 +492,7 @@ void MainWindow::setBackgroundColor(const QColor &color) {
 
 void MainWindow::resetMeasurementHistory() {
     if (m_history) {
-        m_history->reset();
+        m_core->resetHistory();
         showStatusMessage("Measurement history reset", 3000);
 
         // Update labels immediately to reflect the reset
@@ -459,11 +506,13 @@ void MainWindow::setBaseCurrent() {
     }
     auto last = this->m_history->atByAge(0);
     this->settings->current_diff_ma = last.current * 1000.0f + this->settings->current_diff_ma;
+    applyCalibration();
     showStatusMessage("Base current set to " + QString::number(last.current) + "A", 3000);
 }
 
 void MainWindow::resetBaseCurrent() {
     this->settings->current_diff_ma = 0;
+    applyCalibration();
     showStatusMessage("Base current reset", 3000);
 }
 
@@ -487,25 +536,16 @@ void MainWindow::onSecondaryFontChanged(const QFont &font) {
 }
 
 void MainWindow::onColorChanged() {
-    this->lblVoltage->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
-    this->lblCurrent->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
-    this->lblPower->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
-    this->lblEnergy->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
-    this->lblMinMaxCurrent->setStyleSheet(
-        "QLabel { color: " + settings->color_text.name() + "; }");
+    this->lblVoltage->setColor(settings->color_text);
+    this->lblCurrent->setColor(settings->color_text);
+    this->lblPower->setColor(settings->color_text);
+    this->lblEnergy->setColor(settings->color_text);
+    this->lblMinMaxCurrent->setColor(settings->color_text);
     this->setBackgroundColor(settings->color_bg);
-}
-
-PowerData MainWindow::normalize(const PowerData &data) {
-    if (this->settings->current_diff_ma == 0) return data;
-    PowerData normalized = data;
-    normalized.current = data.current - (static_cast<float>(this->settings->current_diff_ma) / 1000.0f);
-    if (normalized.current < 0) normalized.current = 0;
-    return normalized;
+    this->m_currentGraph->onColorsChanged();
+    for (auto *tile : m_meterTiles) {
+        tile->onColorChanged();
+    }
 }
 
 bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
@@ -531,21 +571,209 @@ void MainWindow::toggleAudio() {
     settings->saveSettings();
 
     if (settings->is_audio_enabled) {
-        if (!m_audioSink) {
-            QAudioFormat format;
-            format.setSampleRate(44100);
-            format.setChannelCount(1);
-            format.setSampleFormat(QAudioFormat::Float);
-
-            m_audioGenerator = new AudioGenerator(format, this);
-            m_audioSink = new QAudioSink(format, this);
-        }
-        m_audioGenerator->start();
-        m_audioSink->start(m_audioGenerator);
+        m_audioFeedback->start(settings->audio_low_latency, settings->audio_buffer_ms);
+        // Give the sink a moment to fill before reporting what it settled on
+        QTimer::singleShot(1000, this, &MainWindow::showAudioLatency);
     } else {
-        if (m_audioSink) {
-            m_audioSink->stop();
-            m_audioGenerator->stop();
+        m_audioFeedback->stop();
+    }
+}
+
+void MainWindow::showAudioLatency() {
+    if (!m_audioFeedback->isRunning()) {
+        showStatusMessage("Audio output is off", 3000);
+        return;
+    }
+    const auto latency = m_audioFeedback->latency();
+    if (!latency.valid) {
+        showStatusMessage(QString("Audio buffer %1 ms, no samples yet")
+                              .arg(latency.bufferMs, 0, 'f', 1), 5000);
+        return;
+    }
+    showStatusMessage(QString("Sample to pitch %1 ms (pickup %2 ms + output %3 ms, buffer %4 ms)")
+                          .arg(latency.totalMs(), 0, 'f', 1)
+                          .arg(latency.pickupMs, 0, 'f', 1)
+                          .arg(latency.outputMs, 0, 'f', 1)
+                          .arg(latency.bufferMs, 0, 'f', 1), 5000);
+}
+
+void MainWindow::toggleRecording(bool checked) {
+    if (!checked) {
+        if (m_recorder->isRecording()) {
+            m_recorder->stop();
+            showStatusMessage(QString("Recorded %1 samples to %2 (%3 dropped)")
+                                  .arg(m_recorder->recordedSamples())
+                                  .arg(m_recorder->path())
+                                  .arg(m_recorder->droppedSamples()), 5000);
         }
+        return;
     }
+
+    const QString suggestion =
+        QDir::home().filePath("usb-power-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".upr");
+    const QString path = QFileDialog::getSaveFileName(
+        this, "Record Session", suggestion, "USB power recordings (*.upr)");
+    if (path.isEmpty() || !m_recorder->start(path)) {
+        m_recordAction->setChecked(false);
+        return;
+    }
+    showStatusMessage("Recording to " + path, 3000);
+}
+
+void MainWindow::toggleCapture(bool checked) {
+    RawCapture *capture = m_deviceManager->rawCapture();
+    if (!checked) {
+        if (capture->isCapturing()) {
+            capture->stop();
+            showStatusMessage(QString("Captured %1 bytes to %2 (%3 reads dropped)")
+                                  .arg(capture->capturedBytes())
+                                  .arg(capture->path())
+                                  .arg(capture->droppedRecords()), 5000);
+        }
+        return;
+    }
+
+    const QString suggestion =
+        QDir::home().filePath("usb-power-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".upc");
+    const QString path = QFileDialog::getSaveFileName(
+        this, "Capture Raw Bytes", suggestion, "USB power raw captures (*.upc)");
+    if (path.isEmpty() || !capture->start(path)) {
+        m_captureAction->setChecked(false);
+        return;
+    }
+    showStatusMessage("Capturing raw bytes to " + path, 3000);
+}
+
+void MainWindow::openRecording() {
+    const QString path = QFileDialog::getOpenFileName(
+        this, "Open Recording", QDir::homePath(), "USB power recordings (*.upr)");
+    if (path.isEmpty()) {
+        return;
+    }
+    auto *view = new RecordingView;
+    QString error;
+    if (!view->open(path, &error)) {
+        delete view;
+        showStatusMessage(error, 5000);
+        return;
+    }
+    auto *viewer = new RecordingViewer(view, settings, this);
+    viewer->show();
+}
+
+void MainWindow::toggleReplay(bool checked) {
+    if (!checked) {
+        m_deviceManager->stopReplay();
+        return;
+    }
+
+    const QString path = QFileDialog::getOpenFileName(
+        this, "Replay Recording", QDir::homePath(),
+        "USB power recordings and raw captures (*.upr *.upc)");
+    const QStringList speeds = {"Real time", "2x", "10x", "100x", "As fast as possible"};
+    const QList<double> factors = {1.0, 2.0, 10.0, 100.0, 0.0};
+    bool ok = false;
+    const QString speed = path.isEmpty()
+        ? QString()
+        : QInputDialog::getItem(this, "Replay Recording", "Speed:", speeds, 0, false, &ok);
+    if (!ok) {
+        m_replayAction->setChecked(false);
+        return;
+    }
+    // Start from an empty history so a replay always produces the same graph and statistics
+    m_core->stopReconnectTimer();
+    resetMeasurementHistory();
+    QString error;
+    if (!m_deviceManager->startReplay(path, factors[speeds.indexOf(speed)], &error)) {
+        m_replayAction->setChecked(false);
+        showStatusMessage(error, 5000);
+        m_core->startReconnectTimer();
+    }
+}
+
+void MainWindow::onReplayFinished(quint64 samples, qint64 elapsedMs, bool completed) {
+    m_replayAction->setChecked(false);
+    const double seconds = std::max<qint64>(elapsedMs, 1) / 1000.0;
+    showStatusMessage(QString("Replay %1: %2 samples in %3 s (%4 samples/s)")
+                          .arg(completed ? "finished" : "stopped")
+                          .arg(samples)
+                          .arg(seconds, 0, 'f', 1)
+                          .arg(static_cast<double>(samples) / seconds, 0, 'f', 0), 10000);
+    // Back to the live device
+    m_core->startReconnectTimer();
+}
+
+void MainWindow::addMeter() {
+    QStringList ports;
+    for (const auto &port : QSerialPortInfo::availablePorts()) {
+        const QString location = port.systemLocation();
+        if (location != settings->last_device &&
+            !settings->extra_devices.contains(location)) {
+            ports.append(location);
+        }
+    }
+    if (ports.isEmpty()) {
+        showStatusMessage("No further serial ports available", 3000);
+        return;
+    }
+
+    bool ok = false;
+    const QString portName = QInputDialog::getItem(
+        this, "Add Meter", "Serial port:", ports, 0, false, &ok);
+    if (!ok || portName.isEmpty()) {
+        return;
+    }
+    if (!m_deviceManager->addMeter(portName, m_history->capacity())) {
+        showStatusMessage("Cannot monitor " + portName + " as additional meter", 3000);
+    }
+}
+
+void MainWindow::onMeterAdded(MeterChannel *meter) {
+    auto *tile = new MeterTile(meter, settings);
+    // Queued: the tile is deleted while handling the removal
+    connect(tile, &MeterTile::removeRequested, m_deviceManager,
+            &DeviceManager::removeMeter, Qt::QueuedConnection);
+    m_meterTiles.append(tile);
+    layoutMeterTiles();
+    saveExtraDevices();
+}
+
+void MainWindow::onMeterRemoved(const QString &portName) {
+    for (int i = 0; i < m_meterTiles.size(); ++i) {
+        if (m_meterTiles[i]->meter()->portName() == portName) {
+            // The channel (and its history) is deleted right after this signal
+            delete m_meterTiles.takeAt(i);
+            break;
+        }
+    }
+    layoutMeterTiles();
+    saveExtraDevices();
+}
+
+void MainWindow::layoutMeterTiles() {
+    const int columns = m_meterTiles.size() > 4 ? 3 : 2;
+    for (auto *tile : m_meterTiles) {
+        m_meterGrid->removeWidget(tile);
+    }
+    for (int i = 0; i < m_meterTiles.size(); ++i) {
+        m_meterGrid->addWidget(m_meterTiles[i], i / columns, i % columns);
+    }
+    m_meterDock->setVisible(!m_meterTiles.isEmpty());
+}
+
+void MainWindow::saveExtraDevices() const {
+    QStringList ports;
+    for (const auto *tile : m_meterTiles) {
+        ports.append(tile->meter()->portName());
+    }
+    if (ports != settings->extra_devices) {
+        settings->extra_devices = ports;
+        settings->saveSettings();
+    }
+}
+
+void MainWindow::applyCalibration() const {
+    m_audioFeedback->setNormalization(
+        static_cast<double>(settings->current_diff_ma) / 1000.0, settings->min_current);
+    m_core->applySettings();
 }
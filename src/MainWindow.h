@@ -1,21 +1,27 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "AcquisitionCore.h"
 #include "CurrentGraph.h"
 #include "DeviceManager.h"
 #include "DeviceSelectionDialog.h"
 #include "MeasurementHistory.h"
+#include "MeterTile.h"
 #include "OsdSettings.h"
 #include "PowerMonitor.h"
+#include "ReadoutLabel.h"
+#include "RecordingViewer.h"
+#include "SessionRecorder.h"
 #include "SettingsDialog.h"
-#include "AudioGenerator.h"
+#include "AudioFeedback.h"
 #include <QMainWindow>
 #include <QMenu>
 #include <QSystemTrayIcon>
 #include <QTimer>
-#include <QAudioSink>
 
 QT_BEGIN_NAMESPACE
+class QDockWidget;
+class QGridLayout;
 class QLabel;
 class QProgressBar;
 QT_END_NAMESPACE
@@ -28,8 +34,6 @@ public:
 
     ~MainWindow() override;
 
-    void startReconnectTimer() const;
-
     void showStatusMessage(const QString &message, int hideAfterMs);
 
     // Public getter for settings
@@ -43,10 +47,6 @@ public:
     void onColorChanged();
 
 private slots:
-    PowerData normalize(const PowerData &data);
-
-    void onPowerDataReceived(const PowerData &data);
-
     void onDeviceConnected(const QString &deviceName);
 
     void onDeviceDisconnected();
@@ -57,7 +57,7 @@ private slots:
 
     void hideStatusBar();
 
-    void connectLastDevice(bool reconnecting);
+    void connectLastDevice();
 
     void toggleEnergy() const;
 
@@ -73,6 +73,24 @@ private slots:
 
     void toggleAudio();
 
+    void showAudioLatency();
+
+    void toggleRecording(bool checked);
+
+    void toggleCapture(bool checked);
+
+    void openRecording();
+
+    void toggleReplay(bool checked);
+
+    void onReplayFinished(quint64 samples, qint64 elapsedMs, bool completed);
+
+    void addMeter();
+
+    void onMeterAdded(MeterChannel *meter);
+
+    void onMeterRemoved(const QString &portName);
+
 protected:
     void resizeEvent(QResizeEvent *event) override;
 
@@ -89,7 +107,14 @@ private:
 
     void positionWidgets();
 
+    void layoutMeterTiles();
+
+    void saveExtraDevices() const;
+
+    void applyCalibration() const;
+
     PowerMonitor *m_powerMonitor;
+    AcquisitionCore *m_core;
     DeviceManager *m_deviceManager;
     SettingsDialog *m_settingsdialog;
     OsdSettings *settings = nullptr;
@@ -100,20 +125,26 @@ private:
     QTimer *m_statusBarHideTimer;
 
     // UI members
-    QLabel *lblVoltage;
-    QLabel *lblCurrent;
-    QLabel *lblPower;
-    QLabel *lblEnergy;
-    QLabel *lblMinMaxCurrent;
+    ReadoutLabel *lblVoltage;
+    ReadoutLabel *lblCurrent;
+    ReadoutLabel *lblPower;
+    ReadoutLabel *lblEnergy;
+    ReadoutLabel *lblMinMaxCurrent;
     QFont fntPrimary;
     QFont fntSecondary;
 
     CurrentGraph *m_currentGraph;
-    QTimer *m_reconnect_timer;
-    PowerData lastDataRaw;
 
-    QAudioSink *m_audioSink = nullptr;
-    AudioGenerator *m_audioGenerator = nullptr;
+    QDockWidget *m_meterDock = nullptr;
+    QGridLayout *m_meterGrid = nullptr;
+    QList<MeterTile *> m_meterTiles;
+
+    AudioFeedback *m_audioFeedback = nullptr;
+    SessionRecorder *m_recorder = nullptr;
+    QAction *m_energyAction = nullptr;
+    QAction *m_recordAction = nullptr;
+    QAction *m_captureAction = nullptr;
+    QAction *m_replayAction = nullptr;
 };
 
 #endif // MAINWINDOW_H
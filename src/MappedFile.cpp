@@ -0,0 +1,87 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string &path) {
+  close();
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 ||
+      static_cast<std::uint64_t>(size.QuadPart) > SIZE_MAX) {
+    CloseHandle(file);
+    return false;
+  }
+  // The mapping keeps the file open
+  m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!m_mapping) {
+    return false;
+  }
+  m_data = static_cast<const unsigned char *>(
+      MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!m_data) {
+    CloseHandle(m_mapping);
+    m_mapping = nullptr;
+    return false;
+  }
+  m_size = static_cast<std::uint64_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::close() {
+  if (m_data) {
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+  }
+  m_data = nullptr;
+  m_mapping = nullptr;
+  m_size = 0;
+}
+#else
+bool MappedFile::open(const std::string &path) {
+  close();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info {};
+  if (fstat(fd, &info) != 0 || info.st_size <= 0 ||
+      static_cast<std::uint64_t>(info.st_size) > SIZE_MAX) {
+    ::close(fd);
+    return false;
+  }
+  // The mapping stays valid after closing the descriptor
+  void *data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ,
+                    MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  m_data = static_cast<const unsigned char *>(data);
+  m_size = static_cast<std::uint64_t>(info.st_size);
+  return true;
+}
+
+void MappedFile::close() {
+  if (m_data) {
+    munmap(const_cast<unsigned char *>(m_data), static_cast<std::size_t>(m_size));
+  }
+  m_data = nullptr;
+  m_size = 0;
+}
+#endif
@@ -0,0 +1,32 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are loaded by the OS on
+// first access, so opening is constant-time regardless of the file size.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Empty files cannot be mapped and fail as well
+  bool open(const std::string &path);
+  void close();
+
+  [[nodiscard]] bool isOpen() const { return m_data != nullptr; }
+  [[nodiscard]] const unsigned char *data() const { return m_data; }
+  [[nodiscard]] std::uint64_t size() const { return m_size; }
+
+private:
+  const unsigned char *m_data = nullptr;
+  std::uint64_t m_size = 0;
+#ifdef _WIN32
+  void *m_mapping = nullptr;
+#endif
+};
+
+#endif // MAPPEDFILE_H
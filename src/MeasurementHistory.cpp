@@ -1,10 +1,11 @@
 // MeasurementHistory.cpp
 #include "MeasurementHistory.h"
 #include <algorithm>
+#include <cmath>
 #include <numeric>
 
 MeasurementHistory::MeasurementHistory(std::size_t capacity)
-    : _size(capacity), _values(capacity)
+    : _size(capacity), _values(capacity), _levels(capacity, PowerDelivery::PD_NONE)
 {
     if (_size == 0) {
         throw std::invalid_argument("MeasurementHistory capacity must be > 0");
@@ -14,6 +15,10 @@ MeasurementHistory::MeasurementHistory(std::size_t capacity)
 void MeasurementHistory::reset() noexcept {
     _valid_count = 0;
     _head = 0;
+    _push_count = 0;
+    ++_epoch;
+    _minSlots.clear();
+    _maxSlots.clear();
 }
 
 void MeasurementHistory::setCapacity(std::size_t newCapacity) {
@@ -22,15 +27,50 @@ void MeasurementHistory::setCapacity(std::size_t newCapacity) {
     }
     _size = newCapacity;
     _values.assign(_size, PowerData{});
+    _levels.assign(_size, PowerDelivery::PD_NONE);
     reset();
 }
 
 void MeasurementHistory::push(const PowerData& sample) noexcept {
+    push(sample, PowerDelivery::getEnum(static_cast<float>(sample.voltage)));
+}
+
+void MeasurementHistory::push(const PowerData& sample, PowerDelivery::PD_VOLTS level) noexcept {
+    // The evicted oldest sample can only be at the front of the queues
+    if (_valid_count == _size) {
+        if (!_minSlots.empty() && _minSlots.front() == _head) {
+            _minSlots.pop_front();
+        }
+        if (!_maxSlots.empty() && _maxSlots.front() == _head) {
+            _maxSlots.pop_front();
+        }
+    }
+    // Older samples that are not below (above) the new one never will be
+    // the minimum (maximum) again
+    while (!_minSlots.empty() && _values[_minSlots.back()].current >= sample.current) {
+        _minSlots.pop_back();
+    }
+    while (!_maxSlots.empty() && _values[_maxSlots.back()].current <= sample.current) {
+        _maxSlots.pop_back();
+    }
+    _minSlots.push_back(_head);
+    _maxSlots.push_back(_head);
     _values[_head] = sample;
+    _levels[_head] = level;
     _head = inc(_head);
     if (_valid_count < _size) {
         ++_valid_count;
     }
+    ++_push_count;
+}
+
+bool MeasurementHistory::minMaxCurrent(double& outMin, double& outMax) const noexcept {
+    if (_valid_count == 0) {
+        return false;
+    }
+    outMin = _values[_minSlots.front()].current;
+    outMax = _values[_maxSlots.front()].current;
+    return true;
 }
 
 bool MeasurementHistory::minMaxCurrentLastN(std::size_t lastN, double& outMin, double& outMax) const noexcept {
@@ -124,6 +164,13 @@ const PowerData& MeasurementHistory::atByAge(std::size_t ageFromNewest) const {
     return _values[idx];
 }
 
+PowerDelivery::PD_VOLTS MeasurementHistory::levelByAge(std::size_t ageFromNewest) const {
+    if (ageFromNewest >= _valid_count) {
+        throw std::out_of_range("MeasurementHistory::levelByAge out of range");
+    }
+    return static_cast<PowerDelivery::PD_VOLTS>(_levels[(_head + _size - 1 - ageFromNewest) % _size]);
+}
+
 double MeasurementHistory::getCurrentStdDev() const noexcept {
     return getCurrentStdDevLastN(_valid_count);
 }
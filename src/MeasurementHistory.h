@@ -2,10 +2,13 @@
 #pragma once
 #include <vector>
 #include <algorithm>
+#include <deque>
 #include <cstddef>
+#include <cstdint>
 #include <stdexcept>
 #include <limits>
 #include "PowerData.h"
+#include "PowerDelivery.h"
 
 /**
  * @brief Circular buffer for storing PowerData measurements with fixed capacity.
@@ -26,6 +29,8 @@ public:
     void reset() noexcept;
     void setCapacity(std::size_t newCapacity);
     void push(const PowerData& sample) noexcept;
+    // For callers that classified the sample's PD level already
+    void push(const PowerData& sample, PowerDelivery::PD_VOLTS level) noexcept;
 
     // Query methods
     [[nodiscard]] std::size_t capacity() const noexcept { return _size; }
@@ -33,6 +38,16 @@ public:
     [[nodiscard]] bool is_empty() const noexcept { return _valid_count == 0; }
     [[nodiscard]] bool is_full() const noexcept { return _valid_count == _size; }
 
+    // Change tracking for incremental consumers such as CurrentGraph:
+    // pushCount() is the number of samples pushed since the last reset, epoch()
+    // changes whenever existing samples are discarded (reset, setCapacity).
+    [[nodiscard]] std::uint64_t pushCount() const noexcept { return _push_count; }
+    [[nodiscard]] std::uint64_t epoch() const noexcept { return _epoch; }
+
+    // Current range of the whole history in O(1), from monotonic queues
+    // that push keeps up to date in amortized O(1).
+    bool minMaxCurrent(double& outMin, double& outMax) const noexcept;
+
     // Statistical operations on last N samples
     bool minMaxCurrentLastN(std::size_t lastN, double& outMin, double& outMax) const noexcept;
     [[nodiscard]] bool maxValuesLastN(std::size_t lastN, double& maxVoltage, double& maxCurrent, double& maxPower) const noexcept;
@@ -45,6 +60,21 @@ public:
     // Optional: single sample access by age (0 = newest, size()-1 = oldest)
     [[nodiscard]] const PowerData& atByAge(std::size_t ageFromNewest) const;
 
+    // PD level of a sample, classified once when it was pushed
+    [[nodiscard]] PowerDelivery::PD_VOLTS levelByAge(std::size_t ageFromNewest) const;
+
+    // Visits the last N samples and their PD levels in chronological order
+    // without copying them
+    template<typename Visitor>
+    void forEachLastNOldestFirst(std::size_t lastN, Visitor &&visit) const {
+        lastN = std::min(lastN, _valid_count);
+        std::size_t idx = (_head + _size - lastN) % _size;
+        for (std::size_t i = 0; i < lastN; ++i) {
+            visit(_values[idx], static_cast<PowerDelivery::PD_VOLTS>(_levels[idx]));
+            idx = inc(idx);
+        }
+    }
+
     // Statistics
     [[nodiscard]] double getCurrentStdDev() const noexcept;
     [[nodiscard]] double getCurrentStdDevLastN(std::size_t lastN) const noexcept;
@@ -62,6 +92,13 @@ public:
 
     std::size_t _size;
     std::vector<PowerData> _values;
+    std::vector<std::uint8_t> _levels;  // PD_VOLTS per slot of _values
     std::size_t _valid_count = 0;  // number of valid samples
     std::size_t _head = 0;  // next write position (newest+1)
+    std::uint64_t _push_count = 0;
+    std::uint64_t _epoch = 0;
+    // Slots that may still become the minimum (ascending current) or the
+    // maximum (descending current), oldest first
+    std::deque<std::size_t> _minSlots;
+    std::deque<std::size_t> _maxSlots;
 };
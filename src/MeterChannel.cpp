@@ -0,0 +1,148 @@
+#include "MeterChannel.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+MeterChannel::MeterChannel(const QString &portName,
+                           std::size_t historyCapacity, QObject *parent)
+    : QObject(parent), m_portName(portName),
+      m_serialManager(new SerialManager()), m_thread(new QThread(this)),
+      m_history(new MeasurementHistory(historyCapacity)),
+      m_reconnectTimer(new QTimer(this)) {
+  m_thread->setObjectName("meter:" + portName);
+  m_serialManager->moveToThread(m_thread);
+
+  connect(m_serialManager, &SerialManager::deviceConnected, this,
+          &MeterChannel::onDeviceConnected);
+  connect(m_serialManager, &SerialManager::deviceDisconnected, this,
+          &MeterChannel::onDeviceDisconnected);
+  // Accumulated and pushed on the acquisition thread; the GUI only hears
+  // about it once per batch through historyChanged()
+  connect(m_serialManager, &SerialManager::dataReceived, this,
+          &MeterChannel::onDataReceived, Qt::DirectConnection);
+  // Deleted on its own thread once the event loop has stopped
+  connect(m_thread, &QThread::finished, m_serialManager,
+          &QObject::deleteLater);
+
+  m_reconnectTimer->setInterval(1000);
+  connect(m_reconnectTimer, &QTimer::timeout, this, &MeterChannel::open);
+  connect(this, &MeterChannel::connectFailed, this, [this] {
+    m_isConnecting = false;
+    if (!m_isClosed && !m_reconnectTimer->isActive()) {
+      m_reconnectTimer->start();
+    }
+  });
+
+  m_thread->start();
+}
+
+MeterChannel::~MeterChannel() {
+  // Only channels still open at exit wait here; shutdown() deletes the
+  // others after their thread has finished
+  stopThread();
+  m_thread->wait();
+  delete m_history;
+}
+
+void MeterChannel::open() {
+  if (m_isConnected || m_isConnecting || m_isStopping) {
+    return;
+  }
+  m_isClosed = false;
+  m_isConnecting = true;
+  // Probing the protocol takes seconds; run it on the acquisition thread so
+  // neither the GUI nor the other meters wait for it.
+  QMetaObject::invokeMethod(
+      m_serialManager,
+      [this] {
+        if (!m_serialManager->tryConnect(m_portName)) {
+          emit connectFailed();
+        }
+      },
+      Qt::QueuedConnection);
+}
+
+void MeterChannel::close() {
+  m_isClosed = true;
+  m_reconnectTimer->stop();
+  QMetaObject::invokeMethod(m_serialManager, "disconnect",
+                            Qt::QueuedConnection);
+  if (m_isConnected) {
+    m_isConnected = false;
+    emit disconnected();
+  }
+}
+
+void MeterChannel::shutdown() {
+  connect(m_thread, &QThread::finished, this, &QObject::deleteLater);
+  stopThread();
+}
+
+void MeterChannel::stopThread() {
+  if (m_isStopping) {
+    return;
+  }
+  m_isStopping = true;
+  m_isClosed = true;
+  m_reconnectTimer->stop();
+  // Queued behind a connection attempt in progress, which may take seconds
+  auto *thread = m_thread;
+  QMetaObject::invokeMethod(
+      m_serialManager,
+      [serialManager = m_serialManager, thread] {
+        serialManager->disconnect();
+        thread->quit();
+      },
+      Qt::QueuedConnection);
+}
+
+bool MeterChannel::reading(Reading &reading) const {
+  QMutexLocker locker(&m_historyMutex);
+  if (!m_history->maxValuesLastN(3, reading.voltage, reading.current,
+                                 reading.power)) {
+    return false;
+  }
+  reading.energy = m_energyAccumulator;
+  return true;
+}
+
+void MeterChannel::onDeviceConnected(const QString &deviceName) {
+  m_isConnecting = false;
+  m_isConnected = true;
+  m_reconnectTimer->stop();
+  emit connected(deviceName);
+}
+
+void MeterChannel::onDeviceDisconnected() {
+  m_isConnected = false;
+  emit disconnected();
+  if (!m_isClosed) {
+    m_reconnectTimer->start();
+  }
+}
+
+void MeterChannel::onDataReceived(const PowerData &data) {
+  PowerData sample = data;
+  {
+    QMutexLocker locker(&m_historyMutex);
+    if (m_lastTimestamp != 0 && sample.timestamp > m_lastTimestamp) {
+      const double timeDelta =
+          static_cast<double>(sample.timestamp - m_lastTimestamp) / 1000.0;
+      if (timeDelta < 3600) { // Sanity check (less than 1 hour)
+        m_energyAccumulator += sample.power * (timeDelta / 3600.0);
+      }
+    }
+    sample.energy = m_energyAccumulator;
+    m_lastTimestamp = sample.timestamp;
+    m_history->push(sample);
+  }
+  if (!m_historyChangePosted.exchange(true)) {
+    QMetaObject::invokeMethod(
+        this,
+        [this] {
+          m_historyChangePosted.store(false);
+          emit historyChanged();
+        },
+        Qt::QueuedConnection);
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef METERCHANNEL_H
+#define METERCHANNEL_H
+
+#include "MeasurementHistory.h"
+#include "PowerData.h"
+#include "SerialManager.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+
+// An additional serial meter monitored alongside the primary device.
+// Every channel runs its SerialManager on a dedicated acquisition thread and
+// keeps its own MeasurementHistory and energy accumulator. Samples are
+// accumulated and pushed on that thread too, so meters never share a reader
+// and a busy meter cannot starve a quiet one or the GUI.
+class MeterChannel : public QObject {
+  Q_OBJECT
+
+public:
+  MeterChannel(const QString &portName, std::size_t historyCapacity,
+               QObject *parent = nullptr);
+  ~MeterChannel() override;
+
+  // Starts an asynchronous connection attempt; the result is reported via
+  // connected() or connectFailed().
+  void open();
+  void close();
+  // Closes the port and deletes the channel once its thread has finished,
+  // without waiting for a connection attempt in progress
+  void shutdown();
+
+  struct Reading {
+    double voltage;
+    double current;
+    double power;
+    double energy;
+  };
+  // Maximum of the last few samples and the accumulated energy; false
+  // before the first sample
+  bool reading(Reading &reading) const;
+
+  [[nodiscard]] const QString &portName() const { return m_portName; }
+  // Pushed to on the acquisition thread; read it under historyLock()
+  [[nodiscard]] MeasurementHistory *history() const { return m_history; }
+  [[nodiscard]] QMutex *historyLock() const { return &m_historyMutex; }
+  [[nodiscard]] bool isConnected() const { return m_isConnected; }
+
+signals:
+  void connected(const QString &deviceName);
+  void connectFailed();
+  void disconnected();
+  // Samples were pushed to the history; posted at most once until handled
+  void historyChanged();
+
+private slots:
+  void onDeviceConnected(const QString &deviceName);
+  void onDeviceDisconnected();
+
+private:
+  // Runs on the acquisition thread
+  void onDataReceived(const PowerData &data);
+  void stopThread();
+
+  QString m_portName;
+  SerialManager *m_serialManager;
+  QThread *m_thread;
+  MeasurementHistory *m_history;
+  QTimer *m_reconnectTimer;
+  mutable QMutex m_historyMutex;
+  std::atomic<bool> m_historyChangePosted{false};
+
+  // Written on the acquisition thread under m_historyMutex
+  double m_energyAccumulator = 0.0;
+  quint64 m_lastTimestamp = 0;
+
+  bool m_isConnected = false;
+  bool m_isConnecting = false;
+  bool m_isClosed = false;
+  bool m_isStopping = false;
+};
+
+#endif // METERCHANNEL_H
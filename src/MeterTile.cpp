@@ -0,0 +1,77 @@
+// ReSharper disable CppDFAMemoryLeak
+#include "MeterTile.h"
+
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QToolButton>
+#include <QVBoxLayout>
+
+MeterTile::MeterTile(MeterChannel *meter, OsdSettings *settings,
+                     QWidget *parent)
+    : QFrame(parent), m_meter(meter), m_settings(settings),
+      m_title(new QLabel(meter->portName())), m_reading(new QLabel("---")),
+      m_removeButton(new QToolButton),
+      m_graph(new CurrentGraph(nullptr, meter->history(), settings)),
+      m_updateTimer(new QTimer(this)) {
+  setFrameShape(QFrame::StyledPanel);
+
+  m_reading->setFont(
+      QFont(settings->secondary_font_name, settings->secondary_font_size));
+  m_reading->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+  m_removeButton->setText("x");
+  m_removeButton->setToolTip("Stop monitoring this meter");
+  connect(m_removeButton, &QToolButton::clicked, this,
+          [this] { emit removeRequested(m_meter->portName()); });
+
+  auto *header = new QHBoxLayout;
+  header->addWidget(m_title);
+  header->addStretch();
+  header->addWidget(m_removeButton);
+
+  auto *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(4, 4, 4, 4);
+  layout->addLayout(header);
+  layout->addWidget(m_reading);
+  layout->addWidget(m_graph, 1);
+
+  connect(meter, &MeterChannel::connected, this,
+          [this](const QString &deviceName) {
+            m_title->setText(deviceName);
+            m_updateTimer->start();
+          });
+  connect(meter, &MeterChannel::disconnected, this, [this] {
+    m_updateTimer->stop();
+    m_title->setText(m_meter->portName() + " (disconnected)");
+    m_reading->setText("---");
+  });
+
+  m_graph->setHistoryLock(meter->historyLock());
+  connect(meter, &MeterChannel::historyChanged, m_graph,
+          &CurrentGraph::onHistoryChanged);
+
+  m_updateTimer->setInterval(200);
+  connect(m_updateTimer, &QTimer::timeout, this, &MeterTile::updateLabels);
+  onColorChanged();
+}
+
+void MeterTile::onColorChanged() {
+  const QString style =
+      "QLabel { color: " + m_settings->color_text.name() + "; }";
+  m_title->setStyleSheet(style);
+  m_reading->setStyleSheet(style);
+  m_graph->onColorsChanged();
+}
+
+void MeterTile::updateLabels() {
+  MeterChannel::Reading reading;
+  if (!m_meter->reading(reading)) {
+    m_reading->setText("---");
+    return;
+  }
+  m_reading->setText(QString("%1V  %2A  %3W  %4Wh")
+                         .arg(reading.voltage, 0, 'f', 2)
+                         .arg(reading.current, 0, 'f', 4)
+                         .arg(reading.power, 0, 'f', 3)
+                         .arg(reading.energy, 0, 'f', 3));
+}
@@ -0,0 +1,44 @@
+#ifndef METERTILE_H
+#define METERTILE_H
+
+#include "CurrentGraph.h"
+#include "MeterChannel.h"
+#include "OsdSettings.h"
+
+#include <QFrame>
+#include <QTimer>
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QToolButton;
+QT_END_NAMESPACE
+
+// Compact readout and current graph for one additional meter
+class MeterTile : public QFrame {
+  Q_OBJECT
+
+public:
+  MeterTile(MeterChannel *meter, OsdSettings *settings,
+            QWidget *parent = nullptr);
+
+  [[nodiscard]] MeterChannel *meter() const { return m_meter; }
+
+  void onColorChanged();
+
+signals:
+  void removeRequested(const QString &portName);
+
+private slots:
+  void updateLabels();
+
+private:
+  MeterChannel *m_meter;
+  OsdSettings *m_settings;
+  QLabel *m_title;
+  QLabel *m_reading;
+  QToolButton *m_removeButton;
+  CurrentGraph *m_graph;
+  QTimer *m_updateTimer;
+};
+
+#endif // METERTILE_H
@@ -0,0 +1,197 @@
+#include "MetricsServer.h"
+
+#include "NetworkAddress.h"
+
+#include <QDebug>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <cmath>
+#include <memory>
+
+namespace {
+// Scrapers send a few hundred bytes; anything longer is not one
+constexpr int kMaxRequestBytes = 8192;
+// Drops connections that never finish their request
+constexpr int kRequestTimeoutMs = 5000;
+
+QByteArray formatValue(double value) {
+  if (std::isnan(value)) {
+    return "NaN";
+  }
+  if (std::isinf(value)) {
+    return value > 0 ? "+Inf" : "-Inf";
+  }
+  // QByteArray::number ignores the locale
+  return QByteArray::number(value, 'g', 15);
+}
+} // namespace
+
+void MetricsText::family(const char *name, const char *type, const char *help) {
+  m_text += QByteArray("# HELP ") + name + ' ' + help + '\n';
+  m_text += QByteArray("# TYPE ") + name + ' ' + type + '\n';
+}
+
+void MetricsText::value(const char *name, double value, const char *labels) {
+  m_text += name;
+  if (labels && *labels) {
+    m_text += QByteArray("{") + labels + '}';
+  }
+  m_text += ' ' + formatValue(value) + '\n';
+}
+
+void MetricsText::histogram(const char *name, const char *help,
+                            const LatencyHistogram::Snapshot &snapshot) {
+  family(name, "histogram", help);
+  histogramValues(name, snapshot);
+}
+
+void MetricsText::histogramValues(const char *name,
+                                  const LatencyHistogram::Snapshot &snapshot,
+                                  const char *labels) {
+  const QByteArray prefix = labels && *labels ? QByteArray(labels) + ',' : QByteArray();
+  const QByteArray bucketName = QByteArray(name) + "_bucket";
+  std::uint64_t cumulative = 0;
+  for (std::size_t i = 0; i < LatencyHistogram::kBounds; ++i) {
+    cumulative += snapshot.buckets[i];
+    const QByteArray le =
+        prefix + "le=\"" + formatValue(LatencyHistogram::kBoundsUs[i] / 1e6) + '"';
+    value(bucketName.constData(), static_cast<double>(cumulative), le.constData());
+  }
+  value(bucketName.constData(), static_cast<double>(snapshot.count),
+        (prefix + "le=\"+Inf\"").constData());
+  value((QByteArray(name) + "_sum").constData(), snapshot.sumNs / 1e9, labels);
+  value((QByteArray(name) + "_count").constData(), static_cast<double>(snapshot.count),
+        labels);
+}
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QObject(parent), m_thread(new QThread(this)), m_serverContext(new QObject) {
+  m_thread->setObjectName("metrics");
+  m_serverContext->moveToThread(m_thread);
+  m_thread->start(QThread::LowPriority);
+}
+
+MetricsServer::~MetricsServer() {
+  close();
+  m_thread->quit();
+  m_thread->wait();
+  delete m_serverContext;
+}
+
+void MetricsServer::setRenderer(Renderer renderer) {
+  QMetaObject::invokeMethod(
+      m_serverContext, [this, renderer] { m_renderer = renderer; },
+      Qt::BlockingQueuedConnection);
+}
+
+bool MetricsServer::listen(const QString &address, QString *error) {
+  close();
+  bool bound = false;
+  QString message;
+  QMetaObject::invokeMethod(
+      m_serverContext, [this, address, &message] { return bind(address, &message); },
+      Qt::BlockingQueuedConnection, &bound);
+  if (!bound) {
+    if (error) {
+      *error = message;
+    }
+    return false;
+  }
+  qDebug() << "Serving metrics on" << address;
+  m_listening = true;
+  return true;
+}
+
+void MetricsServer::close() {
+  if (!m_listening) {
+    return;
+  }
+  m_listening = false;
+  QMetaObject::invokeMethod(
+      m_serverContext,
+      [this] {
+        delete m_server;
+        m_server = nullptr;
+      },
+      Qt::BlockingQueuedConnection);
+}
+
+bool MetricsServer::bind(const QString &address, QString *error) {
+  QHostAddress hostAddress;
+  quint16 port = 0;
+  if (!parseHostPort(address, hostAddress, port)) {
+    *error = "Invalid metrics address " + address + ", expected [<host>:]<port>";
+    return false;
+  }
+
+  auto *server = new QTcpServer(m_serverContext);
+  if (!server->listen(hostAddress, port)) {
+    *error = "Cannot listen on " + address + ": " + server->errorString();
+    delete server;
+    return false;
+  }
+  connect(server, &QTcpServer::newConnection, m_serverContext, [this, server] {
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+      // One request per connection; answered once its headers are complete
+      auto request = std::make_shared<QByteArray>();
+      auto answered = std::make_shared<bool>(false);
+      connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+      connect(socket, &QTcpSocket::readyRead, m_serverContext,
+              [this, socket, request, answered] {
+                if (*answered) {
+                  socket->readAll();
+                  return;
+                }
+                request->append(socket->readAll());
+                const qsizetype end = request->indexOf("\r\n\r\n");
+                if (end < 0 && request->size() < kMaxRequestBytes) {
+                  return;
+                }
+                *answered = true;
+                respond(socket, end < 0 ? QByteArray() : request->left(end));
+              });
+      QTimer::singleShot(kRequestTimeoutMs, socket, [socket] { socket->abort(); });
+    }
+  });
+  m_server = server;
+  return true;
+}
+
+void MetricsServer::respond(QTcpSocket *socket, const QByteArray &request) {
+  // "GET /metrics?x=y HTTP/1.1"
+  const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+  const QByteArray method = requestLine.value(0);
+  QByteArray path = requestLine.value(1);
+  path = path.left(path.indexOf('?') < 0 ? path.size() : path.indexOf('?'));
+
+  QByteArray status = "200 OK";
+  QByteArray contentType = "text/plain; version=0.0.4; charset=utf-8";
+  QByteArray body;
+  if (request.isEmpty()) {
+    status = "431 Request Header Fields Too Large";
+    contentType = "text/plain";
+  } else if (method != "GET" && method != "HEAD") {
+    status = "405 Method Not Allowed";
+    contentType = "text/plain";
+  } else if (path == "/metrics") {
+    body = m_renderer ? m_renderer() : QByteArray();
+  } else if (path == "/") {
+    contentType = "text/html";
+    body = "<html><body><a href=\"/metrics\">Metrics</a></body></html>\n";
+  } else {
+    status = "404 Not Found";
+    contentType = "text/plain";
+    body = "Not found\n";
+  }
+
+  QByteArray response = "HTTP/1.1 " + status + "\r\nContent-Type: " + contentType +
+                        "\r\nContent-Length: " + QByteArray::number(body.size()) +
+                        "\r\nConnection: close\r\n\r\n";
+  if (method != "HEAD") {
+    response += body;
+  }
+  socket->write(response);
+  socket->disconnectFromHost();
+}
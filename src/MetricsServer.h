@@ -0,0 +1,68 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include "LatencyHistogram.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QThread>
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+class QTcpSocket;
+QT_END_NAMESPACE
+
+// Builds a page in the Prometheus text exposition format
+class MetricsText {
+public:
+  // The # HELP and # TYPE lines, once before the samples of a metric
+  void family(const char *name, const char *type, const char *help);
+  // labels is preformatted, e.g. level="5V"
+  void value(const char *name, double value, const char *labels = nullptr);
+  // A histogram family in seconds: cumulative buckets, _sum and _count
+  void histogram(const char *name, const char *help,
+                 const LatencyHistogram::Snapshot &snapshot);
+  // The samples of one labelled histogram, after family(name, "histogram")
+  void histogramValues(const char *name, const LatencyHistogram::Snapshot &snapshot,
+                       const char *labels = nullptr);
+
+  [[nodiscard]] const QByteArray &text() const { return m_text; }
+
+private:
+  QByteArray m_text;
+};
+
+// Serves GET /metrics over HTTP for monitoring systems to scrape, from its
+// own thread so scrapes neither wait for nor slow down the window. The
+// page comes from a renderer function that runs on the server thread and
+// must only read thread-safe state (atomics or snapshots).
+class MetricsServer : public QObject {
+  Q_OBJECT
+
+public:
+  using Renderer = std::function<QByteArray()>;
+
+  explicit MetricsServer(QObject *parent = nullptr);
+  ~MetricsServer() override;
+
+  void setRenderer(Renderer renderer);
+
+  // "<port>" (localhost only) or "<host>:<port>"; false with a message in
+  // error if it cannot be bound
+  bool listen(const QString &address, QString *error = nullptr);
+  void close();
+  [[nodiscard]] bool isListening() const { return m_listening; }
+
+private:
+  // Server thread only
+  bool bind(const QString &address, QString *error);
+  void respond(QTcpSocket *socket, const QByteArray &request);
+
+  QThread *m_thread;
+  QObject *m_serverContext;
+  QObject *m_server = nullptr;
+  Renderer m_renderer;
+  bool m_listening = false;
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,13 @@
+#include "NetworkAddress.h"
+
+bool parseHostPort(const QString &address, QHostAddress &host, quint16 &port) {
+  const int colon = address.lastIndexOf(':');
+  QString name = colon < 0 ? QString() : address.left(colon);
+  if (name.startsWith('[') && name.endsWith(']')) {
+    name = name.mid(1, name.size() - 2);
+  }
+  bool ok = false;
+  port = address.mid(colon + 1).toUShort(&ok);
+  host = name.isEmpty() ? QHostAddress(QHostAddress::LocalHost) : QHostAddress(name);
+  return ok && !host.isNull();
+}
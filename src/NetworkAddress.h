@@ -0,0 +1,11 @@
+#ifndef NETWORKADDRESS_H
+#define NETWORKADDRESS_H
+
+#include <QHostAddress>
+#include <QString>
+
+// Parses the TCP addresses of the servers: "<port>" for localhost,
+// "<host>:<port>" or "[<ipv6>]:<port>". False if the port or host is invalid.
+bool parseHostPort(const QString &address, QHostAddress &host, quint16 &port);
+
+#endif // NETWORKADDRESS_H
@@ -1,33 +1,67 @@
 #include "OsdSettings.h"
 
-#include "MainWindow.h"
-#include "SettingsDialog.h"
-
-#include <QApplication>
 #include <QDebug>
+#include <QGuiApplication>
+#include <QThread>
+#include <QTimer>
 #include <QtGui/qscreen.h>
+#include <algorithm>
 #include <iostream>
+#include <utility>
+
+namespace {
+// Quiet period before pending changes are written ...
+constexpr int kFlushDelayMs = 1000;
+// ... unless changes keep coming for longer than this
+constexpr qint64 kMaxFlushDelayMs = 5000;
+} // namespace
 
 OsdSettings::OsdSettings( // NOLINT(*-pro-type-member-init)
     const QString &organization, // NOLINT(*-pro-type-member-init)
     const QString &application, QObject *parent)
-    : QSettings(organization, application, parent) {
+    : QSettings(organization, application, parent),
+      m_flushTimer(new QTimer(this)), m_ioThread(new QThread(this)),
+      m_ioContext(new QObject) {
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(kFlushDelayMs);
+    connect(m_flushTimer, &QTimer::timeout, this, [this] { writeBehind(false); });
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &OsdSettings::flush);
+
+    m_ioThread->setObjectName("settings-io");
+    m_ioContext->moveToThread(m_ioThread);
+    connect(m_ioThread, &QThread::finished, m_ioContext, &QObject::deleteLater);
+    m_ioThread->start(QThread::LowPriority);
+
     init();
 }
 
+OsdSettings::~OsdSettings() {
+    flush();
+    m_ioThread->quit();
+    m_ioThread->wait();
+}
+
 void OsdSettings::init() {
-    qreal scale = QApplication::primaryScreen()->devicePixelRatio();
+    // No screen in the headless mode, where the fonts do not matter anyway
+    qreal scale = 1.0;
+    if (qobject_cast<QGuiApplication *>(QCoreApplication::instance()) &&
+        QGuiApplication::primaryScreen()) {
+        scale = QGuiApplication::primaryScreen()->devicePixelRatio();
+    }
 
     // Default settings
     always_on_top = false;
     is_energy_displayed = false;
     is_audio_enabled = false;
+    audio_low_latency = true;
+    audio_buffer_ms = 20;
     window_height = 300;
     window_width = 400;
     window_top = 0;
     window_left = 0;
     min_current = 0;
     current_diff_ma = 0;
+    history_size = 1000;
     primary_font_size = static_cast<int>(static_cast<double>(24) * scale);
     secondary_font_size = static_cast<int>(static_cast<double>(18) * scale);
 #if TARGET_OS_OSX
@@ -51,6 +85,7 @@ void OsdSettings::init() {
     color_36v = QColor(0x00, 0xff, 0xff);
     color_48v = QColor(0x00, 0x00, 0xff);
     last_device = QString();
+    extra_devices = QStringList();
     loadSettings();
 }
 
@@ -88,33 +123,90 @@ QColor OsdSettings::voltsRgb(PowerDelivery::PD_VOLTS volts) const {
     return color;
 }
 
+QVariantMap OsdSettings::persistentValues() const {
+    QVariantMap values;
+    values.insert("view/always_on_top", this->always_on_top);
+    values.insert("view/is_energy_displayed", this->is_energy_displayed);
+    values.insert("view/is_audio_enabled", this->is_audio_enabled);
+    values.insert("audio/low_latency", this->audio_low_latency);
+    values.insert("audio/buffer_ms", this->audio_buffer_ms);
+    values.insert("window/height", this->window_height);
+    values.insert("window/width", this->window_width);
+    values.insert("window/top", this->window_top);
+    values.insert("window/left", this->window_left);
+    values.insert("measurement/primary_font_name", this->primary_font_name);
+    values.insert("measurement/primary_font_size", this->primary_font_size);
+    values.insert("measurement/secondary_font_name", this->secondary_font_name);
+    values.insert("measurement/secondary_font_size", this->secondary_font_size);
+    values.insert("measurement/min_current", this->min_current);
+    values.insert("measurement/current_diff", this->current_diff_ma);
+    values.insert("measurement/history_size", this->history_size);
+    values.insert("colors/background", this->color_bg);
+    values.insert("colors/amps", this->color_text);
+    values.insert("colors/5v", this->color_5v);
+    values.insert("colors/9v", this->color_9v);
+    values.insert("colors/15v", this->color_15v);
+    values.insert("colors/20v", this->color_20v);
+    values.insert("colors/28v", this->color_28v);
+    values.insert("colors/36v", this->color_36v);
+    values.insert("colors/48v", this->color_48v);
+    values.insert("device/last", this->last_device);
+    values.insert("device/extra", this->extra_devices);
+    values.insert("measurement/pd_bands", this->pd_bands);
+    values.insert("stream/listen", this->stream_listen);
+    values.insert("stream/shared_ring", this->shared_ring_name);
+    values.insert("stream/metrics", this->metrics_listen);
+    values.insert("stream/control", this->control_socket);
+    return values;
+}
+
 void OsdSettings::saveSettings() {
-    setValue("view/always_on_top", this->always_on_top);
-    setValue("view/is_energy_displayed", this->is_energy_displayed);
-    setValue("view/is_audio_enabled", this->is_audio_enabled);
-    setValue("window/height", this->window_height);
-    setValue("window/width", this->window_width);
-    setValue("window/top", this->window_top);
-    setValue("window/left", this->window_left);
-    setValue("measurement/primary_font_name", this->primary_font_name);
-    setValue("measurement/primary_font_size", this->primary_font_size);
-    setValue("measurement/secondary_font_name", this->secondary_font_name);
-    setValue("measurement/secondary_font_size", this->secondary_font_size);
-    setValue("measurement/min_current", this->min_current);
-    setValue("measurement/current_diff", this->current_diff_ma);
-    setValue("colors/background", this->color_bg);
-    setValue("colors/amps", this->color_text);
-    setValue("colors/5v", this->color_5v);
-    setValue("colors/9v", this->color_9v);
-    setValue("colors/15v", this->color_15v);
-    setValue("colors/20v", this->color_20v);
-    setValue("colors/28v", this->color_28v);
-    setValue("colors/36v", this->color_36v);
-    setValue("colors/48v", this->color_48v);
-    setValue("device/last", this->last_device);
-
-    // Ensure settings are written to disk
-    sync();
+    const QVariantMap values = persistentValues();
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        auto persisted = m_persisted.constFind(it.key());
+        if (persisted == m_persisted.cend() || persisted.value() != it.value()) {
+            m_dirty.insert(it.key(), it.value());
+            m_persisted.insert(it.key(), it.value());
+        }
+    }
+    if (m_dirty.isEmpty()) {
+        return;
+    }
+    if (!m_dirtySince.isValid()) {
+        m_dirtySince.start();
+    }
+    if (m_dirtySince.elapsed() >= kMaxFlushDelayMs) {
+        writeBehind(false);
+    } else {
+        m_flushTimer->start();
+    }
+}
+
+void OsdSettings::flush() {
+    saveSettings();
+    writeBehind(true);
+}
+
+void OsdSettings::writeBehind(bool wait) {
+    m_flushTimer->stop();
+    m_dirtySince.invalidate();
+    if (m_dirty.isEmpty() && !wait) {
+        return;
+    }
+    // QSettings objects must not be shared between threads, but separate
+    // instances on the same file are fine and see each other's changes
+    auto write = [organization = organizationName(),
+                  application = applicationName(),
+                  changes = std::exchange(m_dirty, {})] {
+        QSettings store(organization, application);
+        for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+            store.setValue(it.key(), it.value());
+        }
+        store.sync();
+    };
+    QMetaObject::invokeMethod(m_ioContext, write,
+                              wait ? Qt::BlockingQueuedConnection
+                                   : Qt::QueuedConnection);
 }
 
 QColor OsdSettings::colorValue(const QString &key,
@@ -132,6 +224,10 @@ void OsdSettings::loadSettings() {
             value("view/is_energy_displayed", this->is_energy_displayed).toBool();
     this->is_audio_enabled =
             value("view/is_audio_enabled", this->is_audio_enabled).toBool();
+    this->audio_low_latency =
+            value("audio/low_latency", this->audio_low_latency).toBool();
+    this->audio_buffer_ms =
+            std::clamp(value("audio/buffer_ms", this->audio_buffer_ms).toInt(), 5, 1000);
     this->window_height = value("window/height", this->window_height).toInt();
     this->window_width = value("window/width", this->window_width).toInt();
     this->window_top = value("window/top", this->window_top).toInt();
@@ -151,6 +247,8 @@ void OsdSettings::loadSettings() {
             value("measurement/min_current", this->min_current).toFloat();
     this->current_diff_ma =
             value("measurement/current_diff", this->current_diff_ma).toInt();
+    this->history_size =
+            std::max(1, value("measurement/history_size", this->history_size).toInt());
 
     this->color_text = colorValue("colors/amps", this->color_text);
     this->color_5v = colorValue("colors/5v", this->color_5v);
@@ -161,4 +259,47 @@ void OsdSettings::loadSettings() {
     this->color_36v = colorValue("colors/36v", this->color_36v);
     this->color_48v = colorValue("colors/48v", this->color_48v);
     this->last_device = value("device/last", this->last_device).toString();
+    this->extra_devices =
+            value("device/extra", this->extra_devices).toStringList();
+    this->pd_bands =
+            value("measurement/pd_bands", this->pd_bands).toStringList();
+    this->stream_listen =
+            value("stream/listen", this->stream_listen).toStringList();
+    this->shared_ring_name =
+            value("stream/shared_ring", this->shared_ring_name).toString();
+    this->metrics_listen =
+            value("stream/metrics", this->metrics_listen).toString();
+    this->control_socket =
+            value("stream/control", this->control_socket).toString();
+    applyPdBands();
+    m_persisted = persistentValues();
+}
+
+void OsdSettings::applyPdBands() const {
+    std::vector<PowerDelivery::Band> bands;
+    for (const QString &entry : pd_bands) {
+        const QStringList rangeAndLevel = entry.trimmed().split(':');
+        const QStringList range = rangeAndLevel.value(0).split('-');
+        bool ok[3] = {};
+        const int min_mv = range.value(0).toInt(&ok[0]);
+        const int max_mv = range.value(1).toInt(&ok[1]);
+        const int volts = rangeAndLevel.value(1).toInt(&ok[2]);
+        if (rangeAndLevel.size() != 2 || range.size() != 2 || !ok[0] ||
+            !ok[1] || !ok[2] || min_mv > max_mv) {
+            qWarning() << "Ignoring malformed PD band" << entry;
+            continue;
+        }
+        auto level = PowerDelivery::PD_NONE;
+        for (int i = PowerDelivery::PD_5V; i <= PowerDelivery::PD_48V; ++i) {
+            if (PowerDelivery::getVoltage(static_cast<PowerDelivery::PD_VOLTS>(i)) == volts) {
+                level = static_cast<PowerDelivery::PD_VOLTS>(i);
+            }
+        }
+        if (level == PowerDelivery::PD_NONE) {
+            qWarning() << "Ignoring PD band with unknown level" << entry;
+            continue;
+        }
+        bands.push_back({min_mv, max_mv, level});
+    }
+    PowerDelivery::setBands(bands);
 }
@@ -7,7 +7,14 @@
 
 #include "PowerDelivery.h"
 
+#include <QElapsedTimer>
 #include <QSettings>
+#include <QVariantMap>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+class QTimer;
+QT_END_NAMESPACE
 #include <QtGui/qcolor.h>
 #include <QtWidgets/qstyle.h>
 
@@ -18,6 +25,9 @@ public:
     bool always_on_top = false;
     bool is_energy_displayed = false;
     bool is_audio_enabled = false;
+    // Small explicit sink buffer instead of the backend default
+    bool audio_low_latency = true;
+    int audio_buffer_ms = 20;
     int window_top;
     int window_left;
     int window_height;
@@ -28,6 +38,7 @@ public:
     int secondary_font_size;
     float min_current = 0.0;
     int current_diff_ma = 0;
+    int history_size = 1000;
     QColor color_bg;
     QColor color_text;
     QColor color_none;
@@ -39,19 +50,55 @@ public:
     QColor color_36v;
     QColor color_48v;
     QString last_device;
+    QStringList extra_devices;
+    // Extra voltage bands for PPS/AVS supplies, "<min_mv>-<max_mv>:<volts>"
+    // where volts names the PD level to report, e.g. "3300-21000:20"
+    QStringList pd_bands;
+    // Addresses the live samples are published on, e.g. "unix:/tmp/usb-power.sock"
+    // or "tcp+json:9100"; see StreamServer::listen()
+    QStringList stream_listen;
+    // POSIX shared-memory ring for local readers, e.g. "/usb-power-osd";
+    // empty to not create one
+    QString shared_ring_name;
+    // "[<host>:]<port>" of the Prometheus /metrics endpoint; empty for none
+    QString metrics_listen;
+    // Unix socket path of the JSON-RPC control interface; empty for none
+    QString control_socket;
 
     OsdSettings(const QString &organization, const QString &application,
                 QObject *parent);
+    ~OsdSettings() override;
 
     void init();
 
     QColor voltsRgb(PowerDelivery::PD_VOLTS volts) const;
 
+    // Cheap enough for interactive paths: only records which keys changed.
+    // The changes are written on a background thread once no further change
+    // arrived for a moment, and at the latest on exit.
     void saveSettings();
 
+    // Writes all pending changes and waits until they are on disk
+    void flush();
+
     QColor colorValue(const QString &key, QColor default_color) const;
 
     void loadSettings();
+
+    void applyPdBands() const;
+
+private:
+    // Every persisted key with its current in-memory value
+    [[nodiscard]] QVariantMap persistentValues() const;
+    void writeBehind(bool wait);
+
+    // Values as last handed to the writer, to find the dirty keys
+    QVariantMap m_persisted;
+    QVariantMap m_dirty;
+    QTimer *m_flushTimer;
+    QElapsedTimer m_dirtySince;
+    QThread *m_ioThread;
+    QObject *m_ioContext;
 };
 
 #endif // SETTINGS_H
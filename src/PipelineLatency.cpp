@@ -0,0 +1,71 @@
+#include "PipelineLatency.h"
+
+#include <algorithm>
+#include <chrono>
+
+std::uint64_t PipelineLatency::nowNs() {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+const char *PipelineLatency::stageName(Stage stage) {
+  switch (stage) {
+  case ReadToParse:
+    return "read_to_parse";
+  case ParseToInsert:
+    return "parse_to_insert";
+  case InsertToDraw:
+    return "insert_to_draw";
+  case InsertToShow:
+    return "insert_to_show";
+  case ReadToDraw:
+    return "read_to_draw";
+  case ReadToShow:
+    return "read_to_show";
+  case StageCount:
+    break;
+  }
+  return "unknown";
+}
+
+void PipelineLatency::inserted(const SampleStamps &stamps) {
+  const std::uint64_t now = nowNs();
+  if (stamps.readNs != 0 && stamps.parsedNs >= stamps.readNs) {
+    m_stages[ReadToParse].record(stamps.parsedNs - stamps.readNs);
+  }
+  if (stamps.parsedNs != 0 && now >= stamps.parsedNs) {
+    m_stages[ParseToInsert].record(now - stamps.parsedNs);
+  }
+  m_pending[m_inserted % kPending] = {stamps.readNs, now};
+  ++m_inserted;
+}
+
+void PipelineLatency::drawn(std::uint64_t throughCount) {
+  reached(throughCount, m_drawn, InsertToDraw, ReadToDraw);
+}
+
+void PipelineLatency::shown(std::uint64_t throughCount) {
+  reached(throughCount, m_shown, InsertToShow, ReadToShow);
+}
+
+void PipelineLatency::reached(std::uint64_t throughCount, std::uint64_t &cursor,
+                              Stage fromInsert, Stage fromRead) {
+  throughCount = std::min(throughCount, m_inserted);
+  if (throughCount <= cursor) {
+    return;
+  }
+  const std::uint64_t now = nowNs();
+  // Older stamps were overwritten already
+  const std::uint64_t first =
+      std::max(cursor, m_inserted > kPending ? m_inserted - kPending : 0);
+  for (std::uint64_t i = first; i < throughCount; ++i) {
+    const Stamp &stamp = m_pending[i % kPending];
+    m_stages[fromInsert].record(now - stamp.insertedNs);
+    if (stamp.readNs != 0 && now >= stamp.readNs) {
+      m_stages[fromRead].record(now - stamp.readNs);
+    }
+  }
+  cursor = throughCount;
+}
@@ -0,0 +1,77 @@
+#ifndef PIPELINELATENCY_H
+#define PIPELINELATENCY_H
+
+#include "LatencyHistogram.h"
+
+#include <QMetaType>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Steady clock (PipelineLatency::nowNs()) when a sample's bytes were read
+// and when it was decoded; 0 where the source does not stamp them. Travels
+// next to the PowerData through the acquisition signals, never stored.
+struct SampleStamps {
+  std::uint64_t readNs = 0;
+  std::uint64_t parsedNs = 0;
+};
+
+Q_DECLARE_METATYPE(SampleStamps)
+
+// Where the time goes between the meter and the screen, per sample and
+// stage. The transports stamp each sample when its bytes were read and
+// when it was decoded (SampleStamps); inserted() adds the history insert,
+// drawn() and shown() the first graph frame and label update that
+// included it.
+//
+// inserted(), drawn() and shown() are called on the GUI thread; the
+// histograms may be read from any thread.
+class PipelineLatency {
+public:
+  enum Stage {
+    ReadToParse,
+    ParseToInsert,
+    InsertToDraw,
+    InsertToShow,
+    ReadToDraw,
+    ReadToShow,
+    StageCount
+  };
+
+  // The clock of the stamps
+  static std::uint64_t nowNs();
+  // e.g. "read_to_parse", for metrics and exports
+  static const char *stageName(Stage stage);
+
+  // After the sample with these stamps was pushed to the history
+  void inserted(const SampleStamps &stamps);
+  // Samples inserted so far; what a frame or label update is based on
+  [[nodiscard]] std::uint64_t insertedCount() const { return m_inserted; }
+  // The first throughCount samples are on screen now. Samples that were
+  // kPending or more insertions old by then are not measured.
+  void drawn(std::uint64_t throughCount);
+  void shown(std::uint64_t throughCount);
+
+  [[nodiscard]] LatencyHistogram::Snapshot snapshot(Stage stage) const {
+    return m_stages[stage].snapshot();
+  }
+
+private:
+  static constexpr std::size_t kPending = 1 << 14;
+
+  struct Stamp {
+    std::uint64_t readNs = 0;
+    std::uint64_t insertedNs = 0;
+  };
+
+  void reached(std::uint64_t throughCount, std::uint64_t &cursor,
+               Stage fromInsert, Stage fromRead);
+
+  std::array<Stamp, kPending> m_pending{};
+  std::uint64_t m_inserted = 0;
+  std::uint64_t m_drawn = 0;
+  std::uint64_t m_shown = 0;
+  std::array<LatencyHistogram, StageCount> m_stages;
+};
+
+#endif // PIPELINELATENCY_H
@@ -1,6 +1,9 @@
-
 #include "PowerDelivery.h"
 
+#include <array>
+#include <atomic>
+#include <memory>
+
 const int PowerDelivery::pd_volts[PD_48V+1] = {0, 5, 9, 15, 20, 28, 36, 48};
 
 bool PowerDelivery::within(int value, int base_value) {
@@ -8,28 +11,73 @@ bool PowerDelivery::within(int value, int base_value) {
   return value >= base_value - variance && value <= base_value + variance;
 }
 
-// Get the PD_VOLTS value for a given millivolt
+namespace {
+// All level boundaries (nominal +-20%) are multiples of 100 mV and
+// inclusive, so a 100 mV bucket only needs a separate level for its exact
+// lower edge: that value may still belong to the level below it.
+struct Bucket {
+  std::uint8_t at_edge;
+  std::uint8_t above_edge;
+};
+using LevelTable = std::array<Bucket, PowerDelivery::TABLE_MAX_MV / 100 + 1>;
+
+// Same result as testing within() for 5V, 9V, ... 48V in that order, where
+// the first matching level wins
+constexpr LevelTable makeLevelTable() {
+  constexpr int nominal_mv[PowerDelivery::PD_48V + 1] = {
+      0, 5000, 9000, 15000, 20000, 28000, 36000, 48000};
+  LevelTable table{};
+  for (std::size_t bucket = 0; bucket < table.size(); ++bucket) {
+    const int edge = static_cast<int>(bucket) * 100;
+    std::uint8_t at_edge = PowerDelivery::PD_NONE;
+    std::uint8_t above_edge = PowerDelivery::PD_NONE;
+    for (int level = PowerDelivery::PD_48V; level >= PowerDelivery::PD_5V;
+         --level) {
+      const int variance = nominal_mv[level] / 5;
+      const int low = nominal_mv[level] - variance;
+      const int high = nominal_mv[level] + variance;
+      if (edge >= low && edge <= high) {
+        at_edge = static_cast<std::uint8_t>(level);
+      }
+      if (edge >= low && edge < high) {
+        above_edge = static_cast<std::uint8_t>(level);
+      }
+    }
+    table[bucket] = Bucket{at_edge, above_edge};
+  }
+  return table;
+}
+
+constexpr LevelTable kLevelTable = makeLevelTable();
+
+std::shared_ptr<const std::vector<PowerDelivery::Band>> s_bands;
+std::atomic<bool> s_hasBands{false};
+} // namespace
+
+void PowerDelivery::setBands(const std::vector<Band> &bands) {
+  std::atomic_store(&s_bands, std::make_shared<const std::vector<Band>>(bands));
+  s_hasBands.store(!bands.empty(), std::memory_order_release);
+}
+
+// Get the PD_VOLTS value for a given voltage
 PowerDelivery::PD_VOLTS PowerDelivery::getEnum(float voltage) {
   auto millivolt = static_cast<int>(voltage * 1000);
-  PD_VOLTS voltEnum = PD_NONE;
-  if (within(millivolt, 5000)) {
-    voltEnum = PD_5V;
-  } else if (within(millivolt, 9000)) {
-    voltEnum = PD_9V;
-  } else if (within(millivolt, 15000)) {
-    voltEnum = PD_15V;
-  } else if (within(millivolt, 20000)) {
-    voltEnum = PD_20V;
-  } else if (within(millivolt, 28000)) {
-    voltEnum = PD_28V;
-  } else if (within(millivolt, 36000)) {
-    voltEnum = PD_36V;
-  } else if (within(millivolt, 48000)) {
-    voltEnum = PD_48V;
-  } else {
-    voltEnum = PD_NONE;
+
+  if (s_hasBands.load(std::memory_order_acquire)) {
+    const auto bands = std::atomic_load(&s_bands);
+    for (const auto &band : *bands) {
+      if (millivolt >= band.min_mv && millivolt <= band.max_mv) {
+        return band.level;
+      }
+    }
+  }
+
+  if (millivolt < 0 || millivolt > TABLE_MAX_MV) {
+    return PD_NONE;
   }
-  return voltEnum;
+  const Bucket &bucket = kLevelTable[millivolt / 100];
+  return static_cast<PD_VOLTS>(millivolt % 100 == 0 ? bucket.at_edge
+                                                    : bucket.above_edge);
 }
 
 int PowerDelivery::getVoltage(PD_VOLTS volt) { return pd_volts[volt]; }
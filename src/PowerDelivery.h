@@ -1,13 +1,15 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 // The PowerDelivery class encapsulates the PD_VOLTS enum and related
 // functionality
 class PowerDelivery {
 public:
   // Enum defining power delivery voltage options
-  enum PD_VOLTS {
+  enum PD_VOLTS : std::uint8_t {
     PD_NONE = 0,
     PD_5V = 1,
     PD_9V = 2,
@@ -18,14 +20,28 @@ public:
     PD_48V = 7,
   };
 
+  // A voltage range that is reported as the given level, e.g. a PPS/AVS
+  // supply running at an arbitrary voltage. Bounds are inclusive.
+  struct Band {
+    int min_mv;
+    int max_mv;
+    PD_VOLTS level;
+  };
+
   static bool within(int value, int base_value);
 
-  // Convert from millivolts to corresponding PD_VOLTS enum value
+  // Convert from volts to corresponding PD_VOLTS enum value
   static PD_VOLTS getEnum(float voltage);
 
+  // Configured bands take precedence over the fixed PD levels
+  static void setBands(const std::vector<Band> &bands);
+
   // Get the voltage value in volts corresponding to a given PD_VOLTS value
   static int getVoltage(PD_VOLTS volt);
 
+  // Levels for 100 mV buckets up to this voltage; anything above is PD_NONE
+  static constexpr int TABLE_MAX_MV = 65500;
+
 private:
   // Color definitions corresponding to `PD_VOLTS`
   static const std::string colors[PD_48V+1];
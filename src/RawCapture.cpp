@@ -0,0 +1,177 @@
+#include "RawCapture.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// Bytes buffered per source between the transport and the writer thread;
+// minutes of a serial meter at 115200 baud
+constexpr std::size_t kRingCapacity = 1 << 20;
+constexpr int kDrainIntervalMs = 100;
+} // namespace
+
+RawCapture::RawCapture(QObject *parent)
+    : QObject(parent), m_serial(kRingCapacity), m_ble(kRingCapacity),
+      m_thread(new QThread(this)), m_writerContext(new QObject),
+      m_drainTimer(new QTimer(m_writerContext)) {
+  m_buffer.resize(kRingCapacity);
+  m_drainTimer->setInterval(kDrainIntervalMs);
+  connect(m_drainTimer, &QTimer::timeout, m_writerContext, [this] { drain(); });
+
+  m_thread->setObjectName("capture");
+  m_writerContext->moveToThread(m_thread);
+  m_thread->start(QThread::LowPriority);
+}
+
+RawCapture::~RawCapture() {
+  stop();
+  m_thread->quit();
+  m_thread->wait();
+  delete m_writerContext;
+}
+
+quint64 RawCapture::timestampUs() {
+  return static_cast<quint64>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
+
+bool RawCapture::start(const QString &path) {
+  stop();
+  m_path = path;
+  bool opened = false;
+  QMetaObject::invokeMethod(
+      m_writerContext,
+      [this, path] {
+        // The file starts with bytes of this capture only
+        while (m_serial.ring.pop(m_buffer.data(), m_buffer.size()) > 0) {
+        }
+        while (m_ble.ring.pop(m_buffer.data(), m_buffer.size()) > 0) {
+        }
+        std::string error;
+        if (!m_writer.open(path.toStdString(), &error)) {
+          emit captureError(QString::fromStdString(error));
+          return false;
+        }
+        return true;
+      },
+      Qt::BlockingQueuedConnection, &opened);
+  if (!opened) {
+    return false;
+  }
+  m_captured = 0;
+  m_dropped = 0;
+  m_capturing.store(true, std::memory_order_release);
+
+  // Sources that connected before the capture started. One that connects
+  // right now may end up twice in the file, which replays fine.
+  QMetaObject::invokeMethod(
+      m_writerContext,
+      [this] {
+        const quint64 now = timestampUs();
+        std::vector<unsigned char> record;
+        for (const CaptureSource source : {CaptureSource::Serial, CaptureSource::Ble}) {
+          QByteArray payload;
+          {
+            QMutexLocker locker(&m_sourceMutex);
+            const Channel &sourceChannel = channel(source);
+            if (sourceChannel.protocol.isEmpty()) {
+              continue;
+            }
+            payload = (sourceChannel.protocol + '\t' + sourceChannel.device).toUtf8();
+          }
+          record.resize(kRawCaptureRecordHeaderBytes + payload.size());
+          encodeRawCaptureRecordHeader(record.data(), now, source,
+                                       CaptureRecordType::Connected,
+                                       static_cast<std::uint32_t>(payload.size()));
+          std::copy(payload.begin(), payload.end(),
+                    record.begin() + kRawCaptureRecordHeaderBytes);
+          if (!m_writer.write(record.data(), record.size())) {
+            fail();
+            return;
+          }
+        }
+        m_drainTimer->start();
+      },
+      Qt::BlockingQueuedConnection);
+  return m_capturing.load();
+}
+
+void RawCapture::stop() {
+  if (!m_capturing.exchange(false)) {
+    return;
+  }
+  QMetaObject::invokeMethod(
+      m_writerContext,
+      [this] {
+        m_drainTimer->stop();
+        drain();
+        m_writer.close();
+      },
+      Qt::BlockingQueuedConnection);
+  qDebug() << "Capture" << m_path << "closed," << capturedBytes() << "bytes,"
+           << droppedRecords() << "records dropped";
+}
+
+void RawCapture::setSource(CaptureSource source, const QString &protocol,
+                           const QString &device) {
+  {
+    QMutexLocker locker(&m_sourceMutex);
+    channel(source).protocol = protocol;
+    channel(source).device = device;
+  }
+  if (!m_capturing.load(std::memory_order_acquire)) {
+    return;
+  }
+  const QByteArray payload = (protocol + '\t' + device).toUtf8();
+  push(channel(source), source, CaptureRecordType::Connected, payload.constData(),
+       payload.size(), timestampUs());
+}
+
+void RawCapture::append(CaptureSource source, const char *data, std::size_t size,
+                        quint64 timestampUs) {
+  if (!m_capturing.load(std::memory_order_acquire)) {
+    return;
+  }
+  push(channel(source), source, CaptureRecordType::Data, data, size, timestampUs);
+}
+
+void RawCapture::push(Channel &channel, CaptureSource source, CaptureRecordType type,
+                      const char *data, std::size_t size, quint64 timestampUs) {
+  // Reuses the producer's buffer, so after the first records nothing is
+  // allocated any more
+  channel.record.resize(kRawCaptureRecordHeaderBytes + size);
+  encodeRawCaptureRecordHeader(channel.record.data(), timestampUs, source, type,
+                               static_cast<std::uint32_t>(size));
+  std::copy(data, data + size, channel.record.begin() + kRawCaptureRecordHeaderBytes);
+  if (!channel.ring.push(channel.record.data(), channel.record.size())) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  m_captured.fetch_add(size, std::memory_order_relaxed);
+}
+
+void RawCapture::drain() {
+  if (!m_writer.isOpen()) {
+    return;
+  }
+  // Producers push whole records, so taking everything a ring holds never
+  // splits one and the two sources can share the file
+  for (Channel *source : {&m_serial, &m_ble}) {
+    const std::size_t popped = source->ring.pop(m_buffer.data(), m_buffer.size());
+    if (popped > 0 && !m_writer.write(m_buffer.data(), popped)) {
+      fail();
+      return;
+    }
+  }
+}
+
+void RawCapture::fail() {
+  m_capturing.store(false);
+  m_drainTimer->stop();
+  m_writer.close();
+  emit captureError("Cannot write to " + m_path + ", capture stopped");
+}
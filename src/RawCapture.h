@@ -0,0 +1,94 @@
+#ifndef RAWCAPTURE_H
+#define RAWCAPTURE_H
+
+#include "RawCaptureFormat.h"
+#include "SpscRing.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <vector>
+
+// Captures the raw bytes of the transports into a capture file (see
+// RawCaptureFormat.h). append() is called on the thread that read the bytes
+// and only copies one record into that source's lock-free ring; a dedicated
+// writer thread drains the rings every 100 ms and flushes them to the file.
+// If the disk cannot keep up a ring overflows and the record is counted as
+// dropped - acquisition is never blocked.
+class RawCapture : public QObject {
+  Q_OBJECT
+
+public:
+  explicit RawCapture(QObject *parent = nullptr);
+  ~RawCapture() override;
+
+  // Creates the file and records the sources already connected; false (and
+  // captureError()) if that fails
+  bool start(const QString &path);
+  // Writes the pending records and closes the file
+  void stop();
+  [[nodiscard]] bool isCapturing() const {
+    return m_capturing.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] const QString &path() const { return m_path; }
+
+  // Notes the protocol and device of a source that (re)connected, for
+  // replays to pick the right decoder. Call from the thread that appends
+  // the data of that source.
+  void setSource(CaptureSource source, const QString &protocol,
+                 const QString &device);
+
+  // Thread-safe and wait-free, for one producer per source at a time
+  void append(CaptureSource source, const char *data, std::size_t size,
+              quint64 timestampUs);
+
+  // Microseconds since the epoch, the time base of the capture records
+  static quint64 timestampUs();
+
+  [[nodiscard]] quint64 capturedBytes() const { return m_captured.load(); }
+  [[nodiscard]] quint64 droppedRecords() const { return m_dropped.load(); }
+
+signals:
+  // Emitted on the writer thread
+  void captureError(const QString &message);
+
+private:
+  struct Channel {
+    explicit Channel(std::size_t capacity) : ring(capacity) {}
+    SpscRing<unsigned char> ring;
+    // Producer side: header and payload are pushed as one batch
+    std::vector<unsigned char> record;
+    QString protocol;
+    QString device;
+  };
+
+  Channel &channel(CaptureSource source) {
+    return source == CaptureSource::Ble ? m_ble : m_serial;
+  }
+  void push(Channel &channel, CaptureSource source, CaptureRecordType type,
+            const char *data, std::size_t size, quint64 timestampUs);
+
+  // Writer thread only
+  void drain();
+  void fail();
+
+  Channel m_serial;
+  Channel m_ble;
+  QMutex m_sourceMutex;
+  QThread *m_thread;
+  QObject *m_writerContext;
+  QTimer *m_drainTimer;
+  QString m_path;
+
+  std::atomic<bool> m_capturing{false};
+  std::atomic<quint64> m_captured{0};
+  std::atomic<quint64> m_dropped{0};
+
+  // Writer thread state
+  RawCaptureWriter m_writer;
+  std::vector<unsigned char> m_buffer;
+};
+
+#endif // RAWCAPTURE_H
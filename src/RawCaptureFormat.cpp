@@ -0,0 +1,155 @@
+#include "RawCaptureFormat.h"
+
+#include <cstring>
+
+namespace {
+constexpr char kFileMagic[8] = {'U', 'P', 'W', 'R', 'C', 'A', 'P', '\0'};
+
+void putU16(unsigned char *p, std::uint16_t v) {
+  p[0] = static_cast<unsigned char>(v);
+  p[1] = static_cast<unsigned char>(v >> 8);
+}
+void putU32(unsigned char *p, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<unsigned char>(v >> (8 * i));
+  }
+}
+void putU64(unsigned char *p, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) {
+    p[i] = static_cast<unsigned char>(v >> (8 * i));
+  }
+}
+std::uint16_t getU16(const unsigned char *p) {
+  return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+std::uint32_t getU32(const unsigned char *p) {
+  std::uint32_t v = 0;
+  for (int i = 3; i >= 0; --i) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+std::uint64_t getU64(const unsigned char *p) {
+  std::uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+void setError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+}
+} // namespace
+
+void encodeRawCaptureRecordHeader(unsigned char *out, std::uint64_t timestampUs,
+                                  CaptureSource source, CaptureRecordType type,
+                                  std::uint32_t size) {
+  putU64(out, timestampUs);
+  out[8] = static_cast<unsigned char>(source);
+  out[9] = static_cast<unsigned char>(type);
+  putU16(out + 10, 0);
+  putU32(out + 12, size);
+}
+
+RawCaptureWriter::~RawCaptureWriter() { close(); }
+
+bool RawCaptureWriter::open(const std::string &path, std::string *error) {
+  close();
+  m_file = std::fopen(path.c_str(), "wb");
+  if (!m_file) {
+    setError(error, "Cannot create " + path);
+    return false;
+  }
+  m_offset = 0;
+
+  unsigned char header[kRawCaptureFileHeaderBytes] = {};
+  std::memcpy(header, kFileMagic, sizeof(kFileMagic));
+  putU16(header + 8, kRawCaptureVersion);
+  if (!write(header, sizeof(header))) {
+    setError(error, "Cannot write to " + path);
+    std::fclose(m_file);
+    m_file = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool RawCaptureWriter::write(const unsigned char *records, std::size_t size) {
+  if (std::fwrite(records, 1, size, m_file) != size || std::fflush(m_file) != 0) {
+    return false;
+  }
+  m_offset += size;
+  return true;
+}
+
+bool RawCaptureWriter::close() {
+  if (!m_file) {
+    return true;
+  }
+  const bool ok = std::fclose(m_file) == 0;
+  m_file = nullptr;
+  return ok;
+}
+
+bool RawCaptureReader::isCapture(const std::string &path) {
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  char magic[sizeof(kFileMagic)];
+  const bool matches = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                       std::memcmp(magic, kFileMagic, sizeof(magic)) == 0;
+  std::fclose(file);
+  return matches;
+}
+
+void RawCaptureReader::close() {
+  m_map.close();
+  m_offset = 0;
+  m_truncated = false;
+}
+
+bool RawCaptureReader::open(const std::string &path, std::string *error) {
+  close();
+  if (!m_map.open(path)) {
+    setError(error, "Cannot open " + path);
+    return false;
+  }
+  const unsigned char *header = m_map.data();
+  if (m_map.size() < kRawCaptureFileHeaderBytes ||
+      std::memcmp(header, kFileMagic, sizeof(kFileMagic)) != 0) {
+    setError(error, path + " is not a raw capture");
+    close();
+    return false;
+  }
+  if (getU16(header + 8) > kRawCaptureVersion) {
+    setError(error, path + " was written by a newer version");
+    close();
+    return false;
+  }
+  rewind();
+  return true;
+}
+
+bool RawCaptureReader::next(RawCaptureRecord &record) {
+  const std::uint64_t available = m_map.size() - m_offset;
+  if (!m_map.isOpen() || available == 0) {
+    return false;
+  }
+  const unsigned char *p = m_map.data() + m_offset;
+  if (available < kRawCaptureRecordHeaderBytes ||
+      available - kRawCaptureRecordHeaderBytes < getU32(p + 12)) {
+    m_truncated = true;
+    return false;
+  }
+  record.timestampUs = getU64(p);
+  record.source = static_cast<CaptureSource>(p[8]);
+  record.type = static_cast<CaptureRecordType>(p[9]);
+  record.size = getU32(p + 12);
+  record.data = p + kRawCaptureRecordHeaderBytes;
+  m_offset += kRawCaptureRecordHeaderBytes + record.size;
+  return true;
+}
@@ -0,0 +1,103 @@
+#ifndef RAWCAPTUREFORMAT_H
+#define RAWCAPTUREFORMAT_H
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Raw capture file (*.upc): the bytes exactly as a transport delivered them,
+// for reproducing protocol and parser problems offline.
+//
+//   file header | record | record | ...
+//
+// The file header is the magic "UPWRCAP\0", a u16 version and six reserved
+// bytes. Every record is a 16-byte header - u64 arrival time in
+// microseconds since the epoch, u8 source, u8 type, u16 reserved, u32
+// payload length - followed by the payload. Records are only ever
+// appended, so after a crash everything up to the last complete record is
+// still readable.
+//
+// All integers are little-endian.
+
+constexpr std::uint16_t kRawCaptureVersion = 1;
+constexpr std::size_t kRawCaptureFileHeaderBytes = 16;
+constexpr std::size_t kRawCaptureRecordHeaderBytes = 16;
+
+enum class CaptureSource : std::uint8_t {
+  Serial = 1,
+  Ble = 2,
+};
+
+enum class CaptureRecordType : std::uint8_t {
+  // One QSerialPort read or one BLE notification
+  Data = 1,
+  // The source connected; payload "<protocol>\t<device>", e.g.
+  // "PLD28\t/dev/ttyACM0" or "BLE\tUSB Power OSD"
+  Connected = 2,
+};
+
+struct RawCaptureRecord {
+  std::uint64_t timestampUs = 0;
+  CaptureSource source = CaptureSource::Serial;
+  CaptureRecordType type = CaptureRecordType::Data;
+  const unsigned char *data = nullptr;
+  std::uint32_t size = 0;
+};
+
+void encodeRawCaptureRecordHeader(unsigned char *out, std::uint64_t timestampUs,
+                                  CaptureSource source, CaptureRecordType type,
+                                  std::uint32_t size);
+
+// Appends encoded records to a new capture file. Not thread-safe; the
+// RawCapture calls it from its writer thread only.
+class RawCaptureWriter {
+public:
+  RawCaptureWriter() = default;
+  ~RawCaptureWriter();
+  RawCaptureWriter(const RawCaptureWriter &) = delete;
+  RawCaptureWriter &operator=(const RawCaptureWriter &) = delete;
+
+  bool open(const std::string &path, std::string *error = nullptr);
+  // Whole records (header and payload), flushed to the OS
+  bool write(const unsigned char *records, std::size_t size);
+  bool close();
+
+  [[nodiscard]] bool isOpen() const { return m_file != nullptr; }
+  [[nodiscard]] std::uint64_t bytesWritten() const { return m_offset; }
+
+private:
+  std::FILE *m_file = nullptr;
+  std::uint64_t m_offset = 0;
+};
+
+// Walks the records of a capture file, memory-mapped
+class RawCaptureReader {
+public:
+  RawCaptureReader() = default;
+  RawCaptureReader(const RawCaptureReader &) = delete;
+  RawCaptureReader &operator=(const RawCaptureReader &) = delete;
+
+  // Cheap check of the file magic, to tell captures from recordings
+  static bool isCapture(const std::string &path);
+
+  bool open(const std::string &path, std::string *error = nullptr);
+  void close();
+
+  // The next record; false at the end of the file. record.data points into
+  // the mapping and stays valid until close().
+  bool next(RawCaptureRecord &record);
+  void rewind() { m_offset = kRawCaptureFileHeaderBytes; }
+  // True once next() stopped at an incomplete record, e.g. after a crash
+  [[nodiscard]] bool truncated() const { return m_truncated; }
+  [[nodiscard]] std::uint64_t fileSize() const { return m_map.size(); }
+
+private:
+  MappedFile m_map;
+  std::uint64_t m_offset = 0;
+  bool m_truncated = false;
+};
+
+#endif // RAWCAPTUREFORMAT_H
@@ -0,0 +1,254 @@
+#include "ReadoutLabel.h"
+
+#include <QEvent>
+#include <QFontMetrics>
+#include <QHash>
+#include <QPaintEvent>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+constexpr std::uint64_t kPow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+constexpr int kMaxDecimals = 6;
+// Larger readings are clamped; no meter gets anywhere near this
+constexpr double kMaxMagnitude = 1e9;
+
+class TextBuilder {
+public:
+  TextBuilder(char *buffer, std::size_t capacity)
+      : m_buffer(buffer), m_capacity(capacity) {}
+
+  void append(char c) {
+    if (m_length < m_capacity) {
+      m_buffer[m_length++] = c;
+    }
+  }
+
+  void append(const char *text) {
+    for (; text != nullptr && *text != '\0'; ++text) {
+      append(*text);
+    }
+  }
+
+  // Locale independent fixed-point formatting, same output as
+  // QString::arg(value, 0, 'f', decimals)
+  void appendFixed(double value, int decimals) {
+    if (!std::isfinite(value)) {
+      append("---");
+      return;
+    }
+    decimals = std::clamp(decimals, 0, kMaxDecimals);
+    const bool negative = value < 0.0;
+    const double magnitude = std::min(std::fabs(value), kMaxMagnitude);
+    const auto scaled = static_cast<std::uint64_t>(
+        std::llround(magnitude * static_cast<double>(kPow10[decimals])));
+    std::uint64_t integral = scaled / kPow10[decimals];
+    std::uint64_t fraction = scaled % kPow10[decimals];
+
+    if (negative && scaled != 0) {
+      append('-');
+    }
+    char digits[20];
+    int count = 0;
+    do {
+      digits[count++] = static_cast<char>('0' + integral % 10);
+      integral /= 10;
+    } while (integral != 0);
+    while (count > 0) {
+      append(digits[--count]);
+    }
+    if (decimals > 0) {
+      append('.');
+      for (int i = decimals - 1; i >= 0; --i) {
+        append(static_cast<char>('0' + fraction / kPow10[i]));
+        fraction %= kPow10[i];
+      }
+    }
+  }
+
+private:
+  char *m_buffer;
+  std::size_t m_capacity;
+  std::size_t m_length = 0;
+};
+} // namespace
+
+ReadoutLabel::ReadoutLabel(QWidget *parent)
+    : QWidget(parent), m_glyphs(glyphsFor(font())) {}
+
+std::shared_ptr<const ReadoutLabel::Glyphs>
+ReadoutLabel::glyphsFor(const QFont &font) {
+  static QHash<QString, std::weak_ptr<const Glyphs>> cache;
+  const QString key = font.key();
+  if (auto cached = cache.value(key).lock()) {
+    return cached;
+  }
+
+  auto glyphs = std::make_shared<Glyphs>();
+  const QFontMetrics metrics(font);
+  glyphs->height = metrics.height();
+  for (std::size_t c = ' '; c < kGlyphCount - 1; ++c) {
+    const QString text(QChar(static_cast<char16_t>(c)));
+    QStaticText &glyph = glyphs->text[c];
+    glyph.setTextFormat(Qt::PlainText);
+    glyph.setPerformanceHint(QStaticText::AggressiveCaching);
+    glyph.setText(text);
+    glyph.prepare(QTransform(), font);
+    glyphs->advance[c] = metrics.horizontalAdvance(text);
+  }
+  // Tabular digits: all digits get the widest digit's cell so the layout
+  // stays put while a reading changes
+  int digitAdvance = 0;
+  for (char c = '0'; c <= '9'; ++c) {
+    digitAdvance = std::max(digitAdvance, glyphs->advance[c]);
+  }
+  for (char c = '0'; c <= '9'; ++c) {
+    glyphs->inset[c] = (digitAdvance - glyphs->advance[c]) / 2;
+    glyphs->advance[c] = digitAdvance;
+  }
+
+  cache.insert(key, glyphs);
+  return glyphs;
+}
+
+void ReadoutLabel::setAlignment(Qt::Alignment alignment) {
+  if (alignment != m_alignment) {
+    m_alignment = alignment;
+    update();
+  }
+}
+
+void ReadoutLabel::setColor(const QColor &color) {
+  if (color != m_color) {
+    m_color = color;
+    update();
+  }
+}
+
+void ReadoutLabel::setValue(double value, int decimals, const char *unit) {
+  Text text{};
+  TextBuilder builder(text.data(), kMaxChars);
+  builder.appendFixed(value, decimals);
+  builder.append(unit);
+  setText(text.data());
+}
+
+void ReadoutLabel::setRange(double min, double max, int decimals,
+                            const char *unit) {
+  Text text{};
+  TextBuilder builder(text.data(), kMaxChars);
+  builder.appendFixed(min, decimals);
+  builder.append('-');
+  builder.appendFixed(max, decimals);
+  builder.append(unit);
+  setText(text.data());
+}
+
+void ReadoutLabel::setNoData() { setText("---"); }
+
+void ReadoutLabel::setText(const char *text) {
+  Text next{};
+  std::size_t length = 0;
+  for (; text[length] != '\0' && length < kMaxChars; ++length) {
+    const auto c = static_cast<unsigned char>(text[length]);
+    next[length] = (c >= ' ' && c < kGlyphCount - 1) ? static_cast<char>(c)
+                                                     : '?';
+  }
+  if (length == m_length &&
+      std::memcmp(next.data(), m_text.data(), length) == 0) {
+    return;
+  }
+
+  Offsets offsets{};
+  layout(next, length, offsets);
+  const bool sameLayout = length == m_length && offsets == m_offsets;
+
+  QRect dirty;
+  if (sameLayout) {
+    for (std::size_t i = 0; i < length; ++i) {
+      if (next[i] != m_text[i]) {
+        dirty |= cellRect(i);
+      }
+    }
+  }
+  m_text = next;
+  m_length = length;
+  m_offsets = offsets;
+
+  if (sameLayout) {
+    update(dirty);
+  } else {
+    updateGeometry();
+    update();
+  }
+}
+
+QSize ReadoutLabel::sizeHint() const {
+  return {m_offsets[m_length], m_glyphs->height};
+}
+
+void ReadoutLabel::layout(const Text &text, std::size_t length,
+                          Offsets &offsets) const {
+  int x = 0;
+  for (std::size_t i = 0; i < length; ++i) {
+    offsets[i] = x;
+    x += m_glyphs->advance[static_cast<unsigned char>(text[i])];
+  }
+  offsets[length] = x;
+}
+
+int ReadoutLabel::originX() const {
+  const int textWidth = m_offsets[m_length];
+  if (m_alignment & Qt::AlignRight) {
+    return width() - textWidth;
+  }
+  if (m_alignment & Qt::AlignHCenter) {
+    return (width() - textWidth) / 2;
+  }
+  return 0;
+}
+
+QRect ReadoutLabel::cellRect(std::size_t index) const {
+  return {originX() + m_offsets[index], 0,
+          m_offsets[index + 1] - m_offsets[index], height()};
+}
+
+void ReadoutLabel::paintEvent(QPaintEvent *event) {
+  if (m_length == 0) {
+    return;
+  }
+  QPainter painter(this);
+  painter.setFont(font());
+  painter.setPen(m_color);
+
+  int top = 0;
+  if (m_alignment & Qt::AlignVCenter) {
+    top = (height() - m_glyphs->height) / 2;
+  } else if (m_alignment & Qt::AlignBottom) {
+    top = height() - m_glyphs->height;
+  }
+
+  const QRect &dirty = event->rect();
+  for (std::size_t i = 0; i < m_length; ++i) {
+    const QRect cell = cellRect(i);
+    if (!cell.intersects(dirty)) {
+      continue;
+    }
+    const auto c = static_cast<unsigned char>(m_text[i]);
+    painter.drawStaticText(QPointF(cell.left() + m_glyphs->inset[c], top),
+                           m_glyphs->text[c]);
+  }
+}
+
+void ReadoutLabel::changeEvent(QEvent *event) {
+  if (event->type() == QEvent::FontChange) {
+    m_glyphs = glyphsFor(font());
+    layout(m_text, m_length, m_offsets);
+    updateGeometry();
+    update();
+  }
+  QWidget::changeEvent(event);
+}
@@ -0,0 +1,72 @@
+#ifndef READOUTLABEL_H
+#define READOUTLABEL_H
+
+#include <QColor>
+#include <QStaticText>
+#include <QWidget>
+#include <array>
+#include <cstddef>
+#include <memory>
+
+// Custom-painted replacement for the QLabels showing the live readings.
+// Values are formatted into a fixed char buffer without allocating, every
+// glyph is a QStaticText laid out once per font, and digits share one cell
+// width so a changed reading only repaints the digits that actually changed.
+class ReadoutLabel : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit ReadoutLabel(QWidget *parent = nullptr);
+
+  void setAlignment(Qt::Alignment alignment);
+  void setColor(const QColor &color);
+
+  // e.g. setValue(5.1234, 2, "V") shows "5.12V"
+  void setValue(double value, int decimals, const char *unit);
+  // e.g. setRange(0.01, 1.5, 3, "A") shows "0.010-1.500A"
+  void setRange(double min, double max, int decimals, const char *unit);
+  // Shows "---"
+  void setNoData();
+
+  // Printable ASCII only; anything else is shown as '?'
+  void setText(const char *text);
+
+  [[nodiscard]] QSize sizeHint() const override;
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void changeEvent(QEvent *event) override;
+
+private:
+  static constexpr std::size_t kMaxChars = 48;
+  static constexpr std::size_t kGlyphCount = 128;
+
+  // Glyphs and advances of one font, shared by all readouts using that font
+  struct Glyphs {
+    std::array<QStaticText, kGlyphCount> text;
+    std::array<int, kGlyphCount> advance{};
+    // Offset that centers a narrow digit in the shared digit cell
+    std::array<int, kGlyphCount> inset{};
+    int height = 0;
+  };
+  static std::shared_ptr<const Glyphs> glyphsFor(const QFont &font);
+
+  using Text = std::array<char, kMaxChars + 1>;
+  using Offsets = std::array<int, kMaxChars + 1>;
+
+  void layout(const Text &text, std::size_t length, Offsets &offsets) const;
+  [[nodiscard]] int originX() const;
+  [[nodiscard]] QRect cellRect(std::size_t index) const;
+
+  std::shared_ptr<const Glyphs> m_glyphs;
+  Qt::Alignment m_alignment = Qt::AlignLeft | Qt::AlignVCenter;
+  QColor m_color = Qt::white;
+
+  Text m_text{};
+  std::size_t m_length = 0;
+  // Left edge of every character cell relative to the start of the text;
+  // m_offsets[m_length] is the total width
+  Offsets m_offsets{};
+};
+
+#endif // READOUTLABEL_H
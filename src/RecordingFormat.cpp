@@ -0,0 +1,450 @@
+#include "RecordingFormat.h"
+#include "SampleCodec.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+
+namespace {
+constexpr char kFileMagic[8] = {'U', 'P', 'W', 'R', 'R', 'E', 'C', '\0'};
+constexpr char kFooterMagic[8] = {'U', 'P', 'W', 'R', 'I', 'D', 'X', '\0'};
+constexpr std::uint32_t kChunkMagic = 0x4B4E4843; // "CHNK"
+constexpr std::uint32_t kIndexMagic = 0x58444E49; // "INDX"
+
+constexpr std::size_t kFileHeaderBytes = 24;
+constexpr std::size_t kChunkFixedBytes = 52;
+constexpr std::size_t kIndexHeaderBytes = 12;
+constexpr std::size_t kIndexEntryBytes = 48;
+constexpr std::size_t kFooterBytes = 16;
+constexpr std::size_t kRawSampleBytes = 40;
+constexpr std::size_t kMaxStringBytes = 1024;
+
+void putU16(unsigned char *p, std::uint16_t v) {
+  p[0] = static_cast<unsigned char>(v);
+  p[1] = static_cast<unsigned char>(v >> 8);
+}
+void putU32(unsigned char *p, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<unsigned char>(v >> (8 * i));
+  }
+}
+void putU64(unsigned char *p, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) {
+    p[i] = static_cast<unsigned char>(v >> (8 * i));
+  }
+}
+void putF64(unsigned char *p, double v) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  putU64(p, bits);
+}
+std::uint16_t getU16(const unsigned char *p) {
+  return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+std::uint32_t getU32(const unsigned char *p) {
+  std::uint32_t v = 0;
+  for (int i = 3; i >= 0; --i) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+std::uint64_t getU64(const unsigned char *p) {
+  std::uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+double getF64(const unsigned char *p) {
+  const std::uint64_t bits = getU64(p);
+  double v;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+void setError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+}
+
+// Serializes the header (payload fields already set) into out
+void encodeChunkHeader(const RecordingChunkHeader &header,
+                       std::vector<unsigned char> &out) {
+  const auto deviceLen = static_cast<std::uint16_t>(
+      std::min(header.device.size(), kMaxStringBytes));
+  const auto protocolLen = static_cast<std::uint16_t>(
+      std::min(header.protocol.size(), kMaxStringBytes));
+  out.assign(kChunkFixedBytes + deviceLen + protocolLen, 0);
+  unsigned char *p = out.data();
+  putU32(p + 0, kChunkMagic);
+  putU32(p + 4, static_cast<std::uint32_t>(out.size()));
+  putU32(p + 8, header.payloadBytes);
+  putU32(p + 12, header.sampleCount);
+  putU64(p + 16, header.firstTimestamp);
+  putU64(p + 24, header.lastTimestamp);
+  putU32(p + 32, static_cast<std::uint32_t>(header.currentDiffMa));
+  putU16(p + 36, static_cast<std::uint16_t>(header.encoding));
+  putU16(p + 38, deviceLen);
+  putU16(p + 40, protocolLen);
+  putU32(p + 44, header.payloadCrc);
+  std::memcpy(p + kChunkFixedBytes, header.device.data(), deviceLen);
+  std::memcpy(p + kChunkFixedBytes + deviceLen, header.protocol.data(),
+              protocolLen);
+  std::uint32_t crc = recordingCrc32(p, 48);
+  crc = recordingCrc32(p + kChunkFixedBytes, deviceLen + protocolLen, crc);
+  putU32(p + 48, crc);
+}
+
+// Validates the chunk header at p, with `available` bytes up to the end of
+// the file
+bool decodeChunkHeader(const unsigned char *p, std::uint64_t available,
+                       RecordingChunkHeader &header, std::uint32_t &headerBytes) {
+  if (available < kChunkFixedBytes || getU32(p) != kChunkMagic) {
+    return false;
+  }
+  headerBytes = getU32(p + 4);
+  const std::uint16_t deviceLen = getU16(p + 38);
+  const std::uint16_t protocolLen = getU16(p + 40);
+  if (deviceLen > kMaxStringBytes || protocolLen > kMaxStringBytes ||
+      headerBytes != kChunkFixedBytes + deviceLen + protocolLen ||
+      headerBytes > available) {
+    return false;
+  }
+  const unsigned char *strings = p + kChunkFixedBytes;
+  std::uint32_t crc = recordingCrc32(p, 48);
+  crc = recordingCrc32(strings, deviceLen + protocolLen, crc);
+  if (crc != getU32(p + 48)) {
+    return false;
+  }
+  header.payloadBytes = getU32(p + 8);
+  header.sampleCount = getU32(p + 12);
+  header.firstTimestamp = getU64(p + 16);
+  header.lastTimestamp = getU64(p + 24);
+  header.currentDiffMa = static_cast<std::int32_t>(getU32(p + 32));
+  header.encoding = static_cast<RecordingEncoding>(getU16(p + 36));
+  header.payloadCrc = getU32(p + 44);
+  header.device.assign(reinterpret_cast<const char *>(strings), deviceLen);
+  header.protocol.assign(reinterpret_cast<const char *>(strings) + deviceLen,
+                         protocolLen);
+  return true;
+}
+
+void encodeRaw(const PowerData *samples, std::size_t count,
+               std::vector<unsigned char> &out) {
+  out.resize(count * kRawSampleBytes);
+  unsigned char *p = out.data();
+  for (std::size_t i = 0; i < count; ++i, p += kRawSampleBytes) {
+    putU64(p, samples[i].timestamp);
+    putF64(p + 8, samples[i].voltage);
+    putF64(p + 16, samples[i].current);
+    putF64(p + 24, samples[i].power);
+    putF64(p + 32, samples[i].energy);
+  }
+}
+
+bool decodeRaw(const unsigned char *p, std::size_t bytes, std::uint32_t count,
+               std::vector<PowerData> &out) {
+  if (bytes != count * kRawSampleBytes) {
+    return false;
+  }
+  out.resize(count);
+  for (std::uint32_t i = 0; i < count; ++i, p += kRawSampleBytes) {
+    out[i].timestamp = getU64(p);
+    out[i].voltage = getF64(p + 8);
+    out[i].current = getF64(p + 16);
+    out[i].power = getF64(p + 24);
+    out[i].energy = getF64(p + 32);
+  }
+  return true;
+}
+} // namespace
+
+std::uint32_t recordingCrc32(const void *data, std::size_t size, std::uint32_t crc) {
+  static const auto table = [] {
+    std::array<std::uint32_t, 256> values{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      values[i] = c;
+    }
+    return values;
+  }();
+  const auto *p = static_cast<const unsigned char *>(data);
+  crc = ~crc;
+  for (std::size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+RecordingWriter::~RecordingWriter() { close(); }
+
+bool RecordingWriter::open(const std::string &path, std::string *error) {
+  close();
+  m_file = std::fopen(path.c_str(), "wb");
+  if (!m_file) {
+    setError(error, "Cannot create " + path);
+    return false;
+  }
+  m_offset = 0;
+  m_sampleCount = 0;
+  m_chunks.clear();
+
+  unsigned char header[kFileHeaderBytes] = {};
+  std::memcpy(header, kFileMagic, sizeof(kFileMagic));
+  putU16(header + 8, kRecordingVersion);
+  const auto createdMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+  putU64(header + 16, static_cast<std::uint64_t>(createdMs));
+  if (!write(header, sizeof(header)) || std::fflush(m_file) != 0) {
+    setError(error, "Cannot write to " + path);
+    std::fclose(m_file);
+    m_file = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool RecordingWriter::appendChunk(RecordingChunkHeader header, const PowerData *samples,
+                                  std::size_t count) {
+  if (!m_file || count == 0) {
+    return m_file != nullptr;
+  }
+  std::vector<unsigned char> payload;
+  if (m_encoding == RecordingEncoding::Gorilla) {
+    SampleCodec::encode(samples, count, payload);
+  } else {
+    encodeRaw(samples, count, payload);
+  }
+  header.encoding = m_encoding;
+  header.payloadBytes = static_cast<std::uint32_t>(payload.size());
+  header.sampleCount = static_cast<std::uint32_t>(count);
+  header.firstTimestamp = samples[0].timestamp;
+  header.lastTimestamp = samples[count - 1].timestamp;
+  header.payloadCrc = recordingCrc32(payload.data(), payload.size());
+  encodeChunkHeader(header, m_buffer);
+
+  RecordingChunkInfo info;
+  info.offset = m_offset;
+  info.firstSample = m_sampleCount;
+  info.header = header;
+  if (!write(m_buffer.data(), m_buffer.size()) ||
+      !write(payload.data(), payload.size()) || std::fflush(m_file) != 0) {
+    return false;
+  }
+  m_chunks.push_back(std::move(info));
+  m_sampleCount += count;
+  return true;
+}
+
+bool RecordingWriter::close() {
+  if (!m_file) {
+    return true;
+  }
+  const std::uint64_t indexOffset = m_offset;
+  std::vector<unsigned char> index(kIndexHeaderBytes +
+                                   m_chunks.size() * kIndexEntryBytes);
+  unsigned char *p = index.data() + kIndexHeaderBytes;
+  for (const auto &chunk : m_chunks) {
+    putU64(p + 0, chunk.offset);
+    putU64(p + 8, chunk.firstSample);
+    putU64(p + 16, chunk.header.firstTimestamp);
+    putU64(p + 24, chunk.header.lastTimestamp);
+    putU32(p + 32, chunk.header.payloadBytes);
+    putU32(p + 36, chunk.header.sampleCount);
+    putU32(p + 40, static_cast<std::uint32_t>(chunk.header.currentDiffMa));
+    putU16(p + 44, static_cast<std::uint16_t>(chunk.header.encoding));
+    putU16(p + 46, 0);
+    p += kIndexEntryBytes;
+  }
+  putU32(index.data(), kIndexMagic);
+  putU32(index.data() + 4, static_cast<std::uint32_t>(m_chunks.size()));
+  putU32(index.data() + 8, recordingCrc32(index.data() + kIndexHeaderBytes,
+                                 index.size() - kIndexHeaderBytes));
+
+  unsigned char footer[kFooterBytes];
+  putU64(footer, indexOffset);
+  std::memcpy(footer + 8, kFooterMagic, sizeof(kFooterMagic));
+
+  const bool ok = write(index.data(), index.size()) &&
+                  write(footer, sizeof(footer)) && std::fflush(m_file) == 0;
+  std::fclose(m_file);
+  m_file = nullptr;
+  return ok;
+}
+
+bool RecordingWriter::write(const void *data, std::size_t size) {
+  if (std::fwrite(data, 1, size, m_file) != size) {
+    return false;
+  }
+  m_offset += size;
+  return true;
+}
+
+void RecordingReader::close() {
+  m_map.close();
+  m_chunks.clear();
+  m_sampleCount = 0;
+  m_closedCleanly = false;
+}
+
+bool RecordingReader::open(const std::string &path, std::string *error) {
+  close();
+  if (!m_map.open(path)) {
+    setError(error, "Cannot open " + path);
+    return false;
+  }
+  const unsigned char *header = m_map.data();
+  if (m_map.size() < kFileHeaderBytes ||
+      std::memcmp(header, kFileMagic, sizeof(kFileMagic)) != 0) {
+    setError(error, path + " is not a recording");
+    close();
+    return false;
+  }
+  if (getU16(header + 8) > kRecordingVersion) {
+    setError(error, path + " was written by a newer version");
+    close();
+    return false;
+  }
+
+  m_closedCleanly = loadIndex();
+  if (!m_closedCleanly) {
+    rebuildIndex();
+  }
+  return true;
+}
+
+bool RecordingReader::loadIndex() {
+  const std::uint64_t fileSize = m_map.size();
+  if (fileSize < kFileHeaderBytes + kIndexHeaderBytes + kFooterBytes) {
+    return false;
+  }
+  const unsigned char *footer = m_map.data() + fileSize - kFooterBytes;
+  if (std::memcmp(footer + 8, kFooterMagic, sizeof(kFooterMagic)) != 0) {
+    return false;
+  }
+  const std::uint64_t indexOffset = getU64(footer);
+  if (indexOffset < kFileHeaderBytes ||
+      indexOffset > fileSize - kFooterBytes - kIndexHeaderBytes) {
+    return false;
+  }
+  const unsigned char *indexHeader = m_map.data() + indexOffset;
+  if (getU32(indexHeader) != kIndexMagic) {
+    return false;
+  }
+  const std::uint32_t count = getU32(indexHeader + 4);
+  if (indexOffset + kIndexHeaderBytes + std::uint64_t(count) * kIndexEntryBytes +
+          kFooterBytes != fileSize) {
+    return false;
+  }
+  const unsigned char *entries = indexHeader + kIndexHeaderBytes;
+  if (recordingCrc32(entries, std::size_t(count) * kIndexEntryBytes) !=
+      getU32(indexHeader + 8)) {
+    return false;
+  }
+
+  m_chunks.resize(count);
+  m_sampleCount = 0;
+  const unsigned char *p = entries;
+  for (auto &chunk : m_chunks) {
+    chunk.offset = getU64(p + 0);
+    chunk.firstSample = getU64(p + 8);
+    chunk.header.firstTimestamp = getU64(p + 16);
+    chunk.header.lastTimestamp = getU64(p + 24);
+    chunk.header.payloadBytes = getU32(p + 32);
+    chunk.header.sampleCount = getU32(p + 36);
+    chunk.header.currentDiffMa = static_cast<std::int32_t>(getU32(p + 40));
+    chunk.header.encoding = static_cast<RecordingEncoding>(getU16(p + 44));
+    m_sampleCount += chunk.header.sampleCount;
+    p += kIndexEntryBytes;
+  }
+  return true;
+}
+
+void RecordingReader::rebuildIndex() {
+  m_chunks.clear();
+  m_sampleCount = 0;
+  const std::uint64_t fileSize = m_map.size();
+  std::uint64_t offset = kFileHeaderBytes;
+  while (offset < fileSize) {
+    const unsigned char *p = m_map.data() + offset;
+    RecordingChunkInfo chunk;
+    std::uint32_t headerBytes = 0;
+    if (!decodeChunkHeader(p, fileSize - offset, chunk.header, headerBytes)) {
+      break;
+    }
+    const std::uint64_t end =
+        offset + headerBytes + std::uint64_t(chunk.header.payloadBytes);
+    if (end > fileSize) {
+      break; // cut short by a crash
+    }
+    if (recordingCrc32(p + headerBytes, chunk.header.payloadBytes) !=
+        chunk.header.payloadCrc) {
+      break;
+    }
+    chunk.offset = offset;
+    chunk.firstSample = m_sampleCount;
+    m_sampleCount += chunk.header.sampleCount;
+    m_chunks.push_back(std::move(chunk));
+    offset = end;
+  }
+}
+
+std::size_t RecordingReader::chunkForSample(std::uint64_t sample) const {
+  auto it = std::upper_bound(
+      m_chunks.begin(), m_chunks.end(), sample,
+      [](std::uint64_t s, const RecordingChunkInfo &c) { return s < c.firstSample; });
+  if (it == m_chunks.begin() || sample >= m_sampleCount) {
+    return m_chunks.size();
+  }
+  return static_cast<std::size_t>(it - m_chunks.begin()) - 1;
+}
+
+std::size_t RecordingReader::chunkForTimestamp(std::uint64_t timestamp) const {
+  auto it = std::lower_bound(m_chunks.begin(), m_chunks.end(), timestamp,
+                             [](const RecordingChunkInfo &c, std::uint64_t t) {
+                               return c.header.lastTimestamp < t;
+                             });
+  return static_cast<std::size_t>(it - m_chunks.begin());
+}
+
+bool RecordingReader::readChunk(std::size_t chunk, std::vector<PowerData> &out) {
+  if (!m_map.isOpen() || chunk >= m_chunks.size()) {
+    return false;
+  }
+  RecordingChunkInfo &info = m_chunks[chunk];
+  if (info.offset >= m_map.size()) {
+    return false;
+  }
+  const unsigned char *p = m_map.data() + info.offset;
+  const std::uint64_t available = m_map.size() - info.offset;
+  RecordingChunkHeader header;
+  std::uint32_t headerBytes = 0;
+  if (!decodeChunkHeader(p, available, header, headerBytes) ||
+      header.sampleCount != info.header.sampleCount ||
+      headerBytes + std::uint64_t(header.payloadBytes) > available) {
+    return false;
+  }
+  // Index entries do not carry the strings; keep them once seen
+  info.header.device = header.device;
+  info.header.protocol = header.protocol;
+  info.header.payloadCrc = header.payloadCrc;
+
+  const unsigned char *payload = p + headerBytes;
+  if (recordingCrc32(payload, header.payloadBytes) != header.payloadCrc) {
+    return false;
+  }
+  switch (header.encoding) {
+  case RecordingEncoding::Raw:
+    return decodeRaw(payload, header.payloadBytes, header.sampleCount, out);
+  case RecordingEncoding::Gorilla:
+    return SampleCodec::decode(payload, header.payloadBytes, out) &&
+           out.size() == header.sampleCount;
+  }
+  return false;
+}
@@ -0,0 +1,132 @@
+#ifndef RECORDINGFORMAT_H
+#define RECORDINGFORMAT_H
+
+#include "MappedFile.h"
+#include "PowerData.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Session recording file (*.upr), append-only and chunked:
+//
+//   file header | chunk | chunk | ... | [index | footer]
+//
+// Every chunk is self-describing: a header with the source device,
+// protocol and calibration offset, the sample count and time range, and
+// CRCs over header and payload, followed by the encoded samples. The index
+// (offset, first sample number and time range of every chunk) and a
+// fixed-size footer pointing at it are written when the recording is
+// closed. A file without a valid footer, e.g. after a crash, is indexed by
+// walking the chunk headers up to the first incomplete or corrupt chunk,
+// so at most the chunk being written is lost.
+//
+// All integers are little-endian.
+
+constexpr std::uint16_t kRecordingVersion = 2;
+
+enum class RecordingEncoding : std::uint16_t {
+  // 40 bytes per sample: timestamp, voltage, current, power, energy
+  Raw = 0,
+  // SampleCodec block, typically 2-4 bytes per sample (since version 2)
+  Gorilla = 1,
+};
+
+struct RecordingChunkHeader {
+  std::uint32_t payloadBytes = 0;
+  std::uint32_t sampleCount = 0;
+  std::uint64_t firstTimestamp = 0;
+  std::uint64_t lastTimestamp = 0;
+  // MainWindow's base current offset at recording time; samples are stored
+  // as acquired, i.e. without it applied
+  std::int32_t currentDiffMa = 0;
+  RecordingEncoding encoding = RecordingEncoding::Raw;
+  std::uint32_t payloadCrc = 0;
+  std::string device;
+  std::string protocol;
+};
+
+struct RecordingChunkInfo {
+  std::uint64_t offset = 0;      // of the chunk header in the file
+  std::uint64_t firstSample = 0; // number of samples in all earlier chunks
+  // When loaded from the index, device and protocol are only filled in once
+  // the chunk was read
+  RecordingChunkHeader header;
+};
+
+std::uint32_t recordingCrc32(const void *data, std::size_t size, std::uint32_t crc = 0);
+
+// Appends chunks to a new recording file. Not thread-safe; the
+// SessionRecorder calls it from its writer thread only.
+class RecordingWriter {
+public:
+  RecordingWriter() = default;
+  ~RecordingWriter();
+  RecordingWriter(const RecordingWriter &) = delete;
+  RecordingWriter &operator=(const RecordingWriter &) = delete;
+
+  bool open(const std::string &path, std::string *error = nullptr);
+  // For the following chunks; Gorilla unless changed
+  void setEncoding(RecordingEncoding encoding) { m_encoding = encoding; }
+  // Writes one chunk and flushes it to the OS, so it survives a crash of
+  // this process. header.payloadBytes/sampleCount/timestamps/payloadCrc are
+  // filled in from the samples.
+  bool appendChunk(RecordingChunkHeader header, const PowerData *samples,
+                   std::size_t count);
+  // Writes the index and footer
+  bool close();
+
+  [[nodiscard]] bool isOpen() const { return m_file != nullptr; }
+  [[nodiscard]] std::uint64_t sampleCount() const { return m_sampleCount; }
+  [[nodiscard]] std::uint64_t bytesWritten() const { return m_offset; }
+
+private:
+  bool write(const void *data, std::size_t size);
+
+  std::FILE *m_file = nullptr;
+  RecordingEncoding m_encoding = RecordingEncoding::Gorilla;
+  std::uint64_t m_offset = 0;
+  std::uint64_t m_sampleCount = 0;
+  std::vector<RecordingChunkInfo> m_chunks;
+  std::vector<unsigned char> m_buffer;
+};
+
+// Reads a recording written by RecordingWriter, complete or not. The file
+// is memory-mapped, so opening a recording only touches its index and
+// reading a chunk only the pages of that chunk. A recording that is still
+// being written is seen as it was when it was opened.
+class RecordingReader {
+public:
+  RecordingReader() = default;
+  RecordingReader(const RecordingReader &) = delete;
+  RecordingReader &operator=(const RecordingReader &) = delete;
+
+  bool open(const std::string &path, std::string *error = nullptr);
+  void close();
+
+  [[nodiscard]] const std::vector<RecordingChunkInfo> &chunks() const { return m_chunks; }
+  [[nodiscard]] std::uint64_t sampleCount() const { return m_sampleCount; }
+  [[nodiscard]] std::uint64_t fileSize() const { return m_map.size(); }
+  // False if the index had to be rebuilt because the footer was missing
+  [[nodiscard]] bool wasClosedCleanly() const { return m_closedCleanly; }
+
+  // Chunk containing the given sample number / the first chunk ending at or
+  // after the timestamp; chunks().size() if there is none
+  [[nodiscard]] std::size_t chunkForSample(std::uint64_t sample) const;
+  [[nodiscard]] std::size_t chunkForTimestamp(std::uint64_t timestamp) const;
+
+  // Decodes one chunk, replacing the contents of out
+  bool readChunk(std::size_t chunk, std::vector<PowerData> &out);
+
+private:
+  bool loadIndex();
+  void rebuildIndex();
+
+  MappedFile m_map;
+  std::vector<RecordingChunkInfo> m_chunks;
+  std::uint64_t m_sampleCount = 0;
+  bool m_closedCleanly = false;
+};
+
+#endif // RECORDINGFORMAT_H
@@ -0,0 +1,216 @@
+#include "RecordingPyramid.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+constexpr char kSidecarMagic[8] = {'U', 'P', 'W', 'R', 'P', 'Y', 'R', '\0'};
+constexpr std::uint32_t kSidecarVersion = 1;
+constexpr std::size_t kMaxLevels = 24;
+
+struct SidecarHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t binBytes;
+  std::uint64_t samplesPerBin;
+  std::uint64_t fanout;
+  // Identifies the recording the pyramid was built from
+  std::uint64_t recordingSize;
+  std::uint64_t sampleCount;
+  std::uint64_t lastTimestamp;
+  std::uint64_t levelCount;
+  std::uint64_t levelCounts[kMaxLevels];
+};
+
+static_assert(std::is_trivially_copyable_v<GraphColumn>,
+              "GraphColumn is stored in the sidecar as is");
+static_assert(sizeof(SidecarHeader) % alignof(GraphColumn) == 0,
+              "bins follow the header");
+
+std::uint64_t lastTimestampOf(const RecordingReader &reader) {
+  return reader.chunks().empty() ? 0 : reader.chunks().back().header.lastTimestamp;
+}
+} // namespace
+
+std::string RecordingPyramid::sidecarPath(const std::string &recordingPath) {
+  return recordingPath + ".pyr";
+}
+
+float RecordingPyramid::displayCurrent(const PowerData &sample,
+                                       std::int32_t currentDiffMa) {
+  const float current = static_cast<float>(sample.current) -
+                        static_cast<float>(currentDiffMa) / 1000.0f;
+  return current < 0.0f ? 0.0f : current;
+}
+
+bool RecordingPyramid::build(RecordingReader &reader,
+                             const std::atomic<bool> &cancel,
+                             const Progress &progress) {
+  m_map.close();
+  m_levels.clear();
+  m_storage.clear();
+  m_storage.reserve(reader.sampleCount() / kSamplesPerBin + 1);
+
+  std::vector<PowerData> samples;
+  std::uint64_t index = 0;
+  const auto &chunks = reader.chunks();
+  for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+    if (cancel.load(std::memory_order_relaxed) ||
+        !reader.readChunk(chunk, samples)) {
+      m_storage.clear();
+      return false;
+    }
+    const std::int32_t diff = chunks[chunk].header.currentDiffMa;
+    for (const auto &sample : samples) {
+      if (index % kSamplesPerBin == 0) {
+        m_storage.emplace_back();
+      }
+      m_storage.back().add(displayCurrent(sample, diff),
+                           PowerDelivery::getEnum(static_cast<float>(sample.voltage)));
+      ++index;
+    }
+    if (progress) {
+      progress(index, reader.sampleCount());
+    }
+  }
+
+  m_sampleCount = index;
+  m_recordingSize = reader.fileSize();
+  m_lastTimestamp = lastTimestampOf(reader);
+  buildLevels();
+  return true;
+}
+
+void RecordingPyramid::buildLevels() {
+  m_levels.assign(1, Level{0, m_storage.size()});
+  while (m_levels.back().count > 1 && m_levels.size() < kMaxLevels) {
+    const Level below = m_levels.back();
+    const Level level{m_storage.size(), (below.count + kFanout - 1) / kFanout};
+    m_storage.reserve(m_storage.size() + level.count);
+    for (std::uint64_t i = 0; i < level.count; ++i) {
+      GraphColumn merged;
+      const std::uint64_t end = std::min((i + 1) * kFanout, below.count);
+      for (std::uint64_t j = i * kFanout; j < end; ++j) {
+        merged.append(m_storage[below.offset + j]);
+      }
+      m_storage.push_back(merged);
+    }
+    m_levels.push_back(level);
+  }
+  m_bins = m_storage.data();
+}
+
+bool RecordingPyramid::save(const std::string &path) const {
+  if (m_levels.empty()) {
+    return false;
+  }
+  SidecarHeader header{};
+  std::memcpy(header.magic, kSidecarMagic, sizeof(kSidecarMagic));
+  header.version = kSidecarVersion;
+  header.binBytes = sizeof(GraphColumn);
+  header.samplesPerBin = kSamplesPerBin;
+  header.fanout = kFanout;
+  header.recordingSize = m_recordingSize;
+  header.sampleCount = m_sampleCount;
+  header.lastTimestamp = m_lastTimestamp;
+  header.levelCount = m_levels.size();
+  std::uint64_t bins = 0;
+  for (std::size_t level = 0; level < m_levels.size(); ++level) {
+    header.levelCounts[level] = m_levels[level].count;
+    bins += m_levels[level].count;
+  }
+
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  const bool ok =
+      std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+      std::fwrite(m_bins, sizeof(GraphColumn), bins, file) == bins;
+  // A partially written sidecar fails the size check in load()
+  return std::fclose(file) == 0 && ok;
+}
+
+bool RecordingPyramid::load(const std::string &path,
+                            const RecordingReader &reader) {
+  m_levels.clear();
+  m_storage.clear();
+  m_bins = nullptr;
+  if (!m_map.open(path) || m_map.size() < sizeof(SidecarHeader)) {
+    m_map.close();
+    return false;
+  }
+  SidecarHeader header;
+  std::memcpy(&header, m_map.data(), sizeof(header));
+  if (std::memcmp(header.magic, kSidecarMagic, sizeof(kSidecarMagic)) != 0 ||
+      header.version != kSidecarVersion ||
+      header.binBytes != sizeof(GraphColumn) ||
+      header.samplesPerBin != kSamplesPerBin || header.fanout != kFanout ||
+      header.recordingSize != reader.fileSize() ||
+      header.sampleCount != reader.sampleCount() ||
+      header.lastTimestamp != lastTimestampOf(reader) ||
+      header.levelCount == 0 || header.levelCount > kMaxLevels) {
+    m_map.close();
+    return false;
+  }
+
+  std::uint64_t expected = (header.sampleCount + kSamplesPerBin - 1) / kSamplesPerBin;
+  std::uint64_t offset = 0;
+  for (std::size_t level = 0; level < header.levelCount; ++level) {
+    if (header.levelCounts[level] != expected) {
+      m_map.close();
+      m_levels.clear();
+      return false;
+    }
+    m_levels.push_back(Level{offset, expected});
+    offset += expected;
+    expected = (expected + kFanout - 1) / kFanout;
+  }
+  if (m_map.size() != sizeof(SidecarHeader) + offset * sizeof(GraphColumn)) {
+    m_map.close();
+    m_levels.clear();
+    return false;
+  }
+
+  m_sampleCount = header.sampleCount;
+  m_recordingSize = header.recordingSize;
+  m_lastTimestamp = header.lastTimestamp;
+  m_bins = reinterpret_cast<const GraphColumn *>(m_map.data() + sizeof(SidecarHeader));
+  return true;
+}
+
+bool RecordingPyramid::columns(std::uint64_t first, std::uint64_t count,
+                               std::vector<GraphColumn> &out) const {
+  const std::uint64_t columns = out.size();
+  if (columns == 0 || m_levels.empty() || count < columns * minSamplesPerColumn() ||
+      first + count > m_sampleCount) {
+    return false;
+  }
+
+  // Coarsest level that still has at least two bins per column
+  std::size_t level = 0;
+  std::uint64_t binSamples = kSamplesPerBin;
+  while (level + 1 < m_levels.size() &&
+         binSamples * kFanout * 2 * columns <= count) {
+    ++level;
+    binSamples *= kFanout;
+  }
+  const GraphColumn *bins = levelBins(level);
+  const std::uint64_t binCount = m_levels[level].count;
+
+  // Every bin goes to the column its first sample falls into
+  std::uint64_t bin = (first + binSamples - 1) / binSamples;
+  for (std::uint64_t column = 0; column < columns; ++column) {
+    const std::uint64_t end = first + (column + 1) * count / columns;
+    const std::uint64_t endBin =
+        std::min((end + binSamples - 1) / binSamples, binCount);
+    GraphColumn merged;
+    for (; bin < endBin; ++bin) {
+      merged.append(bins[bin]);
+    }
+    out[column] = merged;
+  }
+  return true;
+}
@@ -0,0 +1,81 @@
+#ifndef RECORDINGPYRAMID_H
+#define RECORDINGPYRAMID_H
+
+#include "GraphColumns.h"
+#include "MappedFile.h"
+#include "RecordingFormat.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Min/max pyramid over the current of a recording, so a graph of any part
+// of the file at any zoom level costs a few bins per pixel column instead of
+// a pass over the samples.
+//
+// Level 0 aggregates every 128 samples into one GraphColumn (M4: first,
+// min, max, last and the PD level), every further level merges 8 bins of
+// the level below. Currents have the base current offset of their chunk
+// applied, like the live graph.
+//
+// The pyramid is saved to a sidecar file next to the recording
+// (recording.upr.pyr) and memory-mapped when it is opened again. The sidecar
+// is a cache in the native byte order and struct layout; it is rebuilt
+// whenever it does not match the recording or this build.
+class RecordingPyramid {
+public:
+  static constexpr std::uint64_t kSamplesPerBin = 128;
+  static constexpr std::uint64_t kFanout = 8;
+
+  using Progress = std::function<void(std::uint64_t done, std::uint64_t total)>;
+
+  static std::string sidecarPath(const std::string &recordingPath);
+  // Current as the live graph showed it, with the chunk's base current
+  // offset applied
+  static float displayCurrent(const PowerData &sample, std::int32_t currentDiffMa);
+
+  // Scans the whole recording. Polls cancel between chunks.
+  bool build(RecordingReader &reader, const std::atomic<bool> &cancel,
+             const Progress &progress);
+  bool save(const std::string &path) const;
+  // Maps the sidecar; false unless it was built from exactly this recording
+  bool load(const std::string &path, const RecordingReader &reader);
+
+  [[nodiscard]] std::uint64_t sampleCount() const { return m_sampleCount; }
+  // The coarsest aggregation columns() can serve exactly enough; below this
+  // the samples themselves have to be read
+  [[nodiscard]] static std::uint64_t minSamplesPerColumn() {
+    return 2 * kSamplesPerBin;
+  }
+
+  // Aggregates samples [first, first + count) into out.size() columns,
+  // oldest first. Columns are assembled from whole bins, so their bounds are
+  // accurate to a quarter column. False below minSamplesPerColumn().
+  bool columns(std::uint64_t first, std::uint64_t count,
+               std::vector<GraphColumn> &out) const;
+
+private:
+  struct Level {
+    std::uint64_t offset = 0; // in bins from the start of all levels
+    std::uint64_t count = 0;
+  };
+
+  // Adds the coarser levels on top of level 0 in m_storage
+  void buildLevels();
+  [[nodiscard]] const GraphColumn *levelBins(std::size_t level) const {
+    return m_bins + m_levels[level].offset;
+  }
+
+  std::uint64_t m_sampleCount = 0;
+  std::uint64_t m_recordingSize = 0;
+  std::uint64_t m_lastTimestamp = 0;
+  std::vector<Level> m_levels;
+  // Either m_storage (built) or m_map (loaded)
+  std::vector<GraphColumn> m_storage;
+  MappedFile m_map;
+  const GraphColumn *m_bins = nullptr;
+};
+
+#endif // RECORDINGPYRAMID_H
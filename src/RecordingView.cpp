@@ -0,0 +1,151 @@
+#include "RecordingView.h"
+
+#include <QDebug>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+// Chunks end after 4096 samples or a second, so a slow meter has many small
+// ones and the cache is sized in samples. The view below the pyramid's
+// resolution spans up to width * minSamplesPerColumn() samples; twice that
+// is kept so panning by a screen does not decode everything again.
+constexpr std::uint64_t kCachedSamples = 1 << 20;
+} // namespace
+
+RecordingView::RecordingView(QObject *parent) : QObject(parent) {}
+
+RecordingView::~RecordingView() {
+  if (m_indexThread) {
+    m_cancelIndex.store(true);
+    m_indexThread->wait();
+    delete m_indexThread;
+  }
+}
+
+bool RecordingView::open(const QString &path, QString *error) {
+  std::string message;
+  if (!m_reader.open(path.toStdString(), &message)) {
+    if (error) {
+      *error = QString::fromStdString(message);
+    }
+    return false;
+  }
+  m_path = path;
+
+  auto pyramid = std::make_shared<RecordingPyramid>();
+  if (pyramid->load(RecordingPyramid::sidecarPath(path.toStdString()), m_reader)) {
+    m_pyramid = std::move(pyramid);
+  } else {
+    buildIndex();
+  }
+  return true;
+}
+
+// The worker reads the recording through its own mapping, the GUI thread
+// keeps using m_reader meanwhile
+void RecordingView::buildIndex() {
+  const std::string path = m_path.toStdString();
+  m_indexThread = QThread::create([this, path] {
+    RecordingReader reader;
+    auto pyramid = std::make_shared<RecordingPyramid>();
+    int lastPercent = -1;
+    const bool built =
+        reader.open(path) &&
+        pyramid->build(reader, m_cancelIndex,
+                       [this, &lastPercent](std::uint64_t done, std::uint64_t total) {
+                         const int percent = total ? static_cast<int>(100 * done / total) : 100;
+                         if (percent != lastPercent) {
+                           lastPercent = percent;
+                           emit indexProgress(percent);
+                         }
+                       });
+    if (m_cancelIndex.load()) {
+      return;
+    }
+    if (!built) {
+      emit indexFailed("Cannot index " + QString::fromStdString(path));
+      return;
+    }
+    // Without a sidecar, e.g. on a read-only medium, the next open indexes again
+    if (!pyramid->save(RecordingPyramid::sidecarPath(path))) {
+      qDebug() << "Cannot write the index of" << QString::fromStdString(path);
+    }
+    QMetaObject::invokeMethod(this, [this, pyramid] {
+      m_pyramid = pyramid;
+      emit indexReady();
+    });
+  });
+  m_indexThread->setObjectName("recording index");
+  m_indexThread->start(QThread::LowPriority);
+}
+
+bool RecordingView::columns(std::uint64_t first, std::uint64_t count,
+                            std::vector<GraphColumn> &out) {
+  if (out.empty() || count == 0 || first + count > sampleCount()) {
+    return false;
+  }
+  if (count >= out.size() * RecordingPyramid::minSamplesPerColumn()) {
+    return m_pyramid && m_pyramid->columns(first, count, out);
+  }
+
+  m_cacheBudget = std::max(kCachedSamples, 2 * count);
+  std::fill(out.begin(), out.end(), GraphColumn{});
+  const auto &chunks = m_reader.chunks();
+  const std::uint64_t end = first + count;
+  for (std::size_t chunk = m_reader.chunkForSample(first); chunk < chunks.size();
+       ++chunk) {
+    const RecordingChunkInfo &info = chunks[chunk];
+    if (info.firstSample >= end) {
+      break;
+    }
+    const std::vector<PowerData> *samples = chunkSamples(chunk);
+    if (!samples) {
+      return false;
+    }
+    const std::int32_t diff = info.header.currentDiffMa;
+    const std::uint64_t from = std::max(first, info.firstSample);
+    const std::uint64_t to = std::min(end, info.firstSample + samples->size());
+    for (std::uint64_t sample = from; sample < to; ++sample) {
+      const PowerData &data = (*samples)[sample - info.firstSample];
+      out[(sample - first) * out.size() / count].add(
+          RecordingPyramid::displayCurrent(data, diff),
+          PowerDelivery::getEnum(static_cast<float>(data.voltage)));
+    }
+  }
+  return true;
+}
+
+std::uint64_t RecordingView::timestampAt(std::uint64_t sample) {
+  const std::size_t chunk = m_reader.chunkForSample(sample);
+  if (chunk >= m_reader.chunks().size()) {
+    return 0;
+  }
+  const std::vector<PowerData> *samples = chunkSamples(chunk);
+  const std::uint64_t offset = sample - m_reader.chunks()[chunk].firstSample;
+  return samples && offset < samples->size() ? (*samples)[offset].timestamp : 0;
+}
+
+const std::vector<PowerData> *RecordingView::chunkSamples(std::size_t chunk) {
+  auto it = m_chunkCache.find(chunk);
+  if (it != m_chunkCache.end()) {
+    m_chunkOrder.splice(m_chunkOrder.end(), m_chunkOrder, it->second.order);
+    return &it->second.samples;
+  }
+
+  CachedChunk cached;
+  if (!m_reader.readChunk(chunk, cached.samples)) {
+    return nullptr;
+  }
+  // The chunks of the current view were used last and are evicted last
+  const std::uint64_t budget = std::max(kCachedSamples, m_cacheBudget);
+  while (!m_chunkOrder.empty() &&
+         m_cachedSamples + cached.samples.size() > budget) {
+    auto oldest = m_chunkCache.find(m_chunkOrder.front());
+    m_cachedSamples -= oldest->second.samples.size();
+    m_chunkCache.erase(oldest);
+    m_chunkOrder.pop_front();
+  }
+  m_cachedSamples += cached.samples.size();
+  cached.order = m_chunkOrder.insert(m_chunkOrder.end(), chunk);
+  return &m_chunkCache.emplace(chunk, std::move(cached)).first->second.samples;
+}
@@ -0,0 +1,75 @@
+#ifndef RECORDINGVIEW_H
+#define RECORDINGVIEW_H
+
+#include "GraphColumns.h"
+#include "RecordingFormat.h"
+#include "RecordingPyramid.h"
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+// Read-only access to a recording for the viewer: graph columns for any
+// sample range and the timestamps of single samples. Opening maps the file
+// and loads the min/max pyramid sidecar; if there is none yet it is built
+// on a background thread (indexProgress(), then indexReady()) and saved
+// next to the recording for the next time. Ranges fine enough to show
+// individual samples are read from the recording directly, so only the
+// chunks in view are ever decoded.
+class RecordingView : public QObject {
+  Q_OBJECT
+
+public:
+  explicit RecordingView(QObject *parent = nullptr);
+  ~RecordingView() override;
+
+  bool open(const QString &path, QString *error = nullptr);
+
+  [[nodiscard]] const QString &path() const { return m_path; }
+  [[nodiscard]] std::uint64_t sampleCount() const { return m_reader.sampleCount(); }
+  [[nodiscard]] bool isIndexed() const { return m_pyramid != nullptr; }
+  [[nodiscard]] bool wasClosedCleanly() const { return m_reader.wasClosedCleanly(); }
+
+  // Aggregates samples [first, first + count) into out.size() columns,
+  // oldest first; false while the pyramid is needed but not ready yet
+  bool columns(std::uint64_t first, std::uint64_t count,
+               std::vector<GraphColumn> &out);
+  // Unix time in ms, 0 if the sample cannot be read
+  std::uint64_t timestampAt(std::uint64_t sample);
+
+signals:
+  void indexProgress(int percent);
+  void indexReady();
+  void indexFailed(const QString &message);
+
+private:
+  void buildIndex();
+  const std::vector<PowerData> *chunkSamples(std::size_t chunk);
+
+  QString m_path;
+  RecordingReader m_reader;
+  std::shared_ptr<const RecordingPyramid> m_pyramid;
+  QThread *m_indexThread = nullptr;
+  std::atomic<bool> m_cancelIndex{false};
+
+  // Recently decoded chunks for panning at sample level, least recently
+  // used first in m_chunkOrder
+  struct CachedChunk {
+    std::vector<PowerData> samples;
+    std::list<std::size_t>::iterator order;
+  };
+  std::map<std::size_t, CachedChunk> m_chunkCache;
+  std::list<std::size_t> m_chunkOrder;
+  std::uint64_t m_cachedSamples = 0;
+  std::uint64_t m_cacheBudget = 0;
+};
+
+#endif // RECORDINGVIEW_H
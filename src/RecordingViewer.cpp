@@ -0,0 +1,49 @@
+#include "RecordingViewer.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QLabel>
+#include <QVBoxLayout>
+
+RecordingViewer::RecordingViewer(RecordingView *view, OsdSettings *settings,
+                                 QWidget *parent)
+    : QWidget(parent, Qt::Window), m_view(view),
+      m_graph(new CurrentGraph(this, nullptr, settings)),
+      m_status(new QLabel(this)) {
+  setAttribute(Qt::WA_DeleteOnClose);
+  m_view->setParent(this);
+  setWindowTitle(QFileInfo(m_view->path()).fileName() +
+                 (m_view->wasClosedCleanly() ? "" : " (incomplete)"));
+  resize(900, 320);
+
+  auto *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(0, 0, 0, 0);
+  layout->setSpacing(0);
+  layout->addWidget(m_graph, 1);
+  layout->addWidget(m_status);
+  m_status->setContentsMargins(5, 2, 5, 2);
+
+  connect(m_graph, &CurrentGraph::viewChanged, this,
+          &RecordingViewer::onViewChanged);
+  connect(m_view, &RecordingView::indexFailed, m_status, &QLabel::setText);
+  m_graph->setRecording(m_view);
+  onViewChanged(0, m_view->sampleCount());
+}
+
+void RecordingViewer::onViewChanged(quint64 firstSample, quint64 sampleCount) {
+  if (sampleCount == 0) {
+    m_status->setText("Empty recording");
+    return;
+  }
+  const auto from = QDateTime::fromMSecsSinceEpoch(
+      static_cast<qint64>(m_view->timestampAt(firstSample)));
+  const auto to = QDateTime::fromMSecsSinceEpoch(
+      static_cast<qint64>(m_view->timestampAt(firstSample + sampleCount - 1)));
+  const QString format = from.date() == to.date() ? "HH:mm:ss.zzz"
+                                                   : "yyyy-MM-dd HH:mm:ss.zzz";
+  m_status->setText(QString("%1 - %2  |  %3 of %4 samples")
+                        .arg(from.toString("yyyy-MM-dd HH:mm:ss.zzz"),
+                             to.toString(format))
+                        .arg(sampleCount)
+                        .arg(m_view->sampleCount()));
+}
@@ -0,0 +1,33 @@
+#ifndef RECORDINGVIEWER_H
+#define RECORDINGVIEWER_H
+
+#include "CurrentGraph.h"
+#include "OsdSettings.h"
+#include "RecordingView.h"
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+QT_END_NAMESPACE
+
+// Read-only window for a recorded session: the current graph over the whole
+// file plus the time range in view. Deletes itself when closed.
+class RecordingViewer : public QWidget {
+  Q_OBJECT
+
+public:
+  // Takes ownership of an opened view
+  RecordingViewer(RecordingView *view, OsdSettings *settings,
+                  QWidget *parent = nullptr);
+
+private slots:
+  void onViewChanged(quint64 firstSample, quint64 sampleCount);
+
+private:
+  RecordingView *m_view;
+  CurrentGraph *m_graph;
+  QLabel *m_status;
+};
+
+#endif // RECORDINGVIEWER_H
@@ -0,0 +1,98 @@
+#include "RepaintScheduler.h"
+
+#include <QEvent>
+#include <QScreen>
+#include <QWindow>
+#include <algorithm>
+#include <cmath>
+
+RepaintScheduler::RepaintScheduler(QWidget *widget)
+    : QObject(widget), m_widget(widget), m_timer(new QTimer(this)) {
+  m_timer->setSingleShot(true);
+  m_timer->setTimerType(Qt::PreciseTimer);
+  connect(m_timer, &QTimer::timeout, this, &RepaintScheduler::onTimeout);
+  m_widget->installEventFilter(this);
+}
+
+void RepaintScheduler::requestFrame() {
+  m_pending = true;
+  if (isPaused() || m_timer->isActive()) {
+    return;
+  }
+
+  const int interval = frameIntervalMs();
+  if (!m_lastFrame.isValid() || m_lastFrame.elapsed() >= interval) {
+    deliverFrame();
+  } else {
+    m_timer->start(interval - static_cast<int>(m_lastFrame.elapsed()));
+  }
+}
+
+bool RepaintScheduler::eventFilter(QObject *watched, QEvent *event) {
+  switch (event->type()) {
+  case QEvent::Show:
+  case QEvent::WindowStateChange:
+  case QEvent::ParentChange:
+    // The top level window may change when the widget is (re)parented; watch
+    // it for minimize/restore
+    if (m_window != m_widget->window()) {
+      if (m_window) {
+        m_window->removeEventFilter(this);
+      }
+      m_window = m_widget->window();
+      if (m_window != m_widget) {
+        m_window->installEventFilter(this);
+      }
+    }
+    // Uncovering the window or switching back to its virtual desktop only
+    // reaches the QWindow
+    if (m_windowHandle != m_window->windowHandle()) {
+      if (m_windowHandle) {
+        m_windowHandle->removeEventFilter(this);
+      }
+      m_windowHandle = m_window->windowHandle();
+      if (m_windowHandle) {
+        m_windowHandle->installEventFilter(this);
+      }
+    }
+    [[fallthrough]];
+  case QEvent::Expose:
+    if (m_pending) {
+      // Resumed: catch up on what was skipped while paused
+      requestFrame();
+    }
+    break;
+  default:
+    break;
+  }
+  return QObject::eventFilter(watched, event);
+}
+
+void RepaintScheduler::onTimeout() {
+  if (m_pending && !isPaused()) {
+    deliverFrame();
+  }
+}
+
+void RepaintScheduler::deliverFrame() {
+  m_pending = false;
+  m_lastFrame.restart();
+  emit frameDue();
+}
+
+bool RepaintScheduler::isPaused() const {
+  if (!m_widget->isVisible() || m_widget->window()->isMinimized()) {
+    return true;
+  }
+  const QWindow *handle = m_widget->window()->windowHandle();
+  return handle && !handle->isExposed();
+}
+
+int RepaintScheduler::frameIntervalMs() const {
+  const QScreen *screen = m_widget->screen();
+  const qreal refreshRate = screen ? screen->refreshRate() : 60.0;
+  if (refreshRate <= 1.0) {
+    return 16;
+  }
+  return std::max(1, static_cast<int>(std::ceil(1000.0 / refreshRate)));
+}
@@ -0,0 +1,46 @@
+#ifndef REPAINTSCHEDULER_H
+#define REPAINTSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+#include <QWindow>
+
+// Coalesces data-change notifications into frames.
+// frameDue() is emitted only after requestFrame() was called, at most once per
+// display refresh interval, and never while the widget is hidden, minimized
+// or not exposed. Without new data no timer is running at all.
+class RepaintScheduler : public QObject {
+  Q_OBJECT
+
+public:
+  explicit RepaintScheduler(QWidget *widget);
+
+  // Marks the widget content as stale and schedules a frame
+  void requestFrame();
+
+signals:
+  // Time to produce a frame
+  void frameDue();
+
+protected:
+  bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+  void onTimeout();
+  void deliverFrame();
+  [[nodiscard]] bool isPaused() const;
+  [[nodiscard]] int frameIntervalMs() const;
+
+  QWidget *m_widget;
+  QWidget *m_window = nullptr;
+  // Receives the Expose events of the top level window
+  QPointer<QWindow> m_windowHandle;
+  QTimer *m_timer;
+  QElapsedTimer m_lastFrame;
+  bool m_pending = false;
+};
+
+#endif // REPAINTSCHEDULER_H
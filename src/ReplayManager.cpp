@@ -0,0 +1,207 @@
+#include "ReplayManager.h"
+
+#include "BleDecoder.h"
+#include "RawCaptureFormat.h"
+#include "RecordingFormat.h"
+#include "SerialDecoder.h"
+
+#include <QThread>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+ReplayManager::ReplayManager(QObject *parent) : QObject(parent) {}
+
+ReplayManager::~ReplayManager() { stop(); }
+
+bool ReplayManager::isReplayable(const QString &path, QString *error) {
+  std::string message;
+  const bool readable = RawCaptureReader::isCapture(path.toStdString())
+                            ? RawCaptureReader().open(path.toStdString(), &message)
+                            : RecordingReader().open(path.toStdString(), &message);
+  if (!readable && error) {
+    *error = QString::fromStdString(message);
+  }
+  return readable;
+}
+
+bool ReplayManager::start(const QString &path, double speed, QString *error) {
+  stop();
+  // Fail early on unreadable files instead of on the worker
+  if (!isReplayable(path, error)) {
+    return false;
+  }
+
+  m_stop.store(false);
+  m_inFlight.store(0);
+  m_emitted.store(0);
+  m_elapsed.start();
+  const quint64 generation = ++m_generation;
+  m_thread = QThread::create(
+      [this, path, speed, generation] { run(path, speed, generation); });
+  m_thread->setObjectName("replay");
+  m_thread->start(QThread::HighPriority);
+  return true;
+}
+
+void ReplayManager::stop() {
+  if (!m_thread) {
+    return;
+  }
+  m_stop.store(true);
+  joinWorker();
+  emit finished(m_emitted.load(), m_elapsed.elapsed(), false);
+}
+
+void ReplayManager::joinWorker() {
+  m_thread->wait();
+  delete m_thread;
+  m_thread = nullptr;
+  // A completion the worker posted meanwhile is stale now
+  ++m_generation;
+}
+
+void ReplayManager::onWorkerDone(quint64 generation, bool completed) {
+  if (generation != m_generation || !m_thread) {
+    return;
+  }
+  joinWorker();
+  emit finished(m_emitted.load(), m_elapsed.elapsed(), completed);
+}
+
+void ReplayManager::run(const QString &path, double speed, quint64 generation) {
+  using Clock = std::chrono::steady_clock;
+
+  // Posted behind all queued dataReceived() deliveries
+  bool completed = true;
+  auto done = [this, generation, &completed] {
+    QMetaObject::invokeMethod(this, [this, generation, completed] {
+      onWorkerDone(generation, completed);
+    });
+  };
+
+  const Clock::time_point start = Clock::now();
+  std::uint64_t firstTimestampUs = 0;
+  auto stopRequested = [this] { return m_stop.load(std::memory_order_relaxed); };
+  // Waits until what was acquired at timestampUs is due; false on stop()
+  auto wait = [&](std::uint64_t timestampUs) {
+    if (firstTimestampUs == 0) {
+      firstTimestampUs = timestampUs;
+    }
+    if (speed > 0.0 && timestampUs > firstTimestampUs) {
+      const auto due =
+          start + std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double, std::micro>(
+                          static_cast<double>(timestampUs - firstTimestampUs) / speed));
+      // Samples due within the same millisecond go out together; long
+      // gaps are slept in slices to stay responsive to stop()
+      for (auto ahead = due - Clock::now();
+           ahead > std::chrono::milliseconds(1) && !stopRequested();
+           ahead = due - Clock::now()) {
+        std::this_thread::sleep_for(
+            std::min<Clock::duration>(ahead, std::chrono::milliseconds(50)));
+      }
+    }
+    return !stopRequested();
+  };
+  auto deliver = [&](const PowerData &sample, const SampleStamps &stamps) {
+    while (m_inFlight.load(std::memory_order_relaxed) >= kMaxInFlight &&
+           !stopRequested()) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    if (stopRequested()) {
+      return false;
+    }
+    m_inFlight.fetch_add(1, std::memory_order_relaxed);
+    emit dataReceived(sample, stamps, generation);
+    m_emitted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  };
+
+  if (RawCaptureReader::isCapture(path.toStdString())) {
+    completed = replayCapture(path, wait, deliver);
+  } else {
+    completed = replayRecording(path, wait, deliver);
+  }
+  done();
+}
+
+bool ReplayManager::replayRecording(const QString &path, const WaitFunction &wait,
+                                    const DeliverFunction &deliver) {
+  RecordingReader reader;
+  if (!reader.open(path.toStdString())) {
+    return false;
+  }
+  std::vector<PowerData> samples;
+  for (std::size_t chunk = 0; chunk < reader.chunks().size(); ++chunk) {
+    if (!reader.readChunk(chunk, samples)) {
+      return false;
+    }
+    for (const auto &sample : samples) {
+      if (!wait(sample.timestamp * 1000)) {
+        return false;
+      }
+      // Nothing to decode; the sample arrives when it is due
+      const std::uint64_t dueNs = PipelineLatency::nowNs();
+      if (!deliver(sample, SampleStamps{dueNs, dueNs})) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool ReplayManager::replayCapture(const QString &path, const WaitFunction &wait,
+                                  const DeliverFunction &deliver) {
+  RawCaptureReader reader;
+  if (!reader.open(path.toStdString())) {
+    return false;
+  }
+  // The decoders of the live transports, fed with the bytes as they arrived
+  // and stamped with the arrival times, as SerialManager and BluetoothManager
+  // do
+  SerialDecoder serial;
+  BleDecoder ble;
+  std::vector<PowerData> samples;
+  RawCaptureRecord record;
+  while (reader.next(record)) {
+    if (!wait(record.timestampUs)) {
+      return false;
+    }
+    const std::uint64_t readNs = PipelineLatency::nowNs();
+    const char *data = reinterpret_cast<const char *>(record.data);
+    const std::uint64_t timestampMs = record.timestampUs / 1000;
+    samples.clear();
+    if (record.type == CaptureRecordType::Connected) {
+      const std::string source(data, record.size);
+      SerialProtocol protocol;
+      if (record.source == CaptureSource::Serial &&
+          SerialDecoder::protocolFromName(source.substr(0, source.find('\t')),
+                                          protocol)) {
+        serial.setProtocol(protocol);
+        serial.reset();
+      }
+      continue;
+    }
+    if (record.type != CaptureRecordType::Data) {
+      continue;
+    }
+    if (record.source == CaptureSource::Serial) {
+      serial.feed(data, record.size, timestampMs, samples);
+    } else if (record.source == CaptureSource::Ble) {
+      PowerData sample;
+      if (ble.decode(QByteArray::fromRawData(data, static_cast<int>(record.size)),
+                     timestampMs, sample)) {
+        samples.push_back(sample);
+      }
+    }
+    const SampleStamps stamps{readNs, PipelineLatency::nowNs()};
+    for (const auto &sample : samples) {
+      if (!deliver(sample, stamps)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
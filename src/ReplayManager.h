@@ -0,0 +1,88 @@
+#ifndef REPLAYMANAGER_H
+#define REPLAYMANAGER_H
+
+#include "PipelineLatency.h"
+#include "PowerData.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+// Plays a recorded session back as if it came from a meter, with the
+// recorded timestamps. The recording is read and paced on a worker thread
+// that emits dataReceived() like SerialManager does. Raw captures
+// (RawCaptureFormat.h) are replayed too: their bytes are paced by arrival
+// time and decoded by the same decoders as live data.
+//
+// At most kMaxInFlight samples are emitted but not yet confirmed with
+// sampleConsumed(), so the as-fast-as-possible mode runs at the rate the
+// receivers can handle instead of flooding the event queue. That also makes
+// the final rate a throughput measurement of the whole pipeline.
+class ReplayManager : public QObject {
+  Q_OBJECT
+
+public:
+  static constexpr int kMaxInFlight = 4096;
+
+  explicit ReplayManager(QObject *parent = nullptr);
+  ~ReplayManager() override;
+
+  // Whether start() can open the file, a recording or a raw capture
+  static bool isReplayable(const QString &path, QString *error = nullptr);
+  // speed: 1 = real time, 10 = ten times faster, 0 = as fast as possible
+  bool start(const QString &path, double speed, QString *error = nullptr);
+  // Waits for the worker and emits finished() unless the replay already did
+  void stop();
+  [[nodiscard]] bool isRunning() const { return m_thread != nullptr; }
+
+  // Thread-safe; to be called once per delivered dataReceived(). Returns
+  // false without counting it for a sample of a replay that was stopped or
+  // restarted meanwhile, which the receiver should drop.
+  bool sampleConsumed(quint64 generation) {
+    if (generation != m_generation.load()) {
+      return false;
+    }
+    m_inFlight.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+signals:
+  // Emitted on the worker thread; generation identifies the start() it
+  // belongs to
+  void dataReceived(const PowerData &data, const SampleStamps &stamps,
+                    quint64 generation);
+  // Once per start(), after the last dataReceived() of the recording or
+  // from stop(); elapsedMs is the wall time of the replay
+  void finished(quint64 samples, qint64 elapsedMs, bool completed);
+
+private:
+  // Wait until a timestamp (us) is due / emit one sample; false on stop()
+  using WaitFunction = std::function<bool(std::uint64_t)>;
+  using DeliverFunction = std::function<bool(const PowerData &, const SampleStamps &)>;
+
+  void run(const QString &path, double speed, quint64 generation);
+  static bool replayRecording(const QString &path, const WaitFunction &wait,
+                              const DeliverFunction &deliver);
+  static bool replayCapture(const QString &path, const WaitFunction &wait,
+                            const DeliverFunction &deliver);
+  void onWorkerDone(quint64 generation, bool completed);
+  void joinWorker();
+
+  QThread *m_thread = nullptr;
+  // Tells a finished worker or a queued sample apart from one of a replay
+  // that was already stopped
+  std::atomic<quint64> m_generation{0};
+  QElapsedTimer m_elapsed;
+  std::atomic<bool> m_stop{false};
+  std::atomic<int> m_inFlight{0};
+  std::atomic<quint64> m_emitted{0};
+};
+
+#endif // REPLAYMANAGER_H
@@ -0,0 +1,468 @@
+#include "SampleCodec.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Block layout, integers little-endian:
+//
+//   u32 sampleCount
+//   u32 bytes | timestamp bits
+//   4 x channel (voltage, current, power, energy):
+//     u8 mode | [u8 decimals] | u32 bytes | channel bits
+//
+// Bit streams are written MSB first and padded to a whole byte.
+
+namespace {
+enum class ChannelMode : unsigned char {
+  Xor = 0,
+  Decimal = 1,
+  // voltage * current, nothing stored
+  Product = 2,
+};
+
+constexpr int kMaxDecimals = 6;
+constexpr double kPow10[kMaxDecimals + 1] = {1.0, 10.0, 100.0, 1000.0,
+                                             1e4, 1e5,  1e6};
+// Decimal values must stay exact integers in a double
+constexpr double kMaxDecimalMagnitude = 4503599627370496.0; // 2^52
+
+std::uint64_t bitsOf(double v) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  return bits;
+}
+
+double doubleOf(std::uint64_t bits) {
+  double v;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+int leadingZeros(std::uint64_t v) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanReverse64(&index, v);
+  return 63 - static_cast<int>(index);
+#else
+  return __builtin_clzll(v);
+#endif
+}
+
+int trailingZeros(std::uint64_t v) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, v);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(v);
+#endif
+}
+
+void putU32(std::vector<unsigned char> &out, std::size_t at, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    out[at + i] = static_cast<unsigned char>(v >> (8 * i));
+  }
+}
+
+std::uint32_t getU32(const unsigned char *p) {
+  return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 |
+         static_cast<std::uint32_t>(p[2]) << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<unsigned char> &out) : m_out(out) {}
+
+  // Up to 64 bits
+  void put(std::uint64_t value, int bits) {
+    if (bits > 32) {
+      putSmall(value >> 32, bits - 32);
+      bits = 32;
+    }
+    putSmall(value, bits);
+  }
+
+  void finish() {
+    if (m_count > 0) {
+      m_out.push_back(static_cast<unsigned char>(m_acc << (8 - m_count)));
+      m_count = 0;
+    }
+  }
+
+  // Small signed integers in as few bits as possible:
+  // 0 | 10+7 | 110+9 | 1110+12 | 1111+64
+  void putSigned(std::int64_t v) {
+    if (v == 0) {
+      putSmall(0, 1);
+    } else if (v >= -63 && v <= 64) {
+      putSmall(0x2, 2);
+      putSmall(static_cast<std::uint64_t>(v + 63), 7);
+    } else if (v >= -255 && v <= 256) {
+      putSmall(0x6, 3);
+      putSmall(static_cast<std::uint64_t>(v + 255), 9);
+    } else if (v >= -2047 && v <= 2048) {
+      putSmall(0xE, 4);
+      putSmall(static_cast<std::uint64_t>(v + 2047), 12);
+    } else {
+      putSmall(0xF, 4);
+      put(static_cast<std::uint64_t>(v), 64);
+    }
+  }
+
+private:
+  void putSmall(std::uint64_t value, int bits) {
+    m_acc = (m_acc << bits) | (value & ((std::uint64_t(1) << bits) - 1));
+    m_count += bits;
+    while (m_count >= 8) {
+      m_count -= 8;
+      m_out.push_back(static_cast<unsigned char>(m_acc >> m_count));
+    }
+  }
+
+  std::vector<unsigned char> &m_out;
+  std::uint64_t m_acc = 0;
+  int m_count = 0;
+};
+
+// Reads past the end return zero bits and set overrun()
+class BitReader {
+public:
+  BitReader(const unsigned char *data, std::size_t size)
+      : m_p(data), m_end(data + size) {}
+
+  std::uint64_t get(int bits) {
+    if (bits > 32) {
+      const std::uint64_t high = getSmall(bits - 32);
+      return high << 32 | getSmall(32);
+    }
+    return getSmall(bits);
+  }
+
+  std::int64_t getSigned() {
+    if (getSmall(1) == 0) {
+      return 0;
+    }
+    if (getSmall(1) == 0) {
+      return static_cast<std::int64_t>(getSmall(7)) - 63;
+    }
+    if (getSmall(1) == 0) {
+      return static_cast<std::int64_t>(getSmall(9)) - 255;
+    }
+    if (getSmall(1) == 0) {
+      return static_cast<std::int64_t>(getSmall(12)) - 2047;
+    }
+    return static_cast<std::int64_t>(get(64));
+  }
+
+  [[nodiscard]] bool overrun() const { return m_overrun; }
+
+private:
+  std::uint64_t getSmall(int bits) {
+    while (m_count < bits) {
+      std::uint64_t byte = 0;
+      if (m_p < m_end) {
+        byte = *m_p++;
+      } else {
+        m_overrun = true;
+      }
+      m_acc = (m_acc << 8) | byte;
+      m_count += 8;
+    }
+    m_count -= bits;
+    return (m_acc >> m_count) & ((std::uint64_t(1) << bits) - 1);
+  }
+
+  const unsigned char *m_p;
+  const unsigned char *m_end;
+  std::uint64_t m_acc = 0;
+  int m_count = 0;
+  bool m_overrun = false;
+};
+
+void encodeTimestamps(const PowerData *samples, std::size_t count,
+                      std::vector<unsigned char> &out) {
+  BitWriter bits(out);
+  bits.put(samples[0].timestamp, 64);
+  std::uint64_t prevDelta = 0;
+  for (std::size_t i = 1; i < count; ++i) {
+    const std::uint64_t delta = samples[i].timestamp - samples[i - 1].timestamp;
+    bits.putSigned(static_cast<std::int64_t>(delta - prevDelta));
+    prevDelta = delta;
+  }
+  bits.finish();
+}
+
+bool decodeTimestamps(const unsigned char *p, std::size_t size,
+                      std::vector<PowerData> &out) {
+  BitReader bits(p, size);
+  std::uint64_t ts = bits.get(64);
+  std::uint64_t delta = 0;
+  out[0].timestamp = ts;
+  for (std::size_t i = 1; i < out.size(); ++i) {
+    delta += static_cast<std::uint64_t>(bits.getSigned());
+    ts += delta;
+    out[i].timestamp = ts;
+  }
+  return !bits.overrun();
+}
+
+// Gorilla XOR: 0 = same value; 10 = changed bits fit the previous
+// leading/trailing zero window; 11 + 5 bit leading zeros + 6 bit length
+void encodeXor(const std::vector<double> &values, std::vector<unsigned char> &out) {
+  BitWriter bits(out);
+  std::uint64_t prev = bitsOf(values[0]);
+  bits.put(prev, 64);
+  int windowLeading = 64;
+  int windowTrailing = 64;
+  for (std::size_t i = 1; i < values.size(); ++i) {
+    const std::uint64_t cur = bitsOf(values[i]);
+    const std::uint64_t x = cur ^ prev;
+    prev = cur;
+    if (x == 0) {
+      bits.put(0, 1);
+      continue;
+    }
+    int leading = leadingZeros(x);
+    const int trailing = trailingZeros(x);
+    if (leading > 31) {
+      leading = 31;
+    }
+    if (leading >= windowLeading && trailing >= windowTrailing &&
+        windowLeading + windowTrailing < 64) {
+      bits.put(0x2, 2);
+      bits.put(x >> windowTrailing, 64 - windowLeading - windowTrailing);
+      continue;
+    }
+    const int meaningful = 64 - leading - trailing;
+    bits.put(0x3, 2);
+    bits.put(static_cast<std::uint64_t>(leading), 5);
+    bits.put(static_cast<std::uint64_t>(meaningful & 63), 6);
+    bits.put(x >> trailing, meaningful);
+    windowLeading = leading;
+    windowTrailing = trailing;
+  }
+  bits.finish();
+}
+
+bool decodeXor(const unsigned char *p, std::size_t size,
+               double PowerData::*field, std::vector<PowerData> &out) {
+  BitReader bits(p, size);
+  std::uint64_t value = bits.get(64);
+  out[0].*field = doubleOf(value);
+  int windowLeading = 0;
+  int windowTrailing = 0;
+  for (std::size_t i = 1; i < out.size(); ++i) {
+    if (bits.get(1) != 0) {
+      if (bits.get(1) != 0) {
+        windowLeading = static_cast<int>(bits.get(5));
+        int meaningful = static_cast<int>(bits.get(6));
+        if (meaningful == 0) {
+          meaningful = 64;
+        }
+        windowTrailing = 64 - windowLeading - meaningful;
+        if (windowTrailing < 0) {
+          return false;
+        }
+      }
+      const int meaningful = 64 - windowLeading - windowTrailing;
+      if (meaningful <= 0) {
+        return false;
+      }
+      value ^= bits.get(meaningful) << windowTrailing;
+    }
+    out[i].*field = doubleOf(value);
+  }
+  return !bits.overrun();
+}
+
+// Smallest number of decimals that represents every value exactly, or -1
+int decimalsFor(const std::vector<double> &values) {
+  int decimals = 0;
+  for (const double v : values) {
+    if (!std::isfinite(v) || std::fabs(v) * kPow10[kMaxDecimals] >= kMaxDecimalMagnitude ||
+        (v == 0.0 && std::signbit(v))) {
+      return -1;
+    }
+    while (static_cast<double>(std::llround(v * kPow10[decimals])) /
+               kPow10[decimals] != v) {
+      if (++decimals > kMaxDecimals) {
+        return -1;
+      }
+    }
+  }
+  return decimals;
+}
+
+// Integer deltas of value * 10^decimals
+bool encodeDecimal(const std::vector<double> &values, int decimals,
+                   std::vector<unsigned char> &out) {
+  const double scale = kPow10[decimals];
+  BitWriter bits(out);
+  std::int64_t prev = 0;
+  for (const double v : values) {
+    const std::int64_t q = std::llround(v * scale);
+    // Some values only round-trip with fewer decimals
+    if (static_cast<double>(q) / scale != v) {
+      return false;
+    }
+    bits.putSigned(q - prev);
+    prev = q;
+  }
+  bits.finish();
+  return true;
+}
+
+bool decodeDecimal(const unsigned char *p, std::size_t size, int decimals,
+                   double PowerData::*field, std::vector<PowerData> &out) {
+  const double scale = kPow10[decimals];
+  BitReader bits(p, size);
+  std::int64_t q = 0;
+  for (auto &sample : out) {
+    // Bounded before adding, so a corrupt delta cannot overflow q
+    const std::int64_t delta = bits.getSigned();
+    if (std::fabs(static_cast<double>(delta)) >= 2.0 * kMaxDecimalMagnitude) {
+      return false;
+    }
+    q += delta;
+    if (q >= kMaxDecimalMagnitude || q <= -kMaxDecimalMagnitude) {
+      return false;
+    }
+    sample.*field = static_cast<double>(q) / scale;
+  }
+  return !bits.overrun();
+}
+
+bool isProduct(const PowerData *samples, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    if (bitsOf(samples[i].voltage * samples[i].current) != bitsOf(samples[i].power)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void encodeChannel(const PowerData *samples, std::size_t count,
+                   double PowerData::*field, std::vector<double> &values,
+                   std::vector<unsigned char> &scratch,
+                   std::vector<unsigned char> &out) {
+  if (field == &PowerData::power && isProduct(samples, count)) {
+    out.push_back(static_cast<unsigned char>(ChannelMode::Product));
+    return;
+  }
+  values.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    values[i] = samples[i].*field;
+  }
+
+  // Both encodings are cheap; keep whichever is smaller for this block
+  const std::size_t xorStart = out.size() + 5;
+  out.push_back(static_cast<unsigned char>(ChannelMode::Xor));
+  out.resize(xorStart);
+  encodeXor(values, out);
+  const std::size_t xorBytes = out.size() - xorStart;
+
+  const int decimals = decimalsFor(values);
+  scratch.clear();
+  if (decimals >= 0 && encodeDecimal(values, decimals, scratch) &&
+      scratch.size() + 1 < xorBytes) {
+    out.resize(xorStart - 5);
+    out.push_back(static_cast<unsigned char>(ChannelMode::Decimal));
+    out.push_back(static_cast<unsigned char>(decimals));
+    const std::size_t at = out.size();
+    out.resize(at + 4);
+    putU32(out, at, static_cast<std::uint32_t>(scratch.size()));
+    out.insert(out.end(), scratch.begin(), scratch.end());
+    return;
+  }
+  putU32(out, xorStart - 4, static_cast<std::uint32_t>(xorBytes));
+}
+} // namespace
+
+void SampleCodec::encode(const PowerData *samples, std::size_t count,
+                         std::vector<unsigned char> &out) {
+  out.clear();
+  out.resize(8);
+  putU32(out, 0, static_cast<std::uint32_t>(count));
+  if (count == 0) {
+    putU32(out, 4, 0);
+    return;
+  }
+  encodeTimestamps(samples, count, out);
+  putU32(out, 4, static_cast<std::uint32_t>(out.size() - 8));
+
+  std::vector<double> values;
+  std::vector<unsigned char> scratch;
+  for (auto field : {&PowerData::voltage, &PowerData::current,
+                     &PowerData::power, &PowerData::energy}) {
+    encodeChannel(samples, count, field, values, scratch, out);
+  }
+}
+
+bool SampleCodec::decode(const unsigned char *data, std::size_t size,
+                         std::vector<PowerData> &out) {
+  if (size < 8) {
+    return false;
+  }
+  const std::uint32_t count = getU32(data);
+  std::size_t sectionBytes = getU32(data + 4);
+  // Every sample takes at least one bit of timestamp
+  if (sectionBytes > size - 8 || count > 8 * sectionBytes) {
+    return false;
+  }
+  out.assign(count, PowerData());
+  if (count == 0) {
+    return true;
+  }
+  const unsigned char *p = data + 8;
+  const unsigned char *end = data + size;
+  if (!decodeTimestamps(p, sectionBytes, out)) {
+    return false;
+  }
+  p += sectionBytes;
+
+  for (auto field : {&PowerData::voltage, &PowerData::current,
+                     &PowerData::power, &PowerData::energy}) {
+    if (p == end) {
+      return false;
+    }
+    const auto mode = static_cast<ChannelMode>(*p++);
+    if (mode == ChannelMode::Product) {
+      if (field != &PowerData::power) {
+        return false;
+      }
+      for (auto &sample : out) {
+        sample.power = sample.voltage * sample.current;
+      }
+      continue;
+    }
+    int decimals = 0;
+    if (mode == ChannelMode::Decimal) {
+      if (p == end || *p > kMaxDecimals) {
+        return false;
+      }
+      decimals = *p++;
+    } else if (mode != ChannelMode::Xor) {
+      return false;
+    }
+    if (end - p < 4) {
+      return false;
+    }
+    sectionBytes = getU32(p);
+    p += 4;
+    if (sectionBytes > static_cast<std::size_t>(end - p)) {
+      return false;
+    }
+    const bool ok = mode == ChannelMode::Decimal
+                        ? decodeDecimal(p, sectionBytes, decimals, field, out)
+                        : decodeXor(p, sectionBytes, field, out);
+    if (!ok) {
+      return false;
+    }
+    p += sectionBytes;
+  }
+  return p == end;
+}
@@ -0,0 +1,31 @@
+#ifndef SAMPLECODEC_H
+#define SAMPLECODEC_H
+
+#include "PowerData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lossless block compression for PowerData series, after Facebook's Gorilla
+// time series encoding:
+//
+// - timestamps as bit-packed delta-of-deltas (a steady sample rate costs a
+//   single bit per sample)
+// - every value channel picks the smaller of two encodings per block:
+//   * decimal: meters report whole mV/mA, so value * 10^k is an integer
+//     for all samples of the block; stored as zigzag varint deltas
+//   * XOR: Gorilla XOR against the previous value for arbitrary doubles
+// - power is not stored at all when it is exactly voltage * current
+//
+// Decoding reproduces every double bit for bit.
+class SampleCodec {
+public:
+  static void encode(const PowerData *samples, std::size_t count,
+                     std::vector<unsigned char> &out);
+  // Replaces the contents of out; false on malformed input
+  static bool decode(const unsigned char *data, std::size_t size,
+                     std::vector<PowerData> &out);
+};
+
+#endif // SAMPLECODEC_H
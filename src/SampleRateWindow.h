@@ -0,0 +1,42 @@
+#ifndef SAMPLERATEWINDOW_H
+#define SAMPLERATEWINDOW_H
+
+#include <cstdint>
+
+// Sample rate over windows of about a second. Measured on the sample clock
+// rather than the wall clock, so a replay reports the rate it was recorded
+// at, scaled by its speed.
+class SampleRateWindow {
+public:
+  static constexpr std::uint64_t kWindowMs = 1000;
+
+  // Counts a sample; returns the rate in Hz when it closes a window, -1
+  // otherwise. A timestamp going backwards starts a new window.
+  double add(std::uint64_t timestampMs) {
+    ++m_samples;
+    if (m_start == 0 || timestampMs < m_start) {
+      m_start = timestampMs;
+      m_samples = 0;
+      return -1.0;
+    }
+    if (timestampMs - m_start < kWindowMs) {
+      return -1.0;
+    }
+    const double rate = static_cast<double>(m_samples) * 1000.0 /
+                        static_cast<double>(timestampMs - m_start);
+    m_start = timestampMs;
+    m_samples = 0;
+    return rate;
+  }
+
+  void reset() {
+    m_start = 0;
+    m_samples = 0;
+  }
+
+private:
+  std::uint64_t m_start = 0;
+  std::uint64_t m_samples = 0;
+};
+
+#endif // SAMPLERATEWINDOW_H
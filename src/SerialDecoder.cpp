@@ -0,0 +1,167 @@
+#include "SerialDecoder.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+int8_t hex2bin(const unsigned char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0'; // NOLINT(*-narrowing-conversions)
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10; // NOLINT(*-narrowing-conversions)
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10; // NOLINT(*-narrowing-conversions)
+  }
+  return 0;
+}
+
+int16_t hex4_to_uint16(const char *buf) {
+  const int16_t val =
+      (hex2bin(buf[0]) << 12) | // NOLINT(*-narrowing-conversions)
+      (hex2bin(buf[1]) << 8) |  // NOLINT(*-narrowing-conversions)
+      (hex2bin(buf[2]) << 4) |  // NOLINT(*-narrowing-conversions)
+      hex2bin(buf[3]);
+  return val;
+}
+
+int16_t hex4_to_int16(const char *buf) {
+  char digits[5];
+  std::memcpy(digits, buf, 4);
+  digits[4] = '\0';
+  return static_cast<int16_t>(strtol(digits, nullptr, 16));
+}
+
+// Same set as QByteArray::trimmed()
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
+}
+
+void trim(const char *&line, std::size_t &size) {
+  while (size > 0 && isSpace(line[0])) {
+    ++line;
+    --size;
+  }
+  while (size > 0 && isSpace(line[size - 1])) {
+    --size;
+  }
+}
+} // namespace
+
+std::size_t SerialDecoder::feed(const char *data, std::size_t size,
+                                std::uint64_t timestampMs,
+                                std::vector<PowerData> &out) {
+  const std::size_t before = out.size();
+  auto decode = [&](const char *line, std::size_t length) {
+    PowerData sample;
+    trim(line, length);
+    if (!decodeLine(line, length, m_protocol, sample)) {
+      ++m_badLines;
+      return;
+    }
+    sample.timestamp = timestampMs;
+    out.push_back(sample);
+  };
+
+  const char *end = data + size;
+  while (data < end) {
+    const auto *newline =
+        static_cast<const char *>(std::memchr(data, '\n', end - data));
+    if (!newline) {
+      m_line.append(data, end);
+      break;
+    }
+    if (m_line.empty()) {
+      // The common case: the whole line is in this read
+      decode(data, newline - data);
+    } else {
+      m_line.append(data, newline);
+      decode(m_line.data(), m_line.size());
+      m_line.clear();
+    }
+    data = newline + 1;
+  }
+  return out.size() - before;
+}
+
+bool SerialDecoder::decodeLine(const char *line, std::size_t size,
+                               SerialProtocol protocol, PowerData &sample) {
+  double voltage_quanta;
+  double current_quanta;
+
+  if (protocol == SerialProtocol::PLD28) {
+    voltage_quanta = 3.125;
+    current_quanta = 0.2; // with 50mR shunt
+  } else if (protocol == SerialProtocol::PLD20) {
+    voltage_quanta = 4.0;
+    current_quanta = 0.06; // with 100mR shunt
+  } else {
+    return false;
+  }
+  if (size < 8 || size > 11) {
+    return false;
+  }
+  const int shunt_voltage = hex4_to_int16(line);
+  auto bus_voltage = static_cast<double>(hex4_to_uint16(line + 4));
+  // if (frame_type == OSD_MODE_20V && (bus_voltage & 0x0001)) {
+  //     std::cerr << "bad data?" << std::endl;
+  //     break;
+  // }
+
+  if (protocol == PLD20) {
+    bus_voltage /= 8.0;
+  }
+
+  const int milliamps = abs(
+      static_cast<int>(static_cast<double>(shunt_voltage) * current_quanta));
+  const int millivolts = static_cast<int>(bus_voltage * voltage_quanta);
+
+  sample.current = milliamps / 1000.0;
+  sample.voltage = millivolts / 1000.0;
+  sample.power = sample.voltage * sample.current;
+  return true;
+}
+
+bool SerialDecoder::detectProtocol(const char *line, std::size_t size,
+                                   SerialProtocol &protocol) {
+  trim(line, size);
+  if (size == 9) {
+    if (line[8] == 28) {
+      protocol = SerialProtocol::PLD28;
+      return true;
+    }
+    if (line[8] == 20) {
+      protocol = SerialProtocol::PLD20;
+      return true;
+    }
+  } else if (size == 8) {
+    protocol = SerialProtocol::PLD20;
+    return true;
+  }
+  return false;
+}
+
+const char *SerialDecoder::protocolName(SerialProtocol protocol) {
+  switch (protocol) {
+  case PLD20:
+    return "PLD20";
+  case PLD28:
+    return "PLD28";
+  case MWAKE1:
+    return "MWAKE1";
+  }
+  return "unknown";
+}
+
+bool SerialDecoder::protocolFromName(const std::string &name,
+                                     SerialProtocol &protocol) {
+  for (const SerialProtocol candidate : {PLD20, PLD28, MWAKE1}) {
+    if (name == protocolName(candidate)) {
+      protocol = candidate;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,55 @@
+#ifndef SERIALDECODER_H
+#define SERIALDECODER_H
+
+#include "PowerData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum SerialProtocol {
+  PLD20 = 1,
+  PLD28,
+  MWAKE1
+};
+
+// Turns the byte stream of a serial meter into samples. PLD20/PLD28 meters
+// send one line per measurement: four hex digits shunt voltage, four hex
+// digits bus voltage and an optional protocol byte. Bytes may arrive in any
+// split; an incomplete line is kept until the rest of it was fed.
+//
+// Used by SerialManager on live data and by the replay of raw captures, so
+// both parse exactly the same way.
+class SerialDecoder {
+public:
+  void setProtocol(SerialProtocol protocol) { m_protocol = protocol; }
+  [[nodiscard]] SerialProtocol protocol() const { return m_protocol; }
+  // Drops a partially received line
+  void reset() { m_line.clear(); }
+
+  // Appends a sample for every completed line to out, stamped with
+  // timestampMs; returns the number of samples appended
+  std::size_t feed(const char *data, std::size_t size, std::uint64_t timestampMs,
+                   std::vector<PowerData> &out);
+
+  // Lines that were complete but could not be decoded
+  [[nodiscard]] std::uint64_t badLines() const { return m_badLines; }
+
+  // One line without its line break; false if it is malformed
+  static bool decodeLine(const char *line, std::size_t size,
+                         SerialProtocol protocol, PowerData &sample);
+  // Protocol announced by a line received right after opening the port
+  static bool detectProtocol(const char *line, std::size_t size,
+                             SerialProtocol &protocol);
+
+  static const char *protocolName(SerialProtocol protocol);
+  static bool protocolFromName(const std::string &name, SerialProtocol &protocol);
+
+private:
+  SerialProtocol m_protocol = PLD28;
+  std::string m_line;
+  std::uint64_t m_badLines = 0;
+};
+
+#endif // SERIALDECODER_H
@@ -1,9 +1,9 @@
 #include "SerialManager.h"
 
-#include "OsdSettings.h"
 #include "PowerData.h"
 
 #include <QDebug>
+#include <QFileInfo>
 #include <QThread>
 #include <QElapsedTimer>
 #include <iostream>
@@ -18,31 +18,6 @@
 const quint16 SerialManager::TARGET_VENDOR_ID = 0x0483;  // STMicroelectronics
 const quint16 SerialManager::TARGET_PRODUCT_ID = 0x5740; // Virtual COM Port
 
-static int8_t hex2bin(const unsigned char c) {
-  if (c >= '0' && c <= '9') {
-    return c - '0'; // NOLINT(*-narrowing-conversions)
-  }
-  if (c >= 'A' && c <= 'F') {
-    return c - 'A' + 10; // NOLINT(*-narrowing-conversions)
-  }
-  if (c >= 'a' && c <= 'f') {
-    return c - 'a' + 10; // NOLINT(*-narrowing-conversions)
-  }
-  return 0;
-}
-
-static int16_t hex4_to_uint16(const char *buf) {
-  const int16_t val =
-      (hex2bin(buf[0]) << 12) | // NOLINT(*-narrowing-conversions)
-      (hex2bin(buf[1]) << 8) |  // NOLINT(*-narrowing-conversions)
-      (hex2bin(buf[2]) << 4) |  // NOLINT(*-narrowing-conversions)
-      hex2bin(buf[3]);
-  return val;
-}
-static int16_t hex4_to_int16(const char *buf) {
-  return static_cast<int16_t>(strtol(buf, nullptr, 16));
-}
-
 SerialManager::SerialManager(QObject *parent)
     : QObject(parent), m_serialPort(new QSerialPort(this)) {
   connect(m_serialPort, &QSerialPort::readyRead, this,
@@ -66,29 +41,39 @@ bool SerialManager::connectSerialDevice(const QSerialPortInfo &portInfo) {
   if (m_serialPort->isOpen()) {
     m_serialPort->close();
   }
-
   m_serialPort->setPort(portInfo);
+  return openAndDetect(portInfo.systemLocation());
+}
+
+bool SerialManager::connectSerialPath(const QString &path) {
+  if (m_serialPort->isOpen()) {
+    m_serialPort->close();
+  }
+  // An absolute path is opened as it is, without a lookup
+  const QString location = QFileInfo(path).absoluteFilePath();
+  m_serialPort->setPortName(location);
+  return openAndDetect(location);
+}
+
+bool SerialManager::openAndDetect(const QString &location) {
   m_serialPort->setDataBits(QSerialPort::Data8);
   m_serialPort->setParity(QSerialPort::NoParity);
   m_serialPort->setStopBits(QSerialPort::OneStop);
   m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
 
   // Try 115200 baud first
-  qDebug() << "Trying 115200 baud for serial device:" << portInfo.systemLocation()
-           << "(Name:" << portInfo.portName() << ", Null:" << portInfo.isNull() << ")";
+  qDebug() << "Trying 115200 baud for serial device:" << location;
   if (m_serialPort->open(QIODevice::ReadWrite)) {
     m_serialPort->setBaudRate(QSerialPort::Baud115200);
     if (m_serialPort->isReadable() && m_serialPort->isWritable()) {
       if (this->checkPLDProtocol()) {
-        m_isConnected = true;
-        emit deviceConnected(portInfo.systemLocation());
-        qDebug() << "Connected to serial device type " << this->m_protocol << " at 115200:" << portInfo.systemLocation();
+        startDecoding(location);
+        qDebug() << "Connected to serial device type " << this->m_protocol << " at 115200:" << location;
         return true;
       }
       if (this->checkMacwakeProtocol()) {
-        m_isConnected = true;
-        emit deviceConnected(portInfo.systemLocation());
-        qDebug() << "Connected to Macwake device at 115200:" << portInfo.systemLocation();
+        startDecoding(location);
+        qDebug() << "Connected to Macwake device at 115200:" << location;
         return true;
       }
     }
@@ -96,25 +81,37 @@ bool SerialManager::connectSerialDevice(const QSerialPortInfo &portInfo) {
   }
 
   // Try 9600 baud (fallback)
-  qDebug() << "Trying 9600 baud for serial device:" << portInfo.systemLocation()
-           << "(Name:" << portInfo.portName() << ", Null:" << portInfo.isNull() << ")";
+  qDebug() << "Trying 9600 baud for serial device:" << location;
   if (m_serialPort->open(QIODevice::ReadWrite)) {
     m_serialPort->setBaudRate(QSerialPort::Baud9600);
     if (m_serialPort->isReadable() && m_serialPort->isWritable()) {
       if (this->checkPLDProtocol()) {
-        m_isConnected = true;
-        emit deviceConnected(portInfo.systemLocation());
-        qDebug() << "Connected to serial device type " << this->m_protocol << " at 9600:" << portInfo.systemLocation();
+        startDecoding(location);
+        qDebug() << "Connected to serial device type " << this->m_protocol << " at 9600:" << location;
         return true;
       }
     }
     m_serialPort->close();
   }
 
-  qDebug() << "Failed to detect protocol on serial device:" << portInfo.systemLocation();
+  qDebug() << "Failed to detect protocol on serial device:" << location;
   return false;
 }
 
+void SerialManager::startDecoding(const QString &location) {
+  m_decoder.setProtocol(m_protocol);
+  m_decoder.reset();
+  if (m_capture) {
+    m_capture->setSource(CaptureSource::Serial, protocolName(), location);
+  }
+  m_isConnected = true;
+  emit deviceConnected(location);
+}
+
+QString SerialManager::protocolName() const {
+  return SerialDecoder::protocolName(m_protocol);
+}
+
 void SerialManager::disconnect() {
   qDebug() << "Disconnecting from serial device";
   try {
@@ -131,57 +128,27 @@ void SerialManager::onSerialDataReady() {
     return;
   }
 
-  while (m_serialPort->canReadLine()) {
-    auto line = m_serialPort->readLine();
-    if (line.endsWith('\n')) {
-      line = line.trimmed();
-    } else {
-      continue;
-    }
-    double voltage_quanta;
-    double current_quanta;
-
-    if (m_protocol == SerialProtocol::PLD28) {
-      voltage_quanta = 3.125;
-      current_quanta = 0.2; // with 50mR shunt
-    } else if (m_protocol == SerialProtocol::PLD20) {
-      voltage_quanta = 4.0;
-      current_quanta = 0.06; // with 100mR shunt
-    } else {
-      qDebug() << "Unhandled protocol " << m_protocol;
-      continue;
-    }
-    // printf("len=%d\n", static_cast<int>(strlen(serial_buffer)));
-    if (line.size() < 8 || line.size() > 11) {
-      qDebug() << "Bad packet length " << line.size();
-      continue;
-    }
-    int shunt_voltage = hex4_to_int16(line.sliced(0, 4).toStdString().c_str());
-    // printf("Shunt: %d\n", shunt_voltage);
-
-    auto bus_voltage = static_cast<double>(
-        hex4_to_uint16(line.sliced(4, 4).toStdString().c_str()));
-    // if (frame_type == OSD_MODE_20V && (bus_voltage & 0x0001)) {
-    //     std::cerr << "bad data?" << std::endl;
-    //     break;
-    // }
-
-    if (m_protocol == PLD20) {
-      bus_voltage /= 8.0;
-    }
-
-    int milliamps = abs(
-        static_cast<int>(static_cast<double>(shunt_voltage) * current_quanta));
-    int millivolts = static_cast<int>(bus_voltage * voltage_quanta);
-    // printf("Millivolts: %f\n", bus_voltage * voltage_quanta);
-
-    PowerData sample;
-    sample.current = milliamps / 1000.0;
-    sample.voltage = millivolts / 1000.0;
-    sample.power = sample.voltage * sample.current;
-    sample.timestamp = QDateTime::currentMSecsSinceEpoch();
+  const std::uint64_t readNs = PipelineLatency::nowNs();
+  const QByteArray bytes = m_serialPort->readAll();
+  // One time base for the capture and the samples, so a replayed capture
+  // reproduces the timestamps exactly
+  const quint64 timestampUs = RawCapture::timestampUs();
+  if (m_capture) {
+    m_capture->append(CaptureSource::Serial, bytes.constData(), bytes.size(),
+                      timestampUs);
+  }
 
-    emit dataReceived(sample);
+  const std::uint64_t badLines = m_decoder.badLines();
+  m_samples.clear();
+  m_decoder.feed(bytes.constData(), bytes.size(), timestampUs / 1000, m_samples);
+  if (m_decoder.badLines() != badLines) {
+    m_parseErrors.fetch_add(m_decoder.badLines() - badLines, std::memory_order_relaxed);
+    qDebug() << "Bad packet(s) for protocol" << protocolName() << ":"
+             << m_decoder.badLines() - badLines;
+  }
+  const SampleStamps stamps{readNs, PipelineLatency::nowNs()};
+  for (const auto &sample : m_samples) {
+    emit dataReceived(sample, stamps);
   }
 }
 void SerialManager::onSerialError(QSerialPort::SerialPortError error) {
@@ -209,6 +176,11 @@ bool SerialManager::tryConnect(const QString &portName) {
     }
   }
 
+  // Pseudo-terminals, such as the one of usb-power-pty-meter, and links to
+  // ports are not enumerated
+  if (targetPort.isNull() && QFileInfo::exists(portName)) {
+    return connectSerialPath(portName);
+  }
   if (targetPort.isNull()) {
     qDebug() << "SerialManager::tryConnect: Port not found in availablePorts, falling back to constructor for" << portName;
     targetPort = QSerialPortInfo(portName);
@@ -253,21 +225,7 @@ bool SerialManager::checkPLDProtocol() {
     if (line.isEmpty()) continue;
     
     linesRead++;
-    if (line.endsWith('\n')) {
-      line = line.trimmed();
-    }
-
-    if (line.length() == 9) {
-      if (line.at(8) == 28) {
-        m_protocol = SerialProtocol::PLD28;
-        return true;
-      }
-      if (line.at(8) == 20) {
-          m_protocol = SerialProtocol::PLD20;
-          return true;
-      }
-    } else if (line.length() == 8) {
-      m_protocol = SerialProtocol::PLD20;
+    if (SerialDecoder::detectProtocol(line.constData(), line.size(), m_protocol)) {
       return true;
     }
 
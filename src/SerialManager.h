@@ -1,18 +1,16 @@
 #ifndef SERIALMANAGER_H
 #define SERIALMANAGER_H
 
+#include "PipelineLatency.h"
 #include "PowerData.h"
+#include "RawCapture.h"
+#include "SerialDecoder.h"
 
 #include <QObject>
 #include <QSerialPort>
 #include <QSerialPortInfo>
 #include <QTimer>
-
-enum SerialProtocol {
-    PLD20 = 1,
-    PLD28,
-    MWAKE1
-};
+#include <atomic>
 
 class SerialManager : public QObject
 {
@@ -25,10 +23,18 @@ public:
     Q_INVOKABLE bool connectSerialDevice(const QSerialPortInfo &portInfo);
     Q_INVOKABLE void disconnect();
 
+    // Protocol detected by the last successful connect, e.g. "PLD28"
+    [[nodiscard]] QString protocolName() const;
+    // Everything read from the port is also appended to the capture while it
+    // runs; set before connecting
+    void setCapture(RawCapture *capture) { m_capture = capture; }
+    // Lines that did not decode, since construction; thread-safe
+    [[nodiscard]] quint64 parseErrors() const { return m_parseErrors.load(); }
+
 signals:
     void deviceConnected(const QString &deviceName);
     void deviceDisconnected();
-    void dataReceived(PowerData data);
+    void dataReceived(PowerData data, SampleStamps stamps);
 
 public slots:
     bool tryConnect(const QString &portName);
@@ -39,15 +45,23 @@ private slots:
     bool waitForLineAvailable(int timeoutMs);
 
   private:
+    // A port that QSerialPortInfo does not list, by its path
+    bool connectSerialPath(const QString &path);
+    // Opens the port set on m_serialPort and detects its protocol
+    bool openAndDetect(const QString &location);
     // must set m_protocol and return true on success
     bool checkPLDProtocol();
     // must set m_protocol and return true on success
     bool checkMacwakeProtocol();
+    void startDecoding(const QString &location);
 
     QSerialPort *m_serialPort;
-    QByteArray m_readBuffer;
     bool m_isConnected = false;
     SerialProtocol m_protocol;
+    SerialDecoder m_decoder;
+    std::vector<PowerData> m_samples;
+    RawCapture *m_capture = nullptr;
+    std::atomic<quint64> m_parseErrors{0};
 
     // Known VID/PID for USB Power OSD devices
     static const quint16 TARGET_VENDOR_ID;
@@ -0,0 +1,162 @@
+#include "SessionRecorder.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+namespace {
+// Samples buffered between acquisition and the writer thread; about a
+// minute at 1 kHz before anything is dropped
+constexpr std::size_t kRingCapacity = 1 << 16;
+constexpr std::size_t kChunkSamples = 4096;
+constexpr qint64 kChunkMaxAgeMs = 1000;
+constexpr int kDrainIntervalMs = 100;
+} // namespace
+
+SessionRecorder::SessionRecorder(QObject *parent)
+    : QObject(parent), m_ring(kRingCapacity), m_thread(new QThread(this)),
+      m_writerContext(new QObject), m_drainTimer(new QTimer(m_writerContext)) {
+  m_chunk.reserve(kChunkSamples);
+  m_drainTimer->setInterval(kDrainIntervalMs);
+  connect(m_drainTimer, &QTimer::timeout, m_writerContext,
+          [this] { drain(false); });
+
+  m_thread->setObjectName("recorder");
+  m_writerContext->moveToThread(m_thread);
+  m_thread->start(QThread::LowPriority);
+}
+
+SessionRecorder::~SessionRecorder() {
+  stop();
+  m_thread->quit();
+  m_thread->wait();
+  delete m_writerContext;
+}
+
+bool SessionRecorder::start(const QString &path) {
+  stop();
+  m_path = path;
+  bool opened = false;
+  QMetaObject::invokeMethod(
+      m_writerContext,
+      [this, path] {
+        // Leftovers a producer pushed while the last recording stopped
+        PowerData discard[256];
+        while (m_ring.pop(discard, 256) > 0) {
+        }
+        std::string error;
+        if (!m_writer.open(path.toStdString(), &error)) {
+          emit recordingError(QString::fromStdString(error));
+          return false;
+        }
+        m_chunk.clear();
+        m_drainTimer->start();
+        return true;
+      },
+      Qt::BlockingQueuedConnection, &opened);
+  if (opened) {
+    m_recorded = 0;
+    m_dropped = 0;
+    m_recording.store(true, std::memory_order_release);
+  }
+  return opened;
+}
+
+void SessionRecorder::stop() {
+  if (!m_recording.exchange(false)) {
+    return;
+  }
+  QMetaObject::invokeMethod(
+      m_writerContext,
+      [this] {
+        m_drainTimer->stop();
+        drain(true);
+        if (!m_writer.close()) {
+          emit recordingError("Cannot write the recording index");
+        }
+      },
+      Qt::BlockingQueuedConnection);
+  qDebug() << "Recording" << m_path << "closed," << recordedSamples()
+           << "samples," << droppedSamples() << "dropped";
+}
+
+void SessionRecorder::setSource(const QString &device,
+                                const QString &protocol) {
+  QMutexLocker locker(&m_sourceMutex);
+  m_device = device;
+  m_protocol = protocol;
+}
+
+void SessionRecorder::setCurrentDiffMa(int currentDiffMa) {
+  m_currentDiffMa.store(currentDiffMa, std::memory_order_relaxed);
+}
+
+void SessionRecorder::push(const PowerData &sample) {
+  if (!m_recording.load(std::memory_order_acquire)) {
+    return;
+  }
+  if (!m_ring.push(sample)) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+RecordingChunkHeader SessionRecorder::currentHeader() {
+  RecordingChunkHeader header;
+  {
+    QMutexLocker locker(&m_sourceMutex);
+    header.device = m_device.toStdString();
+    header.protocol = m_protocol.toStdString();
+  }
+  header.currentDiffMa = m_currentDiffMa.load(std::memory_order_relaxed);
+  return header;
+}
+
+void SessionRecorder::drain(bool final) {
+  if (!m_writer.isOpen()) {
+    return;
+  }
+  // A chunk describes its samples with one header, so a changed source or
+  // calibration starts a new chunk
+  const RecordingChunkHeader header = currentHeader();
+  if (!m_chunk.empty() && (header.device != m_chunkHeader.device ||
+                           header.protocol != m_chunkHeader.protocol ||
+                           header.currentDiffMa != m_chunkHeader.currentDiffMa)) {
+    if (!writeChunk()) {
+      return;
+    }
+  }
+
+  for (;;) {
+    if (m_chunk.empty()) {
+      m_chunkHeader = header;
+      m_chunkAge.start();
+    }
+    const std::size_t offset = m_chunk.size();
+    m_chunk.resize(kChunkSamples);
+    const std::size_t popped =
+        m_ring.pop(m_chunk.data() + offset, kChunkSamples - offset);
+    m_chunk.resize(offset + popped);
+    if (m_chunk.size() < kChunkSamples) {
+      break;
+    }
+    if (!writeChunk()) {
+      return;
+    }
+  }
+
+  if (!m_chunk.empty() && (final || m_chunkAge.elapsed() >= kChunkMaxAgeMs)) {
+    writeChunk();
+  }
+}
+
+bool SessionRecorder::writeChunk() {
+  if (!m_writer.appendChunk(m_chunkHeader, m_chunk.data(), m_chunk.size())) {
+    m_recording.store(false);
+    m_drainTimer->stop();
+    m_writer.close();
+    emit recordingError("Cannot write to " + m_path + ", recording stopped");
+    return false;
+  }
+  m_recorded.fetch_add(m_chunk.size(), std::memory_order_relaxed);
+  m_chunk.clear();
+  return true;
+}
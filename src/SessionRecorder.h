@@ -0,0 +1,81 @@
+#ifndef SESSIONRECORDER_H
+#define SESSIONRECORDER_H
+
+#include "PowerData.h"
+#include "RecordingFormat.h"
+#include "SpscRing.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <vector>
+
+// Records the acquired samples into a recording file (see RecordingFormat.h).
+// push() is called on the acquisition thread and only appends to a
+// lock-free ring; a dedicated writer thread drains the ring and writes one
+// chunk per 4096 samples or per second, whichever comes first. If the disk
+// cannot keep up the ring overflows and samples are counted as dropped -
+// acquisition is never blocked.
+class SessionRecorder : public QObject {
+  Q_OBJECT
+
+public:
+  explicit SessionRecorder(QObject *parent = nullptr);
+  ~SessionRecorder() override;
+
+  // Creates the file; false (and recordingError()) if that fails
+  bool start(const QString &path);
+  // Writes the pending samples and the index, then closes the file
+  void stop();
+  [[nodiscard]] bool isRecording() const {
+    return m_recording.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] const QString &path() const { return m_path; }
+
+  // Stored in the header of every following chunk
+  void setSource(const QString &device, const QString &protocol);
+  void setCurrentDiffMa(int currentDiffMa);
+
+  // Wait-free, for one producer at a time such as
+  // DeviceManager::sampleAcquired()
+  void push(const PowerData &sample);
+
+  [[nodiscard]] quint64 recordedSamples() const { return m_recorded.load(); }
+  [[nodiscard]] quint64 droppedSamples() const { return m_dropped.load(); }
+
+signals:
+  // Emitted on the writer thread
+  void recordingError(const QString &message);
+
+private:
+  // Writer thread only
+  void drain(bool final);
+  bool writeChunk();
+  [[nodiscard]] RecordingChunkHeader currentHeader();
+
+  SpscRing<PowerData> m_ring;
+  QThread *m_thread;
+  QObject *m_writerContext;
+  QTimer *m_drainTimer;
+  QString m_path;
+
+  std::atomic<bool> m_recording{false};
+  std::atomic<quint64> m_recorded{0};
+  std::atomic<quint64> m_dropped{0};
+
+  QMutex m_sourceMutex;
+  QString m_device;
+  QString m_protocol;
+  std::atomic<int> m_currentDiffMa{0};
+
+  // Writer thread state
+  RecordingWriter m_writer;
+  std::vector<PowerData> m_chunk;
+  RecordingChunkHeader m_chunkHeader;
+  QElapsedTimer m_chunkAge;
+};
+
+#endif // SESSIONRECORDER_H
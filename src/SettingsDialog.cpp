@@ -93,6 +93,17 @@ void SettingsDialog::setupUI() // ReSharper disable once CppDFAMemoryLeak
         this->m_settings->min_current = static_cast<float>(value) / 1000.0f;
     });
 
+    m_historySize = new QSpinBox();
+    m_historySize->setRange(100, 10000000);
+    m_historySize->setSingleStep(1000);
+    m_historySize->setSuffix(" samples");
+    m_historySize->setToolTip("Number of samples kept in the history and shown in the graph");
+    m_historySize->setValue(this->m_settings->history_size);
+    osdLayout->addRow("History size:", m_historySize);
+    connect(m_historySize, QOverload<int>::of(&QSpinBox::valueChanged), [this](int value) {
+        this->m_settings->history_size = value;
+    });
+
     layout->addWidget(osdGroup);
 
     auto *colorGroup = new QGroupBox("Colors");
@@ -168,6 +179,7 @@ void SettingsDialog::onAccepted() {
 
 void SettingsDialog::onRejected() {
     m_settings->loadSettings(); // Restore previous values
+    m_historySize->setValue(m_settings->history_size);
     onColorChanged();
     m_mainwindow->onColorChanged();
     reject();
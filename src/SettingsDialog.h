@@ -45,6 +45,7 @@ private:
   QCheckBox *m_notificationsCheck;
   MainWindow * m_mainwindow;
   QSpinBox * m_minCurrent;
+  QSpinBox * m_historySize;
   QPushButton * m_BackgroundButton;
   QPushButton * m_TextButton;
   QPushButton * m_5VButton;
@@ -0,0 +1,74 @@
+#ifndef SHAREDRINGFORMAT_H
+#define SHAREDRINGFORMAT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Layout of the POSIX shared-memory object ("/usb-power-osd" by default)
+// in which SharedRingPublisher exposes the live samples to other processes
+// on the same host. Readers map it read-only and take samples straight out
+// of the mapping, without system calls. Only this header and
+// SharedRingReader are needed for that, no Qt.
+//
+//   header (64 bytes) | record[capacity]
+//
+// The single writer stores sample n in record n % capacity, guarded by a
+// per-record seqlock: the record's sequence is odd (2n + 1) while it is
+// being written and 2n + 2 once sample n is complete. A reader that finds
+// a different value before or after copying the record retries or, if the
+// writer lapped it, skips ahead. writeIndex is the number of samples
+// published so far.
+//
+// Samples are stored as acquired; subtract currentDiffMa / 1000 from the
+// current (not below zero) to get the values the window shows. All fields
+// are in the byte order of the host.
+
+constexpr char kSharedRingMagic[8] = {'U', 'P', 'W', 'R', 'S', 'H', 'M', '\0'};
+constexpr std::uint32_t kSharedRingVersion = 1;
+constexpr const char *kSharedRingDefaultName = "/usb-power-osd";
+
+struct alignas(64) SharedRingHeader {
+  // Written last when the publisher created the object
+  std::atomic<std::uint64_t> magic;
+  std::uint32_t version;
+  std::uint32_t headerBytes;
+  std::uint32_t recordBytes;
+  // Records, a power of two
+  std::uint32_t capacity;
+  std::atomic<std::uint64_t> writeIndex;
+  // Samples per second over the last second, a double
+  std::atomic<std::uint64_t> sampleRateBits;
+  std::atomic<std::int32_t> currentDiffMa;
+  // Of the publisher; 0 once it closed the ring
+  std::atomic<std::int32_t> writerPid;
+};
+
+struct SharedRingRecord {
+  std::atomic<std::uint64_t> sequence;
+  std::atomic<std::uint64_t> timestamp; // ms since the epoch
+  // doubles: volts, amperes, watts, watt-hours
+  std::atomic<std::uint64_t> voltageBits;
+  std::atomic<std::uint64_t> currentBits;
+  std::atomic<std::uint64_t> powerBits;
+  std::atomic<std::uint64_t> energyBits;
+};
+
+static_assert(sizeof(SharedRingHeader) == 64, "shared ring header layout");
+static_assert(sizeof(SharedRingRecord) == 48, "shared ring record layout");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "the shared ring needs address-free 64-bit atomics");
+
+constexpr std::size_t sharedRingBytes(std::uint32_t capacity) {
+  return sizeof(SharedRingHeader) + std::size_t{capacity} * sizeof(SharedRingRecord);
+}
+
+constexpr std::uint64_t sharedRingMagicValue() {
+  std::uint64_t value = 0;
+  for (int i = 7; i >= 0; --i) {
+    value = (value << 8) | static_cast<unsigned char>(kSharedRingMagic[i]);
+  }
+  return value;
+}
+
+#endif // SHAREDRINGFORMAT_H
@@ -0,0 +1,145 @@
+#include "SharedRingPublisher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+std::uint64_t doubleBits(double value) {
+  std::uint64_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+void setError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+}
+} // namespace
+
+SharedRingPublisher::SharedRingPublisher(QObject *parent) : QObject(parent) {}
+
+SharedRingPublisher::~SharedRingPublisher() { close(); }
+
+#ifdef _WIN32
+bool SharedRingPublisher::open(const std::string &name, std::uint32_t,
+                               std::string *error) {
+  setError(error, "Cannot share " + name + ": shared memory rings need POSIX");
+  return false;
+}
+
+void SharedRingPublisher::close() {}
+#else
+bool SharedRingPublisher::open(const std::string &name, std::uint32_t capacity,
+                               std::string *error) {
+  close();
+  std::uint32_t records = 2;
+  while (records < capacity) {
+    records <<= 1;
+  }
+  const std::size_t bytes = sharedRingBytes(records);
+
+  // A fresh object, so readers of an earlier run keep their old mapping
+  // instead of seeing this one initialized under them
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0) {
+    setError(error, "Cannot create shared memory " + name + ": " + std::strerror(errno));
+    return false;
+  }
+  void *mapping = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+    mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  const int mapError = errno;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    setError(error, "Cannot map shared memory " + name + ": " + std::strerror(mapError));
+    return false;
+  }
+
+  // The object is zero-filled, so every record's sequence is 0 and reads
+  // as "not written yet"
+  m_header = static_cast<SharedRingHeader *>(mapping);
+  m_records = reinterpret_cast<SharedRingRecord *>(static_cast<char *>(mapping) +
+                                                   sizeof(SharedRingHeader));
+  m_header->version = kSharedRingVersion;
+  m_header->headerBytes = sizeof(SharedRingHeader);
+  m_header->recordBytes = sizeof(SharedRingRecord);
+  m_header->capacity = records;
+  m_header->writeIndex.store(0, std::memory_order_relaxed);
+  m_header->sampleRateBits.store(doubleBits(0.0), std::memory_order_relaxed);
+  m_header->currentDiffMa.store(m_currentDiffMa.load(), std::memory_order_relaxed);
+  m_header->writerPid.store(static_cast<std::int32_t>(getpid()), std::memory_order_relaxed);
+  m_header->magic.store(sharedRingMagicValue(), std::memory_order_release);
+
+  m_mappedBytes = bytes;
+  m_mask = records - 1;
+  m_name = name;
+  m_sampleRate.reset();
+  m_active.store(true, std::memory_order_seq_cst);
+  return true;
+}
+
+void SharedRingPublisher::close() {
+  if (!m_active.exchange(false, std::memory_order_seq_cst)) {
+    return;
+  }
+  // A publish() that saw the ring active finishes before it is unmapped
+  while (m_publishing.load(std::memory_order_seq_cst)) {
+    std::this_thread::yield();
+  }
+  m_header->writerPid.store(0, std::memory_order_release);
+  munmap(m_header, m_mappedBytes);
+  shm_unlink(m_name.c_str());
+  m_header = nullptr;
+  m_records = nullptr;
+}
+#endif
+
+void SharedRingPublisher::setCurrentDiffMa(int currentDiffMa) {
+  m_currentDiffMa.store(currentDiffMa, std::memory_order_relaxed);
+}
+
+void SharedRingPublisher::publish(const PowerData &sample) {
+  // writeIndex and the rate window are claimed by plain loads and stores,
+  // so a second producer overlapping the first drops its sample rather than
+  // writing the same record. DeviceManager::sampleAcquired() never overlaps.
+  if (m_publishing.exchange(true, std::memory_order_seq_cst)) {
+    return;
+  }
+  if (!m_active.load(std::memory_order_seq_cst)) {
+    m_publishing.store(false, std::memory_order_release);
+    return;
+  }
+
+  const std::uint64_t index = m_header->writeIndex.load(std::memory_order_relaxed);
+  SharedRingRecord &record = m_records[index & m_mask];
+  record.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  record.timestamp.store(sample.timestamp, std::memory_order_relaxed);
+  record.voltageBits.store(doubleBits(sample.voltage), std::memory_order_relaxed);
+  record.currentBits.store(doubleBits(sample.current), std::memory_order_relaxed);
+  record.powerBits.store(doubleBits(sample.power), std::memory_order_relaxed);
+  record.energyBits.store(doubleBits(sample.energy), std::memory_order_relaxed);
+  record.sequence.store(2 * index + 2, std::memory_order_release);
+  m_header->writeIndex.store(index + 1, std::memory_order_release);
+  // Only publish() writes the mapping, so this is copied over here
+  m_header->currentDiffMa.store(m_currentDiffMa.load(std::memory_order_relaxed),
+                                std::memory_order_relaxed);
+
+  const double rate = m_sampleRate.add(sample.timestamp);
+  if (rate >= 0.0) {
+    m_header->sampleRateBits.store(doubleBits(rate), std::memory_order_relaxed);
+  }
+  m_publishing.store(false, std::memory_order_release);
+}
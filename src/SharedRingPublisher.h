@@ -0,0 +1,55 @@
+#ifndef SHAREDRINGPUBLISHER_H
+#define SHAREDRINGPUBLISHER_H
+
+#include "PowerData.h"
+#include "SampleRateWindow.h"
+#include "SharedRingFormat.h"
+
+#include <QObject>
+#include <atomic>
+#include <string>
+
+// Writes the acquired samples into a POSIX shared-memory ring (see
+// SharedRingFormat.h) that other processes read without system calls.
+// publish() is called on the acquisition thread and stores the sample
+// straight into the mapping - no queue, no thread, and a slow reader only
+// ever loses samples it did not read in time. Not available on Windows.
+class SharedRingPublisher : public QObject {
+public:
+  explicit SharedRingPublisher(QObject *parent = nullptr);
+  ~SharedRingPublisher() override;
+
+  // Creates the shared-memory object, replacing one left by an earlier
+  // run, with room for capacity samples (rounded up to a power of two)
+  bool open(const std::string &name, std::uint32_t capacity,
+            std::string *error = nullptr);
+  // Marks the ring closed for readers and removes the object; waits for a
+  // publish() in progress
+  void close();
+  [[nodiscard]] bool isOpen() const {
+    return m_active.load(std::memory_order_relaxed);
+  }
+
+  void setCurrentDiffMa(int currentDiffMa);
+
+  // Wait-free, for one producer at a time; a call overlapping another one
+  // is dropped
+  void publish(const PowerData &sample);
+
+private:
+  SharedRingHeader *m_header = nullptr;
+  SharedRingRecord *m_records = nullptr;
+  std::size_t m_mappedBytes = 0;
+  std::uint64_t m_mask = 0;
+  std::string m_name;
+  // close() waits for a publisher that saw m_active set to leave; a
+  // publish() in progress also keeps out an overlapping one
+  std::atomic<bool> m_active{false};
+  std::atomic<bool> m_publishing{false};
+  std::atomic<int> m_currentDiffMa{0};
+
+  // Only touched while m_publishing is held
+  SampleRateWindow m_sampleRate;
+};
+
+#endif // SHAREDRINGPUBLISHER_H
@@ -0,0 +1,192 @@
+#include "SharedRingReader.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+double bitsDouble(std::uint64_t bits) {
+  double value = 0.0;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void setError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+}
+} // namespace
+
+SharedRingReader::~SharedRingReader() { close(); }
+
+#ifdef _WIN32
+bool SharedRingReader::open(const std::string &name, std::string *error) {
+  setError(error, "Cannot open " + name + ": shared memory rings need POSIX");
+  return false;
+}
+
+void SharedRingReader::close() {}
+#else
+bool SharedRingReader::open(const std::string &name, std::string *error) {
+  close();
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    setError(error, "Cannot open shared memory " + name + ": " + std::strerror(errno));
+    return false;
+  }
+  struct stat status {};
+  if (fstat(fd, &status) != 0 ||
+      static_cast<std::size_t>(status.st_size) < sizeof(SharedRingHeader)) {
+    ::close(fd);
+    setError(error, name + " is not a sample ring");
+    return false;
+  }
+  const auto bytes = static_cast<std::size_t>(status.st_size);
+  void *mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    setError(error, "Cannot map shared memory " + name + ": " + std::strerror(errno));
+    return false;
+  }
+
+  const auto *header = static_cast<const SharedRingHeader *>(mapping);
+  const char *problem = nullptr;
+  if (header->magic.load(std::memory_order_acquire) != sharedRingMagicValue()) {
+    problem = " is not a sample ring";
+  } else if (header->version > kSharedRingVersion) {
+    problem = " was created by a newer version";
+  } else if (header->headerBytes != sizeof(SharedRingHeader) ||
+             header->recordBytes != sizeof(SharedRingRecord) ||
+             header->capacity == 0 ||
+             (header->capacity & (header->capacity - 1)) != 0 ||
+             sharedRingBytes(header->capacity) > bytes) {
+    problem = " has an unexpected layout";
+  }
+  if (problem) {
+    munmap(mapping, bytes);
+    setError(error, name + problem);
+    return false;
+  }
+
+  m_header = header;
+  m_records = reinterpret_cast<const SharedRingRecord *>(
+      static_cast<const char *>(mapping) + sizeof(SharedRingHeader));
+  m_mappedBytes = bytes;
+  m_capacity = header->capacity;
+  m_lost = 0;
+  skipToNewest();
+  return true;
+}
+
+void SharedRingReader::close() {
+  if (m_header) {
+    munmap(const_cast<SharedRingHeader *>(m_header), m_mappedBytes);
+  }
+  m_header = nullptr;
+  m_records = nullptr;
+  m_mappedBytes = 0;
+  m_capacity = 0;
+}
+#endif
+
+SharedRingReader::RecordState SharedRingReader::readRecord(std::uint64_t index,
+                                                           SharedSample &sample) const {
+  const SharedRingRecord &record = m_records[index & (m_capacity - 1)];
+  const std::uint64_t expected = 2 * index + 2;
+  const std::uint64_t before = record.sequence.load(std::memory_order_acquire);
+  if (before != expected) {
+    return before < expected ? RecordState::NotYet : RecordState::Overwritten;
+  }
+  sample.timestamp = record.timestamp.load(std::memory_order_relaxed);
+  sample.voltage = bitsDouble(record.voltageBits.load(std::memory_order_relaxed));
+  sample.current = bitsDouble(record.currentBits.load(std::memory_order_relaxed));
+  sample.power = bitsDouble(record.powerBits.load(std::memory_order_relaxed));
+  sample.energy = bitsDouble(record.energyBits.load(std::memory_order_relaxed));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  // The writer started on this slot again while it was copied
+  if (record.sequence.load(std::memory_order_relaxed) != expected) {
+    return RecordState::Overwritten;
+  }
+  return RecordState::Ok;
+}
+
+std::size_t SharedRingReader::read(SharedSample *out, std::size_t maxSamples) {
+  if (!m_header) {
+    return 0;
+  }
+  std::size_t count = 0;
+  std::uint64_t written = writeIndex();
+  while (count < maxSamples && m_next < written) {
+    if (written - m_next > m_capacity) {
+      m_lost += written - m_capacity - m_next;
+      m_next = written - m_capacity;
+    }
+    switch (readRecord(m_next, out[count])) {
+    case RecordState::Ok:
+      ++count;
+      ++m_next;
+      break;
+    case RecordState::NotYet:
+      // Not with a single writer, which moves writeIndex only once the
+      // record is complete
+      return count;
+    case RecordState::Overwritten:
+      // Lapped while reading; the check above skips to the oldest sample
+      // that is still there
+      written = writeIndex();
+      if (written - m_next <= m_capacity) {
+        ++m_lost;
+        ++m_next;
+      }
+      break;
+    }
+  }
+  return count;
+}
+
+bool SharedRingReader::latest(SharedSample &sample) const {
+  if (!m_header) {
+    return false;
+  }
+  for (;;) {
+    const std::uint64_t written = writeIndex();
+    if (written == 0) {
+      return false;
+    }
+    const RecordState state = readRecord(written - 1, sample);
+    if (state != RecordState::Overwritten) {
+      return state == RecordState::Ok;
+    }
+  }
+}
+
+void SharedRingReader::rewindToOldest() {
+  const std::uint64_t written = writeIndex();
+  m_next = written > m_capacity ? written - m_capacity : 0;
+}
+
+void SharedRingReader::skipToNewest() { m_next = writeIndex(); }
+
+std::uint64_t SharedRingReader::writeIndex() const {
+  return m_header ? m_header->writeIndex.load(std::memory_order_acquire) : 0;
+}
+
+double SharedRingReader::sampleRate() const {
+  return m_header ? bitsDouble(m_header->sampleRateBits.load(std::memory_order_relaxed))
+                  : 0.0;
+}
+
+int SharedRingReader::currentDiffMa() const {
+  return m_header ? m_header->currentDiffMa.load(std::memory_order_relaxed) : 0;
+}
+
+bool SharedRingReader::writerAlive() const {
+  return m_header && m_header->writerPid.load(std::memory_order_acquire) != 0;
+}
@@ -0,0 +1,70 @@
+#ifndef SHAREDRINGREADER_H
+#define SHAREDRINGREADER_H
+
+#include "SharedRingFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// One sample as stored in the shared ring, i.e. as acquired
+struct SharedSample {
+  std::uint64_t timestamp = 0; // ms since the epoch
+  double voltage = 0.0;
+  double current = 0.0;
+  double power = 0.0;
+  double energy = 0.0;
+};
+
+// Reads the samples SharedRingPublisher exposes in shared memory, from any
+// process on the same host. Plain C++ without Qt: link usbpower-shm-reader
+// and include this header. After open() no call makes a system call;
+// read() copies the records out of the mapping and never blocks the
+// writer. A reader that falls more than the ring capacity behind loses
+// the oldest samples and can see how many in lost().
+class SharedRingReader {
+public:
+  SharedRingReader() = default;
+  ~SharedRingReader();
+  SharedRingReader(const SharedRingReader &) = delete;
+  SharedRingReader &operator=(const SharedRingReader &) = delete;
+
+  // Maps the ring read-only and positions after the newest sample
+  bool open(const std::string &name = kSharedRingDefaultName,
+            std::string *error = nullptr);
+  void close();
+  [[nodiscard]] bool isOpen() const { return m_header != nullptr; }
+
+  // Copies up to maxSamples samples not read yet into out, oldest first;
+  // 0 if there are none
+  std::size_t read(SharedSample *out, std::size_t maxSamples);
+  // The newest sample without moving the read position; false if the ring
+  // is still empty
+  bool latest(SharedSample &sample) const;
+  // Continue with the oldest sample still in the ring, or after the newest
+  void rewindToOldest();
+  void skipToNewest();
+
+  [[nodiscard]] std::uint64_t writeIndex() const;
+  [[nodiscard]] std::uint32_t capacity() const { return m_capacity; }
+  [[nodiscard]] double sampleRate() const;
+  [[nodiscard]] int currentDiffMa() const;
+  // False once the publisher closed the ring; open() again to follow a
+  // restarted one
+  [[nodiscard]] bool writerAlive() const;
+  // Samples overwritten before this reader got to them
+  [[nodiscard]] std::uint64_t lost() const { return m_lost; }
+
+private:
+  enum class RecordState { Ok, NotYet, Overwritten };
+  RecordState readRecord(std::uint64_t index, SharedSample &sample) const;
+
+  const SharedRingHeader *m_header = nullptr;
+  const SharedRingRecord *m_records = nullptr;
+  std::size_t m_mappedBytes = 0;
+  std::uint32_t m_capacity = 0;
+  std::uint64_t m_next = 0;
+  std::uint64_t m_lost = 0;
+};
+
+#endif // SHAREDRINGREADER_H
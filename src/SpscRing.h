@@ -0,0 +1,93 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free single-producer/single-consumer queue.
+// push() never blocks or allocates; when the consumer falls behind the ring
+// fills up and push() fails, so the producer (an acquisition thread) can
+// count the loss and carry on. The producer may change threads as long as
+// two threads never push concurrently, e.g. because the pushes are
+// serialized by a mutex; likewise for the consumer.
+template <typename T> class SpscRing {
+public:
+  // capacity is rounded up to a power of two
+  explicit SpscRing(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    m_items.resize(size);
+    m_mask = size - 1;
+  }
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  [[nodiscard]] std::size_t capacity() const { return m_items.size(); }
+
+  bool push(const T &item) {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tailCache >= m_items.size()) {
+      m_tailCache = m_tail.load(std::memory_order_acquire);
+      if (head - m_tailCache >= m_items.size()) {
+        return false;
+      }
+    }
+    m_items[head & m_mask] = item;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Pushes all count items or none of them, so the consumer never sees a
+  // batch in part
+  bool push(const T *items, std::size_t count) {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (head + count - m_tailCache > m_items.size()) {
+      m_tailCache = m_tail.load(std::memory_order_acquire);
+      if (head + count - m_tailCache > m_items.size()) {
+        return false;
+      }
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      m_items[(head + i) & m_mask] = items[i];
+    }
+    m_head.store(head + count, std::memory_order_release);
+    return true;
+  }
+
+  // Moves up to maxItems into out, returns how many
+  std::size_t pop(T *out, std::size_t maxItems) {
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    const std::size_t head = m_head.load(std::memory_order_acquire);
+    std::size_t count = head - tail;
+    if (count > maxItems) {
+      count = maxItems;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      out[i] = m_items[(tail + i) & m_mask];
+    }
+    m_tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  [[nodiscard]] bool empty() const {
+    return m_head.load(std::memory_order_acquire) ==
+           m_tail.load(std::memory_order_acquire);
+  }
+
+private:
+  static constexpr std::size_t kCacheLine = 64;
+
+  std::vector<T> m_items;
+  std::size_t m_mask = 0;
+  // Producer side
+  alignas(kCacheLine) std::atomic<std::size_t> m_head{0};
+  std::size_t m_tailCache = 0;
+  // Consumer side
+  alignas(kCacheLine) std::atomic<std::size_t> m_tail{0};
+};
+
+#endif // SPSCRING_H
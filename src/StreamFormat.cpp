@@ -0,0 +1,133 @@
+#include "StreamFormat.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr std::int64_t kPowersOfTen[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+void putU16(char *p, std::uint16_t v) {
+  p[0] = static_cast<char>(v);
+  p[1] = static_cast<char>(v >> 8);
+}
+void putU32(char *p, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<char>(v >> (8 * i));
+  }
+}
+void putU64(char *p, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i) {
+    p[i] = static_cast<char>(v >> (8 * i));
+  }
+}
+void putF32(char *p, double v) {
+  const float f = static_cast<float>(v);
+  std::uint32_t bits = 0;
+  std::memcpy(&bits, &f, sizeof(bits));
+  putU32(p, bits);
+}
+void putF64(char *p, double v) {
+  std::uint64_t bits = 0;
+  std::memcpy(&bits, &v, sizeof(bits));
+  putU64(p, bits);
+}
+
+char *frameHeader(std::string &out, StreamFrameType type, std::size_t payloadBytes) {
+  const std::size_t offset = out.size();
+  out.resize(offset + kStreamFrameHeaderBytes + payloadBytes);
+  char *p = &out[offset];
+  putU32(p, static_cast<std::uint32_t>(payloadBytes));
+  p[4] = static_cast<char>(type);
+  p[5] = static_cast<char>(kStreamVersion);
+  putU16(p + 6, 0);
+  return p + kStreamFrameHeaderBytes;
+}
+
+char *appendUnsigned(char *p, std::uint64_t v) {
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = static_cast<char>('0' + v % 10);
+    v /= 10;
+  } while (v > 0);
+  while (n > 0) {
+    *p++ = digits[--n];
+  }
+  return p;
+}
+
+// Fixed-point by hand: printf follows the locale, which QCoreApplication
+// sets from the environment, and JSON needs a decimal point
+char *appendFixed(char *p, double v, int decimals) {
+  const double scaled = std::round(v * static_cast<double>(kPowersOfTen[decimals]));
+  if (!std::isfinite(scaled) || std::fabs(scaled) > 9e15) {
+    std::memcpy(p, "null", 4);
+    return p + 4;
+  }
+  auto units = static_cast<std::int64_t>(scaled);
+  if (units < 0) {
+    *p++ = '-';
+    units = -units;
+  }
+  p = appendUnsigned(p, static_cast<std::uint64_t>(units / kPowersOfTen[decimals]));
+  *p++ = '.';
+  std::int64_t fraction = units % kPowersOfTen[decimals];
+  for (int i = decimals - 1; i >= 0; --i) {
+    p[i] = static_cast<char>('0' + fraction % 10);
+    fraction /= 10;
+  }
+  return p + decimals;
+}
+
+char *appendLiteral(char *p, const char *literal) {
+  const std::size_t length = std::strlen(literal);
+  std::memcpy(p, literal, length);
+  return p + length;
+}
+} // namespace
+
+void appendStreamSamples(std::string &out, StreamEncoding encoding,
+                         const PowerData *samples, std::size_t count) {
+  if (encoding == StreamEncoding::Binary) {
+    char *p = frameHeader(out, StreamFrameType::Samples, 4 + count * kStreamSampleBytes);
+    putU32(p, static_cast<std::uint32_t>(count));
+    p += 4;
+    for (std::size_t i = 0; i < count; ++i, p += kStreamSampleBytes) {
+      putU64(p, samples[i].timestamp);
+      putF32(p + 8, samples[i].voltage);
+      putF32(p + 12, samples[i].current);
+      putF32(p + 16, samples[i].power);
+      putF64(p + 20, samples[i].energy);
+    }
+    return;
+  }
+
+  // Longest line: five fields of at most 24 characters plus the names
+  constexpr std::size_t kMaxLineBytes = 160;
+  std::size_t offset = out.size();
+  out.resize(offset + count * kMaxLineBytes);
+  for (std::size_t i = 0; i < count; ++i) {
+    char *const line = &out[offset];
+    char *p = appendLiteral(line, "{\"t\":");
+    p = appendUnsigned(p, samples[i].timestamp);
+    p = appendFixed(appendLiteral(p, ",\"v\":"), samples[i].voltage, 4);
+    p = appendFixed(appendLiteral(p, ",\"i\":"), samples[i].current, 4);
+    p = appendFixed(appendLiteral(p, ",\"p\":"), samples[i].power, 4);
+    p = appendFixed(appendLiteral(p, ",\"e\":"), samples[i].energy, 6);
+    p = appendLiteral(p, "}\n");
+    offset += static_cast<std::size_t>(p - line);
+  }
+  out.resize(offset);
+}
+
+void appendStreamDropped(std::string &out, StreamEncoding encoding,
+                         std::uint64_t count) {
+  if (encoding == StreamEncoding::Binary) {
+    putU64(frameHeader(out, StreamFrameType::Dropped, 8), count);
+    return;
+  }
+  char line[40];
+  char *p = appendUnsigned(appendLiteral(line, "{\"dropped\":"), count);
+  p = appendLiteral(p, "}\n");
+  out.append(line, static_cast<std::size_t>(p - line));
+}
@@ -0,0 +1,47 @@
+#ifndef STREAMFORMAT_H
+#define STREAMFORMAT_H
+
+#include "PowerData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Live sample stream of the StreamServer, in one of two encodings chosen
+// by the address a subscriber connected to.
+//
+// Binary: a sequence of frames, each an 8-byte header - u32 payload length,
+// u8 frame type, u8 version, u16 reserved - followed by the payload.
+//
+//   Samples (type 1): u32 count, then count times 28 bytes: u64 timestamp
+//                     in ms since the epoch, f32 volts, f32 amperes,
+//                     f32 watts, f64 watt-hours
+//   Dropped (type 2): u64 samples this subscriber lost because it did not
+//                     read fast enough; sent before the next samples
+//
+// All integers and floats are little-endian.
+//
+// JSON: one object per line, {"t":<ms>,"v":<V>,"i":<A>,"p":<W>,"e":<Wh>}
+// per sample and {"dropped":<count>} for lost samples.
+
+enum class StreamEncoding {
+  Binary,
+  Json,
+};
+
+enum class StreamFrameType : std::uint8_t {
+  Samples = 1,
+  Dropped = 2,
+};
+
+constexpr std::uint8_t kStreamVersion = 1;
+constexpr std::size_t kStreamFrameHeaderBytes = 8;
+constexpr std::size_t kStreamSampleBytes = 28;
+
+// Appends one Samples frame, or one line per sample
+void appendStreamSamples(std::string &out, StreamEncoding encoding,
+                         const PowerData *samples, std::size_t count);
+void appendStreamDropped(std::string &out, StreamEncoding encoding,
+                         std::uint64_t count);
+
+#endif // STREAMFORMAT_H
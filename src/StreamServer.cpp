@@ -0,0 +1,263 @@
+#include "StreamServer.h"
+
+#include "NetworkAddress.h"
+
+#include <QDebug>
+#include <QHostAddress>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <algorithm>
+
+namespace {
+// Room between acquisition and the server thread for about a minute at
+// 1 kHz
+constexpr std::size_t kRingCapacity = 1 << 16;
+constexpr std::size_t kBatchSamples = 4096;
+constexpr int kDrainIntervalMs = 20;
+// Per subscriber: what may wait for it before its oldest batches are
+// dropped (about 16 s at 1 kHz), and how much is handed to its socket at
+// once
+constexpr std::size_t kQueueSamples = 1 << 14;
+constexpr qint64 kSocketHighWaterBytes = 64 * 1024;
+} // namespace
+
+StreamServer::StreamServer(QObject *parent)
+    : QObject(parent), m_ring(kRingCapacity), m_thread(new QThread(this)),
+      m_serverContext(new QObject), m_drainTimer(new QTimer(m_serverContext)) {
+  m_batch.resize(kBatchSamples);
+  m_drainTimer->setInterval(kDrainIntervalMs);
+  connect(m_drainTimer, &QTimer::timeout, m_serverContext, [this] { drain(); });
+
+  m_thread->setObjectName("stream");
+  m_serverContext->moveToThread(m_thread);
+  m_thread->start();
+}
+
+StreamServer::~StreamServer() {
+  close();
+  m_thread->quit();
+  m_thread->wait();
+  delete m_serverContext;
+}
+
+bool StreamServer::listen(const QString &address, QString *error) {
+  bool bound = false;
+  QString message;
+  QMetaObject::invokeMethod(
+      m_serverContext, [this, address, &message] { return bind(address, &message); },
+      Qt::BlockingQueuedConnection, &bound);
+  if (!bound) {
+    if (error) {
+      *error = message;
+    }
+    return false;
+  }
+  qDebug() << "Streaming samples on" << address;
+  m_listening.store(true, std::memory_order_release);
+  return true;
+}
+
+void StreamServer::close() {
+  if (!m_listening.exchange(false)) {
+    return;
+  }
+  QMetaObject::invokeMethod(
+      m_serverContext,
+      [this] {
+        m_drainTimer->stop();
+        // Deleting a connected socket emits disconnected(), so the list is
+        // emptied first
+        const auto subscribers = std::move(m_subscribers);
+        m_subscribers.clear();
+        m_subscriberCount.store(0);
+        for (const auto &subscriber : subscribers) {
+          delete subscriber->socket;
+        }
+        qDeleteAll(m_servers);
+        m_servers.clear();
+        // Samples pushed during the shutdown are not for the subscribers
+        // of the next listen()
+        while (m_ring.pop(m_batch.data(), m_batch.size()) > 0) {
+        }
+      },
+      Qt::BlockingQueuedConnection);
+}
+
+void StreamServer::setCurrentDiffMa(int currentDiffMa) {
+  m_currentDiffMa.store(currentDiffMa, std::memory_order_relaxed);
+}
+
+void StreamServer::publish(const PowerData &sample) {
+  if (!m_listening.load(std::memory_order_acquire)) {
+    return;
+  }
+  // The server thread fell a minute behind; nothing sensible left to do
+  if (!m_ring.push(sample)) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool StreamServer::bind(const QString &address, QString *error) {
+  const int colon = address.indexOf(':');
+  QString scheme = address.left(colon);
+  const QString location = address.mid(colon + 1);
+  StreamEncoding encoding = StreamEncoding::Binary;
+  if (scheme.endsWith("+json")) {
+    encoding = StreamEncoding::Json;
+    scheme.chop(5);
+  }
+
+  if (colon > 0 && scheme == "unix" && !location.isEmpty()) {
+    auto *server = new QLocalServer(m_serverContext);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    // listen() fails on an existing path, such as one a previous run did
+    // not get to remove
+    QLocalServer::removeServer(location);
+    if (!server->listen(location)) {
+      *error = "Cannot listen on " + address + ": " + server->errorString();
+      delete server;
+      return false;
+    }
+    connect(server, &QLocalServer::newConnection, m_serverContext, [this, server, encoding] {
+      while (QLocalSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, m_serverContext,
+                [this, socket] { removeSubscriber(socket); }, Qt::QueuedConnection);
+        addSubscriber(socket, encoding);
+      }
+    });
+    m_servers.push_back(server);
+  } else if (colon > 0 && scheme == "tcp") {
+    QHostAddress hostAddress;
+    quint16 port = 0;
+    if (!parseHostPort(location, hostAddress, port)) {
+      *error = "Invalid stream address " + address;
+      return false;
+    }
+    auto *server = new QTcpServer(m_serverContext);
+    if (!server->listen(hostAddress, port)) {
+      *error = "Cannot listen on " + address + ": " + server->errorString();
+      delete server;
+      return false;
+    }
+    connect(server, &QTcpServer::newConnection, m_serverContext, [this, server, encoding] {
+      while (QTcpSocket *socket = server->nextPendingConnection()) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::disconnected, m_serverContext,
+                [this, socket] { removeSubscriber(socket); }, Qt::QueuedConnection);
+        addSubscriber(socket, encoding);
+      }
+    });
+    m_servers.push_back(server);
+  } else {
+    *error = "Invalid stream address " + address +
+             ", expected unix:<path> or tcp:[<host>:]<port>";
+    return false;
+  }
+  m_drainTimer->start();
+  return true;
+}
+
+void StreamServer::addSubscriber(QIODevice *socket, StreamEncoding encoding) {
+  auto subscriber = std::make_unique<Subscriber>();
+  subscriber->socket = socket;
+  subscriber->encoding = encoding;
+  // Subscribers only listen; whatever they send is discarded
+  connect(socket, &QIODevice::readyRead, m_serverContext, [socket] { socket->readAll(); });
+  connect(socket, &QIODevice::bytesWritten, m_serverContext, [this, socket] {
+    if (Subscriber *found = findSubscriber(socket)) {
+      flush(*found);
+    }
+  });
+  m_subscribers.push_back(std::move(subscriber));
+  m_subscriberCount.store(static_cast<int>(m_subscribers.size()));
+}
+
+void StreamServer::removeSubscriber(QIODevice *socket) {
+  const auto it = std::find_if(m_subscribers.begin(), m_subscribers.end(),
+                               [socket](const auto &s) { return s->socket == socket; });
+  if (it == m_subscribers.end()) {
+    return;
+  }
+  m_subscribers.erase(it);
+  m_subscriberCount.store(static_cast<int>(m_subscribers.size()));
+  socket->deleteLater();
+}
+
+StreamServer::Subscriber *StreamServer::findSubscriber(QIODevice *socket) {
+  for (const auto &subscriber : m_subscribers) {
+    if (subscriber->socket == socket) {
+      return subscriber.get();
+    }
+  }
+  return nullptr;
+}
+
+void StreamServer::drain() {
+  const double currentDiff = m_currentDiffMa.load(std::memory_order_relaxed) / 1000.0;
+  for (;;) {
+    const std::size_t count = m_ring.pop(m_batch.data(), m_batch.size());
+    if (count == 0) {
+      return;
+    }
+    m_published.fetch_add(count, std::memory_order_relaxed);
+    if (m_subscribers.empty()) {
+      continue;
+    }
+    if (currentDiff != 0.0) {
+      for (std::size_t i = 0; i < count; ++i) {
+        m_batch[i].current = std::max(0.0, m_batch[i].current - currentDiff);
+      }
+    }
+
+    // Encoded once per encoding in use; the subscribers share the buffer
+    Batch encoded[2];
+    for (const auto &subscriber : m_subscribers) {
+      Batch &batch = encoded[static_cast<int>(subscriber->encoding)];
+      if (batch.samples == 0) {
+        m_encoded.clear();
+        appendStreamSamples(m_encoded, subscriber->encoding, m_batch.data(), count);
+        batch.bytes = QByteArray(m_encoded.data(), static_cast<qsizetype>(m_encoded.size()));
+        batch.samples = count;
+      }
+      enqueue(*subscriber, batch);
+    }
+    for (const auto &subscriber : m_subscribers) {
+      flush(*subscriber);
+    }
+    if (count < m_batch.size()) {
+      return;
+    }
+  }
+}
+
+void StreamServer::enqueue(Subscriber &subscriber, const Batch &batch) {
+  while (!subscriber.queue.empty() &&
+         subscriber.queuedSamples + batch.samples > kQueueSamples) {
+    const std::size_t oldest = subscriber.queue.front().samples;
+    subscriber.queue.pop_front();
+    subscriber.queuedSamples -= oldest;
+    subscriber.dropped += oldest;
+    m_dropped.fetch_add(oldest, std::memory_order_relaxed);
+  }
+  subscriber.queue.push_back(batch);
+  subscriber.queuedSamples += batch.samples;
+}
+
+void StreamServer::flush(Subscriber &subscriber) {
+  // Whole batches only, so whatever is dropped later is a whole frame
+  while (!subscriber.queue.empty() &&
+         subscriber.socket->bytesToWrite() < kSocketHighWaterBytes) {
+    if (subscriber.dropped > 0) {
+      std::string notice;
+      appendStreamDropped(notice, subscriber.encoding, subscriber.dropped);
+      subscriber.socket->write(notice.data(), static_cast<qint64>(notice.size()));
+      subscriber.dropped = 0;
+    }
+    const Batch &batch = subscriber.queue.front();
+    subscriber.socket->write(batch.bytes);
+    subscriber.queuedSamples -= batch.samples;
+    subscriber.queue.pop_front();
+  }
+}
@@ -0,0 +1,98 @@
+#ifndef STREAMSERVER_H
+#define STREAMSERVER_H
+
+#include "PowerData.h"
+#include "SpscRing.h"
+#include "StreamFormat.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Publishes the acquired samples to local subscribers, e.g. dashboards and
+// test scripts, over Unix domain sockets or TCP (see StreamFormat.h for the
+// encodings). publish() is called on whichever thread acquired the sample
+// and only appends to a single-producer ring; a dedicated server thread
+// drains it every 20 ms, encodes the batch once per encoding and hands the
+// same buffer to every subscriber. Each subscriber has a bounded queue: one
+// that does not read fast enough loses its oldest batches, reported in the
+// stream, while acquisition and the other subscribers carry on.
+class StreamServer : public QObject {
+  Q_OBJECT
+
+public:
+  explicit StreamServer(QObject *parent = nullptr);
+  ~StreamServer() override;
+
+  // Accepts subscribers on "unix:<path>", "tcp:<port>" (localhost only) or
+  // "tcp:<host>:<port>" in the binary encoding, or with the scheme
+  // "unix+json"/"tcp+json" as JSON lines. May be called for several
+  // addresses; false with a message in error if one cannot be bound.
+  bool listen(const QString &address, QString *error = nullptr);
+  // Disconnects all subscribers and stops listening
+  void close();
+  [[nodiscard]] bool isListening() const {
+    return m_listening.load(std::memory_order_relaxed);
+  }
+
+  // Subtracted from the current like in the window's history
+  void setCurrentDiffMa(int currentDiffMa);
+
+  // Wait-free. Calls must not overlap: the serial, BLE and replay sources
+  // take turns, which DeviceManager::sampleAcquired() guarantees.
+  void publish(const PowerData &sample);
+
+  [[nodiscard]] int subscriberCount() const { return m_subscriberCount.load(); }
+  [[nodiscard]] quint64 publishedSamples() const { return m_published.load(); }
+  // Samples lost by slow subscribers, summed over all of them
+  [[nodiscard]] quint64 droppedSamples() const { return m_dropped.load(); }
+
+private:
+  struct Batch {
+    QByteArray bytes;
+    std::size_t samples = 0;
+  };
+  struct Subscriber {
+    QIODevice *socket = nullptr;
+    StreamEncoding encoding = StreamEncoding::Binary;
+    std::deque<Batch> queue;
+    std::size_t queuedSamples = 0;
+    // Not reported to the subscriber yet
+    quint64 dropped = 0;
+  };
+
+  // Server thread only
+  bool bind(const QString &address, QString *error);
+  void addSubscriber(QIODevice *socket, StreamEncoding encoding);
+  void removeSubscriber(QIODevice *socket);
+  Subscriber *findSubscriber(QIODevice *socket);
+  void drain();
+  void enqueue(Subscriber &subscriber, const Batch &batch);
+  void flush(Subscriber &subscriber);
+
+  SpscRing<PowerData> m_ring;
+  QThread *m_thread;
+  QObject *m_serverContext;
+  QTimer *m_drainTimer;
+
+  std::atomic<bool> m_listening{false};
+  std::atomic<int> m_currentDiffMa{0};
+  std::atomic<int> m_subscriberCount{0};
+  std::atomic<quint64> m_published{0};
+  std::atomic<quint64> m_dropped{0};
+
+  // Server thread state
+  std::vector<QObject *> m_servers;
+  std::vector<std::unique_ptr<Subscriber>> m_subscribers;
+  std::vector<PowerData> m_batch;
+  std::string m_encoded;
+};
+
+#endif // STREAMSERVER_H
@@ -0,0 +1,365 @@
+// Pretends to be a PLD20/PLD28 serial meter on a pseudo-terminal, so the
+// whole acquisition pipeline can be load-tested without hardware:
+//
+//   usb-power-pty-meter --link /tmp/usb-power-meter --rate 5000 &
+//   usb-power-osd --headless --device /tmp/usb-power-meter
+//
+// Lines are paced to the requested rate, capped at what the baud rate
+// could carry, and can carry noise, garbage lines, bursts, current steps
+// and periodic disconnects. When the reader falls behind, the pty buffer
+// fills up and lines are dropped like on a real UART. Events (steps,
+// disconnects) go to --log as CSV with wall-clock microseconds, the time
+// base of the application's sample timestamps, for latency measurements.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <random>
+#include <stdlib.h>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+// Bytes on the wire per byte of data: start, 8 data and stop bit
+constexpr double kBitsPerByte = 10.0;
+// Pacing granularity for rates where every line would be its own write
+constexpr auto kMinTick = std::chrono::microseconds(200);
+
+volatile std::sig_atomic_t quitRequested = 0;
+
+void requestQuit(int) { quitRequested = 1; }
+
+struct Options {
+  bool pld20 = false;
+  double rate = 1000.0;
+  double baud = 115200.0;
+  double voltage = 20.0;
+  double current = 1.5;
+  double noise = 0.0;
+  double stepMs = 0.0;
+  double stepCurrent = 0.0;
+  double garbage = 0.0;
+  int burst = 1;
+  double disconnectEvery = 0.0;
+  double disconnectFor = 1.0;
+  double duration = 0.0;
+  std::string link;
+  std::string log;
+};
+
+std::uint64_t wallMicros() {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
+
+// A line as the meter sends it: signed shunt voltage and bus voltage as
+// four hex digits each, PLD28 followed by its protocol byte. The inverse
+// of SerialDecoder::decodeLine.
+std::string meterLine(const Options &options, double volts, double amps) {
+  const double currentQuanta = options.pld20 ? 0.06 : 0.2;
+  const double voltageQuanta = options.pld20 ? 4.0 / 8.0 : 3.125;
+  const long shunt = std::lround(std::clamp(amps * 1000.0 / currentQuanta, 0.0, 32767.0));
+  // SerialDecoder reads the bus voltage as signed 16 bit, which limits
+  // PLD20 to about 16 V
+  const long bus = std::lround(std::clamp(volts * 1000.0 / voltageQuanta, 0.0, 32767.0));
+  char line[16];
+  std::snprintf(line, sizeof(line), options.pld20 ? "%04lX%04lX\r\n" : "%04lX%04lX\x1c\r\n",
+                shunt, bus);
+  return line;
+}
+
+std::string garbageLine(std::mt19937 &rng) {
+  std::uniform_int_distribution<int> length(1, 20);
+  std::uniform_int_distribution<int> printable(0x21, 0x7e);
+  std::string line(static_cast<std::size_t>(length(rng)), ' ');
+  for (char &c : line) {
+    c = static_cast<char>(printable(rng));
+  }
+  return line + "\r\n";
+}
+
+// A new pseudo-terminal pair with the slave in raw mode; returns the
+// non-blocking master, or -1
+int openPty(const Options &options, std::string &slavePath) {
+  const int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    std::perror("posix_openpt");
+    if (master >= 0) {
+      close(master);
+    }
+    return -1;
+  }
+  slavePath = ptsname(master);
+  // No echo or line editing until the application opens and configures it
+  const int slave = open(slavePath.c_str(), O_RDWR | O_NOCTTY);
+  if (slave >= 0) {
+    termios tio{};
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    close(slave);
+  }
+  if (!options.link.empty()) {
+    unlink(options.link.c_str());
+    if (symlink(slavePath.c_str(), options.link.c_str()) != 0) {
+      std::perror(options.link.c_str());
+    }
+  }
+  return master;
+}
+
+// Without an open slave the master reports a hangup; nobody would read
+// what is written
+bool readerAttached(int master) {
+  pollfd fd{master, POLLOUT, 0};
+  return poll(&fd, 1, 0) >= 0 && !(fd.revents & POLLHUP);
+}
+
+void usage(const char *program) {
+  std::fprintf(
+      stderr,
+      "usage: %s [options]\n"
+      "  --protocol PLD28|PLD20    line format (default PLD28)\n"
+      "  --rate <lines/s>          0 for as fast as the baud rate allows (default 1000)\n"
+      "  --baud <bits/s>           caps the rate, 0 for no cap (default 115200)\n"
+      "  --voltage <V>, --current <A>  the reading (default 20 V, 1.5 A)\n"
+      "  --noise <A>               standard deviation added to the current\n"
+      "  --step-ms <ms> --step-current <A>  alternate with this current\n"
+      "  --garbage <0..1>          fraction of lines replaced by garbage\n"
+      "  --burst <lines>           lines written at once (default 1)\n"
+      "  --disconnect-every <s> [--disconnect-for <s>]  hang up periodically\n"
+      "  --duration <s>            stop after this long\n"
+      "  --link <path>             symlink to the current pty, kept across disconnects\n"
+      "  --log <file>              CSV of steps and disconnects\n",
+      program);
+}
+
+bool parse(int argc, char *argv[], Options &options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char *value = argv[++i];
+    if (arg == "--protocol") {
+      if (std::strcmp(value, "PLD20") != 0 && std::strcmp(value, "PLD28") != 0) {
+        return false;
+      }
+      options.pld20 = std::strcmp(value, "PLD20") == 0;
+    } else if (arg == "--rate") {
+      options.rate = std::atof(value);
+    } else if (arg == "--baud") {
+      options.baud = std::atof(value);
+    } else if (arg == "--voltage") {
+      options.voltage = std::atof(value);
+    } else if (arg == "--current") {
+      options.current = std::atof(value);
+    } else if (arg == "--noise") {
+      options.noise = std::atof(value);
+    } else if (arg == "--step-ms") {
+      options.stepMs = std::atof(value);
+    } else if (arg == "--step-current") {
+      options.stepCurrent = std::atof(value);
+    } else if (arg == "--garbage") {
+      options.garbage = std::atof(value);
+    } else if (arg == "--burst") {
+      options.burst = std::max(1, std::atoi(value));
+    } else if (arg == "--disconnect-every") {
+      options.disconnectEvery = std::atof(value);
+    } else if (arg == "--disconnect-for") {
+      options.disconnectFor = std::atof(value);
+    } else if (arg == "--duration") {
+      options.duration = std::atof(value);
+    } else if (arg == "--link") {
+      options.link = value;
+    } else if (arg == "--log") {
+      options.log = value;
+    } else {
+      return false;
+    }
+  }
+  return options.rate >= 0.0 && options.baud >= 0.0 && (options.rate > 0.0 || options.baud > 0.0);
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parse(argc, argv, options)) {
+    usage(argv[0]);
+    return 2;
+  }
+  std::FILE *log = nullptr;
+  if (!options.log.empty()) {
+    log = std::fopen(options.log.c_str(), "w");
+    if (!log) {
+      std::perror(options.log.c_str());
+      return 1;
+    }
+    std::fprintf(log, "wall_us,event,value\n");
+  }
+
+  const std::size_t lineBytes = meterLine(options, options.voltage, options.current).size();
+  const double baudLimit = options.baud > 0.0
+                               ? options.baud / kBitsPerByte / static_cast<double>(lineBytes)
+                               : 0.0;
+  const double rate = options.rate <= 0.0   ? baudLimit
+                      : baudLimit <= 0.0    ? options.rate
+                                            : std::min(options.rate, baudLimit);
+  // Several lines per write when single lines would come too often
+  using Clock = std::chrono::steady_clock;
+  const auto lineInterval = std::chrono::duration<double>(1.0 / rate);
+  const int burst = std::max(
+      options.burst, static_cast<int>(std::ceil(std::chrono::duration<double>(kMinTick) /
+                                                lineInterval)));
+  const auto tick = std::chrono::duration_cast<Clock::duration>(lineInterval * burst);
+
+  std::signal(SIGINT, requestQuit);
+  std::signal(SIGTERM, requestQuit);
+  std::signal(SIGPIPE, SIG_IGN);
+
+  std::string slavePath;
+  int master = openPty(options, slavePath);
+  if (master < 0) {
+    return 1;
+  }
+  std::fprintf(stderr, "%s %s at %.0f lines/s%s, %d per write\n", slavePath.c_str(),
+               options.pld20 ? "PLD20" : "PLD28", rate,
+               rate < options.rate ? " (baud limit)" : "", burst);
+
+  std::mt19937 rng(std::random_device{}());
+  std::normal_distribution<double> noise(0.0, options.noise > 0.0 ? options.noise : 1.0);
+  std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+  const auto start = Clock::now();
+  auto next = start;
+  auto lastReport = start;
+  auto lastConnect = start;
+  bool stepped = false;
+  bool connected = true;
+  std::string pending;
+  unsigned long long written = 0;
+  unsigned long long dropped = 0;
+  unsigned long long garbage = 0;
+  unsigned long long writtenAtReport = 0;
+  char discard[256];
+
+  while (!quitRequested) {
+    std::this_thread::sleep_until(next);
+    next += tick;
+    const auto now = Clock::now();
+    // Catches up on short delays, but not after being suspended
+    if (now - next > std::chrono::milliseconds(100)) {
+      next = now;
+    }
+    const double elapsed = std::chrono::duration<double>(now - start).count();
+    if (options.duration > 0.0 && elapsed >= options.duration) {
+      break;
+    }
+    if (now - lastReport >= std::chrono::seconds(1)) {
+      const double seconds = std::chrono::duration<double>(now - lastReport).count();
+      std::fprintf(stderr, "%.0f lines/s, %llu written, %llu dropped, %llu garbage\n",
+                   static_cast<double>(written - writtenAtReport) / seconds, written, dropped,
+                   garbage);
+      if (log) {
+        std::fflush(log);
+      }
+      lastReport = now;
+      writtenAtReport = written;
+    }
+
+    // Hang up, then come back on a new pty after disconnectFor
+    const double sinceConnect = std::chrono::duration<double>(now - lastConnect).count();
+    if (options.disconnectEvery > 0.0 && connected && sinceConnect >= options.disconnectEvery) {
+      close(master);
+      master = -1;
+      connected = false;
+      pending.clear();
+      if (log) {
+        std::fprintf(log, "%llu,disconnect,\n", static_cast<unsigned long long>(wallMicros()));
+      }
+      std::fprintf(stderr, "disconnected\n");
+    }
+    if (!connected) {
+      if (sinceConnect < options.disconnectEvery + options.disconnectFor) {
+        continue;
+      }
+      master = openPty(options, slavePath);
+      if (master < 0) {
+        return 1;
+      }
+      connected = true;
+      lastConnect = now;
+      if (log) {
+        std::fprintf(log, "%llu,connect,%s\n", static_cast<unsigned long long>(wallMicros()),
+                     slavePath.c_str());
+      }
+      std::fprintf(stderr, "connected on %s\n", slavePath.c_str());
+    }
+
+    // Whatever the application writes is ignored
+    while (read(master, discard, sizeof(discard)) > 0) {
+    }
+
+    double amps = options.current;
+    if (options.stepMs > 0.0) {
+      const bool high = static_cast<long long>(elapsed * 1000.0 / options.stepMs) % 2 == 1;
+      if (high != stepped) {
+        stepped = high;
+        if (log) {
+          std::fprintf(log, "%llu,step,%.4f\n", static_cast<unsigned long long>(wallMicros()),
+                       high ? options.stepCurrent : options.current);
+        }
+      }
+      amps = stepped ? options.stepCurrent : options.current;
+    }
+
+    if (!readerAttached(master)) {
+      continue;
+    }
+    if (pending.empty()) {
+      for (int i = 0; i < burst; ++i) {
+        if (options.garbage > 0.0 && chance(rng) < options.garbage) {
+          pending += garbageLine(rng);
+          ++garbage;
+        } else {
+          pending += meterLine(options, options.voltage,
+                               amps + (options.noise > 0.0 ? noise(rng) : 0.0));
+        }
+      }
+    } else {
+      // The reader did not take the previous lines; a meter does not wait
+      dropped += static_cast<unsigned long long>(burst);
+    }
+    const ssize_t n = write(master, pending.data(), pending.size());
+    if (n > 0) {
+      pending.erase(0, static_cast<std::size_t>(n));
+      if (pending.empty()) {
+        written += static_cast<unsigned long long>(burst);
+      }
+    }
+
+  }
+
+  if (master >= 0) {
+    close(master);
+  }
+  if (!options.link.empty()) {
+    unlink(options.link.c_str());
+  }
+  if (log) {
+    std::fclose(log);
+  }
+  std::fprintf(stderr, "%llu lines written, %llu dropped, %llu garbage\n", written, dropped,
+               garbage);
+  return 0;
+}